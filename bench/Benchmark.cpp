@@ -0,0 +1,258 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Mede as consultas só de leitura na árvore de ponteiros e na árvore congelada.
+ *
+ * Uso: benchmark [profundidade] [ramificacao] [ficheiros_por_diretoria] [repeticoes] [elementos_kernels] [copias] [pasta_espelho]
+ *
+ * O espelho no disco é medido em pasta_espelho (por omissão /dev/shm, um tmpfs);
+ * para medir reflinks indique uma pasta num btrfs/xfs (por exemplo um loop device).
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <functional>
+#include <streambuf>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include "../src/Directory.hpp"
+#include "../src/SistemaFicheiros.hpp"
+#include "../src/FlatTree.hpp"
+#include "../src/Kernels.hpp"
+#include "../src/Espelho.hpp"
+#include <filesystem>
+#include <fstream>
+
+// Streambuf que descarta tudo (para medir o "tree" sem custo de consola).
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Árvore sintética simples e determinística.
+static void buildTree(Directory& dir, int depth, int fanout, int filesPerDir, unsigned& seed) {
+    for (int i = 0; i < filesPerDir; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        dir.addFile("f" + std::to_string(seed % 997) + ".dat", (seed >> 8) % 1000000);
+    }
+    if (depth == 0) return;
+    for (int i = 0; i < fanout; ++i) {
+        dir.addSubdirectory("d" + std::to_string(i));
+        buildTree(*dir.getSubdirectories().back(), depth - 1, fanout, filesPerDir, seed);
+    }
+}
+
+// Corre fn `reps` vezes e devolve o tempo médio em milissegundos.
+static double timeIt(int reps, const std::function<void()>& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; ++i) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+}
+
+// Débito (GB/s) das reduções sobre colunas de tamanhos/datas, para cada conjunto de instruções suportado.
+static void benchKernels(size_t n, int reps) {
+    std::vector<uint64_t> sizes(n);
+    std::vector<int32_t> dates(n);
+    uint64_t seed = 7;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        sizes[i] = (seed >> 20) % (1ull << 32);
+        dates[i] = 19900101 + static_cast<int32_t>((seed >> 40) % 360000);
+    }
+    const uint64_t bounds[] = { 1024ull, 1024ull * 1024, 100ull * 1024 * 1024, 1024ull * 1024 * 1024 };
+    uint64_t counts[5];
+    volatile uint64_t sink = 0;
+
+    std::cout << "\nKernels sobre " << n << " elementos (GB/s)\n";
+    std::cout << std::left << std::setw(10) << "isa" << std::right << std::setw(10) << "sum"
+              << std::setw(10) << "max" << std::setw(11) << "histogram" << std::setw(12) << "rangeCount" << "\n";
+    kernels::Isa best = kernels::detectIsa();
+    for (kernels::Isa isa : { kernels::Isa::Scalar, kernels::Isa::AVX2, kernels::Isa::AVX512 }) {
+        if (!kernels::setIsa(isa)) continue;
+        double gb64 = n * sizeof(uint64_t) / 1e9;
+        double gb32 = n * sizeof(int32_t) / 1e9;
+        double tSum = timeIt(reps, [&] { sink = sink + kernels::sum(sizes.data(), n); });
+        double tMax = timeIt(reps, [&] { sink = sink + kernels::maxIndex(sizes.data(), n).index; });
+        double tHist = timeIt(reps, [&] { kernels::histogram(sizes.data(), n, bounds, 4, counts); sink = sink + counts[0]; });
+        double tRange = timeIt(reps, [&] { sink = sink + kernels::rangeCount(dates.data(), n, 20000101, 20101231); });
+        std::cout << std::left << std::setw(10) << kernels::isaName(isa) << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << gb64 / (tSum / 1e3) << std::setw(10) << gb64 / (tMax / 1e3)
+                  << std::setw(11) << gb64 / (tHist / 1e3) << std::setw(12) << gb32 / (tRange / 1e3) << "\n";
+    }
+    kernels::setIsa(best);
+}
+
+// Leitores concorrentes sobre versões fixadas enquanto a thread principal altera e republica a árvore.
+static void benchSnapshots(const std::shared_ptr<Directory>& root, SistemaFicheiros& sf, int readers, int publishes) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> queries{0};
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            size_t local = 0, sinkLocal = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto pin = sf.Snapshot();
+                if (!pin) continue;
+                sinkLocal += SistemaFicheiros::Duplicados(*pin, '/').size() + pin->totalSize();
+                ++local;
+            }
+            queries.fetch_add(local + (sinkLocal == SIZE_MAX));
+        });
+    }
+    size_t maxRetained = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < publishes; ++i) {
+        root->addFile("novo" + std::to_string(i) + ".dat", static_cast<size_t>(i));
+        sf.Congelar();
+        maxRetained = std::max(maxRetained, sf.VersoesRetidas());
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    stop = true;
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "\nSnapshots: " << readers << " leitores, " << publishes << " publicacoes em "
+              << std::fixed << std::setprecision(3) << secs << " s\n";
+    std::cout << "  publicacoes/s: " << std::setprecision(1) << publishes / secs
+              << "  consultas/s (duplicados + total): " << queries.load() / secs
+              << "  max. versoes retidas: " << maxRetained << "\n";
+}
+
+// CopyBatch de n ficheiros com o mesmo nome: cada cópia recebe o próximo sufixo _NNN livre.
+static void benchCopyBatch(size_t n) {
+    auto root = std::make_shared<Directory>("/");
+    root->addSubdirectory("origem");
+    root->addSubdirectory("destino");
+    Directory& origem = *root->getSubdirectories()[0];
+    for (size_t i = 0; i < n; ++i) origem.addFile("a.txt", i);
+    root->getSubdirectories()[1]->addFile("a.txt", 0);
+
+    SistemaFicheiros sf;
+    sf.SetRoot(root);
+    double ms = timeIt(1, [&] { sf.CopyBatch("a.txt", "origem", "destino"); });
+    std::cout << "\nCopyBatch: " << n << " ficheiros com o mesmo nome em " << std::fixed
+              << std::setprecision(3) << ms << " ms (" << std::setprecision(1)
+              << (ms > 0 ? n / ms * 1000.0 : 0.0) << " ficheiros/s)\n";
+}
+
+// Cópia da árvore inteira: só as diretorias são copiadas, as listas de ficheiros ficam partilhadas.
+static void benchCpDir(const std::shared_ptr<Directory>& root) {
+    std::shared_ptr<Directory> copia;
+    double ms = timeIt(1, [&] { copia = root->clone(); });
+    std::cout << "\ncpdir: " << copia->getTotalDirectories() << " diretorias, " << copia->getTotalFiles()
+              << " ficheiros em " << std::fixed << std::setprecision(3) << ms << " ms\n";
+}
+
+// Débito do espelho no disco: n ficheiros de `tamanho` bytes copiados com 1 e com várias threads, e depois movidos.
+static void benchEspelho(const std::string& pasta, size_t n, size_t tamanho) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path base = fs::path(pasta) / "gestor_bench_espelho";
+    fs::remove_all(base, ec);
+    if (!fs::create_directories(base / "origem", ec)) {
+        std::cout << "\nEspelho: nao foi possivel criar " << base.string() << "\n";
+        return;
+    }
+    std::string bloco(tamanho, '\0');
+    for (size_t i = 0; i < tamanho; ++i) bloco[i] = static_cast<char>(i * 131 + 7);
+    for (size_t i = 0; i < n; ++i) {
+        std::ofstream f(base / "origem" / ("f" + std::to_string(i) + ".bin"), std::ios::binary);
+        f.write(bloco.data(), static_cast<std::streamsize>(bloco.size()));
+    }
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\nEspelho em " << pasta << ": " << n << " ficheiros de " << tamanho << " bytes\n";
+    for (size_t threads : { size_t(1), size_t(std::max(4u, hw)) }) {
+        std::string destino = "copia" + std::to_string(threads);
+        fs::create_directory(base / destino, ec);
+        std::vector<Espelho::Operacao> plano;
+        for (size_t i = 0; i < n; ++i) {
+            std::string nome = "f" + std::to_string(i) + ".bin";
+            plano.push_back({Espelho::Operacao::CopiarFicheiro, (base / "origem" / nome).string(),
+                             (base / destino / nome).string(), tamanho});
+        }
+        Espelho::Resultado r = Espelho::executar(plano, threads);
+        std::cout << "  copiar, " << threads << " thread(s): " << std::fixed << std::setprecision(1)
+                  << (r.segundos > 0 ? r.bytes / r.segundos / 1e6 : 0.0) << " MB/s  (reflink " << r.reflinks
+                  << ", copy_file_range " << r.copiasKernel << ", read/write " << r.copiasBuffer
+                  << ", falhadas " << r.falhadas << ")\n";
+    }
+
+    std::vector<Espelho::Operacao> movimentos;
+    fs::create_directory(base / "movidos", ec);
+    for (size_t i = 0; i < n; ++i) {
+        std::string nome = "f" + std::to_string(i) + ".bin";
+        movimentos.push_back({Espelho::Operacao::Mover, (base / "copia1" / nome).string(),
+                              (base / "movidos" / nome).string(), tamanho});
+    }
+    Espelho::Resultado r = Espelho::executar(movimentos, hw);
+    std::cout << "  mover: " << std::setprecision(1) << (r.segundos > 0 ? r.feitas / r.segundos : 0.0)
+              << " operacoes/s  (falhadas " << r.falhadas << ")\n";
+    fs::remove_all(base, ec);
+}
+
+int main(int argc, char** argv) {
+    int depth = argc > 1 ? std::stoi(argv[1]) : 5;
+    int fanout = argc > 2 ? std::stoi(argv[2]) : 8;
+    int filesPerDir = argc > 3 ? std::stoi(argv[3]) : 10;
+    int reps = argc > 4 ? std::stoi(argv[4]) : 5;
+    size_t kernelElems = argc > 5 ? std::stoull(argv[5]) : (size_t(1) << 23);
+    size_t copias = argc > 6 ? std::stoull(argv[6]) : 100000;
+    std::string pastaEspelho = argc > 7 ? argv[7]
+        : (std::filesystem::is_directory("/dev/shm") ? "/dev/shm" : std::filesystem::temp_directory_path().string());
+
+    auto root = std::make_shared<Directory>("/");
+    unsigned seed = 42;
+    buildTree(*root, depth, fanout, filesPerDir, seed);
+
+    SistemaFicheiros sf;
+    sf.SetRoot(root);
+    NullBuffer nb;
+    std::ostream nullOut(&nb);
+
+    std::cout << "Arvore: " << sf.ContarDirectorios() << " diretorias, " << sf.ContarFicheiros() << " ficheiros\n";
+    double freezeMs = timeIt(1, [&] { sf.Congelar(); });
+    std::cout << "freeze: " << std::fixed << std::setprecision(3) << freezeMs << " ms\n\n";
+
+    struct Cenario { const char* nome; std::function<void()> fn; };
+    volatile size_t sink = 0;
+    Cenario cenarios[] = {
+        { "Memoria",              [&] { sink = sink + sf.Memoria(); } },
+        { "ContarFicheiros",      [&] { sink = sink + sf.ContarFicheiros(); } },
+        { "ContarDirectorios",    [&] { sink = sink + sf.ContarDirectorios(); } },
+        { "FicheiroMaior",        [&] { sink = sink + sf.FicheiroMaior()->size(); } },
+        { "DirectoriaMaisEspaco", [&] { sink = sink + sf.DirectoriaMaisEspaco()->size(); } },
+        { "Search (sem match)",   [&] { sink = sink + sf.Search("inexistente", 0).has_value(); } },
+        { "PesquisarAllFicheiros",[&] { std::list<std::string> l; sf.PesquisarAllFicheiros(l, "f1.dat"); sink = sink + l.size(); } },
+        { "Tree",                 [&] {
+            if (const FlatTree* ft = sf.frozenView()) ft->generateTree(nullOut);
+            else root->generateTree(nullOut, "");
+        } },
+    };
+
+    std::cout << std::left << std::setw(24) << "cenario" << std::right
+              << std::setw(14) << "ponteiros ms" << std::setw(14) << "congelada ms" << std::setw(10) << "ganho" << "\n";
+    for (const auto& c : cenarios) {
+        sf.Descongelar();
+        double ptr = timeIt(reps, c.fn);
+        sf.Congelar();
+        double flat = timeIt(reps, c.fn);
+        std::cout << std::left << std::setw(24) << c.nome << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(14) << ptr << std::setw(14) << flat
+                  << std::setw(9) << std::setprecision(1) << (flat > 0 ? ptr / flat : 0.0) << "x\n";
+    }
+
+    benchKernels(kernelElems, reps);
+    // Um leitor por núcleo livre (a thread principal é o escritor).
+    unsigned hw = std::thread::hardware_concurrency();
+    benchSnapshots(root, sf, hw > 1 ? static_cast<int>(hw - 1) : 1, 4 * reps);
+    benchCopyBatch(copias);
+    benchCpDir(root);
+    benchEspelho(pastaEspelho, 64, size_t(1) << 20);
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "GeradorArvore.hpp"
+#include "../src/File.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// splitmix64: pequeno, rápido e igual em todas as plataformas.
+class Aleatorio {
+public:
+    explicit Aleatorio(uint64_t semente) : estado(semente) {}
+    uint64_t proximo() {
+        uint64_t z = (estado += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    /** Inteiro em [0, n). */
+    uint64_t abaixo(uint64_t n) { return n ? proximo() % n : 0; }
+    /** Real em [0, 1). */
+    double uniforme() { return static_cast<double>(proximo() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t estado;
+};
+
+void misturar(uint64_t& h, const void* p, size_t n) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 0x100000001B3ull; }
+}
+
+void misturar(uint64_t& h, uint64_t v) { misturar(h, &v, sizeof(v)); }
+
+// Data no formato de asctime ("Wed Jun 30 21:49:08 1993"), em UTC, sem depender do fuso local.
+std::string formatarData(int64_t t) {
+    static const char* dias[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char* meses[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    int64_t dia = t / 86400, seg = t % 86400;
+    // Dias desde 1970-01-01 para ano/mês/dia (calendário gregoriano proléptico).
+    int64_t z = dia + 719468;
+    int64_t era = z / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    int y = static_cast<int>(yoe + era * 400 + (m <= 2));
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.3s %.3s%3d %.2d:%.2d:%.2d %d",
+                  dias[(dia + 4) % 7], meses[m - 1], d,
+                  static_cast<int>(seg / 3600), static_cast<int>(seg / 60 % 60), static_cast<int>(seg % 60), y);
+    return buf;
+}
+
+// Destino em memória: nós são Directory* (os shared_ptr ficam nos pais).
+struct NaMemoria {
+    using No = Directory*;
+    std::shared_ptr<Directory> raizPtr;
+    bool falhou = false;
+
+    No raiz() {
+        raizPtr = std::make_shared<Directory>("/");
+        return raizPtr.get();
+    }
+    No diretoria(const No& pai, const std::string& nome) {
+        pai->addSubdirectory(nome);
+        return pai->getSubdirectories().back().get();
+    }
+    void ficheiro(const No& dir, const std::string& nome, uint64_t tamanho, int64_t, const std::string& data) {
+        dir->addFilePtr(std::make_shared<File>(nome, static_cast<size_t>(tamanho), data));
+    }
+};
+
+// Destino no disco: nós são caminhos; ficheiros esparsos com a data gerada.
+struct NoDisco {
+    using No = fs::path;
+    fs::path pasta;
+    bool falhou = false;
+    std::string erro;
+
+    void falha(const fs::path& p, const std::error_code& ec) {
+        if (falhou) return;
+        falhou = true;
+        erro = p.string() + ": " + ec.message();
+    }
+    No raiz() {
+        std::error_code ec;
+        if (!fs::create_directory(pasta, ec)) falha(pasta, ec ? ec : std::make_error_code(std::errc::file_exists));
+        return pasta;
+    }
+    No diretoria(const No& pai, const std::string& nome) {
+        fs::path p = pai / nome;
+        if (falhou) return p;
+        std::error_code ec;
+        if (!fs::create_directory(p, ec)) falha(p, ec ? ec : std::make_error_code(std::errc::file_exists));
+        return p;
+    }
+    void ficheiro(const No& dir, const std::string& nome, uint64_t tamanho, int64_t epoch, const std::string&) {
+        if (falhou) return;
+        fs::path p = dir / nome;
+        std::error_code ec;
+        {
+            std::ofstream f(p, std::ios::binary);
+            // Em tmpfs o limite costuma ser o número de inodes (ENOSPC), não o espaço.
+            if (!f) { falha(p, std::error_code(errno, std::generic_category())); return; }
+        }
+        fs::resize_file(p, tamanho, ec);
+        if (ec) { falha(p, ec); return; }
+        auto quando = fs::file_time_type::clock::now() + std::chrono::duration_cast<fs::file_time_type::duration>(
+            std::chrono::system_clock::from_time_t(static_cast<std::time_t>(epoch)) - std::chrono::system_clock::now());
+        fs::last_write_time(p, quando, ec);
+    }
+};
+
+} // namespace
+
+// ----------------------------------------
+// Tamanhos
+bool GeradorArvore::Tamanhos::ler(const std::string& s, Tamanhos& out) {
+    size_t p1 = s.find(':');
+    std::string tipo = s.substr(0, p1);
+    Tamanhos t;
+    try {
+        if (p1 == std::string::npos) return false;
+        size_t p2 = s.find(':', p1 + 1);
+        t.a = std::stod(s.substr(p1 + 1, p2 == std::string::npos ? std::string::npos : p2 - p1 - 1));
+        if (p2 != std::string::npos) t.b = std::stod(s.substr(p2 + 1));
+        else if (tipo != "fixo") return false;
+    } catch (...) {
+        return false;
+    }
+    if (tipo == "fixo") t.tipo = Fixo;
+    else if (tipo == "uniforme") t.tipo = Uniforme;
+    else if (tipo == "lognormal") t.tipo = LogNormal;
+    else if (tipo == "pareto") t.tipo = Pareto;
+    else return false;
+    if (t.a < 0 || (t.tipo == Uniforme && t.b < t.a) || (t.tipo == Pareto && (t.a <= 0 || t.b <= 0))) return false;
+    out = t;
+    return true;
+}
+
+std::string GeradorArvore::Tamanhos::texto() const {
+    static const char* nomes[] = { "fixo", "uniforme", "lognormal", "pareto" };
+    char buf[96];
+    if (tipo == Fixo) std::snprintf(buf, sizeof(buf), "fixo:%.0f", a);
+    else std::snprintf(buf, sizeof(buf), "%s:%g:%g", nomes[tipo], a, b);
+    return buf;
+}
+
+// ----------------------------------------
+// Gerador
+GeradorArvore::GeradorArvore(const Parametros& p) : par(p) {
+    if (par.nos == 0) par.nos = 1;
+    if (par.ramificacao < 1) par.ramificacao = 1;
+    if (par.profundidade < 0) par.profundidade = 0;
+    if (par.ficheirosPorDiretoria < 0) par.ficheirosPorDiretoria = 0;
+}
+
+std::string GeradorArvore::nomeFicheiro(uint64_t posicao) const {
+    // Sílabas em base 15: nomes distintos para posições distintas.
+    static const char* silabas[] = { "ba", "ce", "di", "fo", "gu", "la", "me", "ni",
+                                     "po", "ru", "sa", "te", "vi", "xo", "za" };
+    static const char* extensoes[] = { ".txt", ".dat", ".jpg", ".cpp", ".hpp", ".pdf", ".xml", ".log" };
+    std::string s;
+    uint64_t x = posicao;
+    do { s += silabas[x % 15]; x /= 15; } while (x);
+    if (s.size() < 4) s += "ro"; // "ro" não é sílaba, por isso não colide com nomes de duas sílabas.
+    return s + extensoes[posicao % 8];
+}
+
+std::shared_ptr<Directory> GeradorArvore::gerar() {
+    NaMemoria destino;
+    construir(destino);
+    return destino.raizPtr;
+}
+
+bool GeradorArvore::gerarNoDisco(const std::string& pasta, std::string& erro) {
+    NoDisco destino;
+    destino.pasta = pasta;
+    construir(destino);
+    erro = destino.erro;
+    return !destino.falhou;
+}
+
+template <typename Destino>
+void GeradorArvore::construir(Destino& destino) {
+    // Sem "bin" nem "build": Load ignora essas pastas e deixaria de ler a árvore inteira.
+    static const char* nomesDiretorias[] = { "src", "docs", "lib", "data", "img", "scripts",
+                                             "test", "tmp", "assets", "include", "cache", "res" };
+    // Datas entre 2000-01-01 e 2025-01-01.
+    const int64_t dataMin = 946684800, dataIntervalo = 1735689600 - 946684800;
+
+    Aleatorio rng(par.semente);
+    res = Resumo{};
+    res.impressao = 0xCBF29CE484222325ull;
+
+    // 1) Diretorias em largura até ao número pretendido (ou até à profundidade máxima).
+    const uint64_t alvoDirs = std::max<uint64_t>(1,
+        static_cast<uint64_t>(std::llround(par.nos / (1.0 + par.ficheirosPorDiretoria))));
+    std::vector<typename Destino::No> dirs;
+    std::vector<int> profundidades;
+    dirs.push_back(destino.raiz());
+    profundidades.push_back(0);
+    std::vector<std::string> usados;
+    for (size_t cab = 0; cab < dirs.size() && dirs.size() < alvoDirs && !destino.falhou; ++cab) {
+        if (profundidades[cab] >= par.profundidade) break; // Em largura: as seguintes são tão fundas ou mais.
+        uint64_t k = 1 + rng.abaixo(2 * static_cast<uint64_t>(par.ramificacao) - 1);
+        k = std::min<uint64_t>(k, alvoDirs - dirs.size());
+        usados.clear();
+        for (uint64_t i = 0; i < k; ++i) {
+            std::string nome = nomesDiretorias[rng.abaixo(12)];
+            if (std::find(usados.begin(), usados.end(), nome) != usados.end()) nome += std::to_string(i);
+            usados.push_back(nome);
+            int p = profundidades[cab] + 1;
+            misturar(res.impressao, static_cast<uint64_t>(p));
+            misturar(res.impressao, nome.data(), nome.size());
+            // dirs pode realocar: copia o pai antes de acrescentar.
+            typename Destino::No pai = dirs[cab];
+            dirs.push_back(destino.diretoria(pai, nome));
+            profundidades.push_back(p);
+        }
+    }
+    res.diretorias = dirs.size();
+
+    // 2) Ficheiros repartidos ao acaso pelas diretorias.
+    const uint64_t totalFicheiros = par.nos > dirs.size() ? par.nos - dirs.size() : 0;
+    std::vector<uint32_t> porDiretoria(dirs.size(), 0);
+    for (uint64_t i = 0; i < totalFicheiros; ++i) porDiretoria[rng.abaixo(dirs.size())]++;
+
+    // Vocabulário com pesos de Zipf: 1 / (posição + 1)^skew.
+    uint64_t vocab = par.nomesDistintos ? par.nomesDistintos : std::max<uint64_t>(1, totalFicheiros / 8);
+    acumulada.assign(vocab, 0.0);
+    double soma = 0.0;
+    for (uint64_t k = 0; k < vocab; ++k) {
+        soma += 1.0 / std::pow(static_cast<double>(k + 1), par.skew);
+        acumulada[k] = soma;
+    }
+
+    auto sortearTamanho = [&]() -> uint64_t {
+        const Tamanhos& t = par.tamanhos;
+        double v = t.a;
+        switch (t.tipo) {
+            case Tamanhos::Fixo: break;
+            case Tamanhos::Uniforme: v = t.a + rng.uniforme() * (t.b - t.a); break;
+            case Tamanhos::LogNormal: {
+                // Box-Muller (u1 em (0, 1] para o logaritmo).
+                double u1 = 1.0 - rng.uniforme(), u2 = rng.uniforme();
+                double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+                v = t.a * std::exp(t.b * z);
+                break;
+            }
+            case Tamanhos::Pareto: v = t.a * std::pow(1.0 - rng.uniforme(), -1.0 / t.b); break;
+        }
+        // Limite de 1 TiB (e o tamanho de Memoria() é um int: a soma satura, não interessa aqui).
+        return static_cast<uint64_t>(std::min(v, 1099511627776.0));
+    };
+
+    std::unordered_set<uint64_t> nomesNaDiretoria;
+    for (size_t d = 0; d < dirs.size() && !destino.falhou; ++d) {
+        nomesNaDiretoria.clear();
+        uint64_t repetidos = 0;
+        for (uint32_t i = 0; i < porDiretoria[d]; ++i) {
+            uint64_t k = static_cast<uint64_t>(
+                std::upper_bound(acumulada.begin(), acumulada.end(), rng.uniforme() * soma) - acumulada.begin());
+            if (k >= vocab) k = vocab - 1;
+            std::string nome = nomeFicheiro(k);
+            if (!nomesNaDiretoria.insert(k).second) {
+                // O nome já existe nesta diretoria: sufixo "_N" (nunca aparece no vocabulário).
+                size_t ponto = nome.rfind('.');
+                nome.insert(ponto, "_" + std::to_string(++repetidos));
+            }
+            uint64_t tamanho = sortearTamanho();
+            int64_t epoch = dataMin + static_cast<int64_t>(rng.abaixo(static_cast<uint64_t>(dataIntervalo)));
+            misturar(res.impressao, static_cast<uint64_t>(d));
+            misturar(res.impressao, nome.data(), nome.size());
+            misturar(res.impressao, tamanho);
+            misturar(res.impressao, static_cast<uint64_t>(epoch));
+            destino.ficheiro(dirs[d], nome, tamanho, epoch, formatarData(epoch));
+            res.ficheiros++;
+            res.bytes += tamanho;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef GERADOR_ARVORE_HPP
+#define GERADOR_ARVORE_HPP
+
+/**
+ * @file GeradorArvore.hpp
+ * @brief Declara a classe GeradorArvore (árvores sintéticas determinísticas para benchmarks).
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/Directory.hpp"
+
+/**
+ * @class GeradorArvore
+ * @brief Gera sempre a mesma árvore para os mesmos parâmetros, em memória ou no disco.
+ *
+ * A forma é controlada pela profundidade máxima, pela ramificação média e pelo
+ * número médio de ficheiros por diretoria; o total de nós (diretorias + ficheiros)
+ * fica próximo de Parametros::nos. Os nomes dos ficheiros vêm de um vocabulário
+ * sorteado com uma lei de Zipf (skew 0 = uniforme; quanto maior, mais nomes
+ * repetidos) e os tamanhos seguem a distribuição indicada.
+ *
+ * Só usa o seu próprio gerador pseudo-aleatório (splitmix64) e aritmética
+ * explícita, por isso a árvore não depende da biblioteca padrão nem da máquina;
+ * a impressão digital do resumo permite confirmar isso entre execuções.
+ */
+class GeradorArvore {
+public:
+    /** @brief Distribuição dos tamanhos dos ficheiros. */
+    struct Tamanhos {
+        enum Tipo { Fixo, Uniforme, LogNormal, Pareto };
+        Tipo tipo = LogNormal;
+        double a = 16384.0; ///< Fixo: tamanho; Uniforme: mínimo; LogNormal: mediana; Pareto: mínimo.
+        double b = 2.0;     ///< Uniforme: máximo; LogNormal: sigma; Pareto: alfa.
+
+        /** @brief Lê "fixo:N", "uniforme:MIN:MAX", "lognormal:MEDIANA:SIGMA" ou "pareto:MIN:ALFA". */
+        static bool ler(const std::string& s, Tamanhos& out);
+        /** @brief Forma textual aceite por ler(). */
+        std::string texto() const;
+    };
+
+    /** @brief Parâmetros da árvore. */
+    struct Parametros {
+        uint64_t nos = 10000;               ///< Total aproximado de diretorias + ficheiros.
+        uint64_t semente = 42;
+        int profundidade = 8;               ///< Profundidade máxima (a raiz tem profundidade 0).
+        int ramificacao = 6;                ///< Subdiretorias por diretoria (média).
+        double ficheirosPorDiretoria = 12;  ///< Média de ficheiros por diretoria.
+        uint64_t nomesDistintos = 0;        ///< Vocabulário de nomes de ficheiro (0 = ficheiros / 8).
+        double skew = 1.0;                  ///< Expoente de Zipf na escolha dos nomes.
+        Tamanhos tamanhos;
+    };
+
+    /** @brief O que foi gerado. */
+    struct Resumo {
+        uint64_t diretorias = 0;
+        uint64_t ficheiros = 0;
+        uint64_t bytes = 0;
+        uint64_t impressao = 0; ///< FNV-1a de todos os nós, pela ordem de geração.
+    };
+
+    explicit GeradorArvore(const Parametros& p);
+
+    /** @brief Constrói a árvore em memória. */
+    std::shared_ptr<Directory> gerar();
+    /**
+     * @brief Cria a mesma árvore no disco, dentro de pasta (que não pode existir).
+     * @details Os ficheiros são esparsos (só o tamanho é definido) e recebem a data gerada.
+     */
+    bool gerarNoDisco(const std::string& pasta, std::string& erro);
+
+    /** @brief Resumo da última geração. */
+    const Resumo& resumo() const { return res; }
+    const Parametros& parametros() const { return par; }
+    /** @brief Nome de ficheiro com a posição dada no vocabulário (0 = o mais frequente). */
+    std::string nomeFicheiro(uint64_t posicao) const;
+    /** @brief Um dos nomes de diretoria sorteados (aparece em muitos sítios da árvore). */
+    static const char* nomeDiretoriaComum() { return "src"; }
+
+private:
+    template <typename Destino>
+    void construir(Destino& destino);
+
+    Parametros par;
+    Resumo res;
+    std::vector<double> acumulada; // Distribuição de Zipf acumulada do vocabulário.
+};
+
+#endif // GERADOR_ARVORE_HPP
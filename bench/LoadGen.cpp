@@ -0,0 +1,102 @@
+/**
+ * @file LoadGen.cpp
+ * @brief Gerador de carga para o daemon: vários clientes com pedidos em pipeline.
+ *
+ * Uso: loadgen <socket> [clientes] [pipeline] [segundos] [comando...]
+ *
+ * Cada cliente mantém `pipeline` pedidos em voo. A latência de um pedido vai
+ * do envio até à chegada da sua resposta. No fim mostra p50/p99/max e o débito total.
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include "../src/Protocolo.hpp"
+
+using Relogio = std::chrono::steady_clock;
+
+struct ResultadoCliente {
+    std::vector<double> latenciasUs;
+    size_t erros = 0;
+};
+
+static void correrCliente(const std::string& socketPath, size_t pipeline, Relogio::time_point fim,
+                          const std::vector<std::string>& comandos, size_t semente, ResultadoCliente& res) {
+    protocolo::Cliente c;
+    if (!c.ligar(socketPath)) { res.erros++; return; }
+    std::deque<Relogio::time_point> emVoo;
+    protocolo::Cliente::Resposta r;
+    size_t k = semente;
+    auto enviar = [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            c.enfileirar(comandos[k++ % comandos.size()]);
+            emVoo.push_back(Relogio::now());
+        }
+        return c.enviarPendentes();
+    };
+    if (!enviar(pipeline)) { res.erros++; return; }
+    while (!emVoo.empty()) {
+        if (!c.receber(r)) { res.erros++; return; }
+        auto agora = Relogio::now();
+        res.latenciasUs.push_back(std::chrono::duration<double, std::micro>(agora - emVoo.front()).count());
+        emVoo.pop_front();
+        if (r.estado != protocolo::Ok) res.erros++;
+        // Repõe o pedido que acabou enquanto houver tempo; depois só esvazia o pipeline.
+        if (agora < fim && !enviar(1)) { res.erros++; return; }
+    }
+}
+
+static double percentil(const std::vector<double>& v, double p) {
+    if (v.empty()) return 0.0;
+    size_t i = static_cast<size_t>(p * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Uso: loadgen <socket> [clientes] [pipeline] [segundos] [comando...]\n";
+        return 2;
+    }
+    std::string socketPath = argv[1];
+    size_t clientes = argc > 2 ? std::stoul(argv[2]) : 4;
+    size_t pipeline = argc > 3 ? std::stoul(argv[3]) : 16;
+    double segundos = argc > 4 ? std::stod(argv[4]) : 5.0;
+    std::vector<std::string> comandos;
+    for (int i = 5; i < argc; ++i) comandos.push_back(argv[i]);
+    if (comandos.empty()) {
+        // Mistura só de leitura por omissão, para não alterar a árvore servida.
+        comandos = { "contarficheiros", "memoria", "ficheiromaior", "search f1.dat 0", "size", "ls" };
+    }
+
+    std::vector<ResultadoCliente> resultados(clientes);
+    std::vector<std::thread> threads;
+    auto inicio = Relogio::now();
+    auto fim = inicio + std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(segundos));
+    for (size_t i = 0; i < clientes; ++i) {
+        threads.emplace_back(correrCliente, std::cref(socketPath), pipeline, fim, std::cref(comandos), i, std::ref(resultados[i]));
+    }
+    for (auto& t : threads) t.join();
+    double decorrido = std::chrono::duration<double>(Relogio::now() - inicio).count();
+
+    std::vector<double> todas;
+    size_t erros = 0;
+    for (auto& r : resultados) {
+        todas.insert(todas.end(), r.latenciasUs.begin(), r.latenciasUs.end());
+        erros += r.erros;
+    }
+    std::sort(todas.begin(), todas.end());
+
+    std::cout << "clientes: " << clientes << "  pipeline: " << pipeline << "  duracao: "
+              << std::fixed << std::setprecision(2) << decorrido << " s\n";
+    std::cout << "pedidos: " << todas.size() << "  erros: " << erros << "\n";
+    std::cout << "QPS: " << std::setprecision(0) << todas.size() / decorrido << "\n";
+    std::cout << std::setprecision(1) << "latencia (us)  p50: " << percentil(todas, 0.50)
+              << "  p99: " << percentil(todas, 0.99) << "  max: " << (todas.empty() ? 0.0 : todas.back()) << "\n";
+    return erros == 0 ? 0 : 1;
+}
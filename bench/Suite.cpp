@@ -0,0 +1,492 @@
+/**
+ * @file Suite.cpp
+ * @brief Conjunto reprodutível de cenários sobre árvores sintéticas, com resultados em JSON.
+ *
+ * Uso: suite [opções]
+ *   --nos 10000,1000000,10000000   tamanhos das árvores (diretorias + ficheiros)
+ *   --reps N                       repetições de cada cenário (por omissão 3)
+ *   --semente S --profundidade P --ramificacao R --ficheiros F
+ *   --nomes V --skew Z             vocabulário de nomes de ficheiro e expoente de Zipf
+ *   --tamanhos lognormal:16384:2   ou fixo:N, uniforme:MIN:MAX, pareto:MIN:ALFA
+ *   --pasta DIR                    onde ficam o XML e a árvore no disco (por omissão /dev/shm)
+ *   --disco-ate N                  só mede Load até N nós (a árvore no disco ocupa inodes)
+ *   --cenarios A,B,...             corre só estes cenários
+ *   --saida FICHEIRO               JSON para o ficheiro (por omissão para a saída padrão)
+ *   --gerar-xml FICHEIRO / --gerar-disco PASTA
+ *                                  só gera a primeira árvore de --nos e termina
+ *
+ * Os cenários que alteram a árvore (CopyBatch, RemoverAll) recebem uma árvore
+ * nova em cada repetição, gerada fora da medição. O progresso vai para stderr.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/Consulta.hpp"
+#include "../src/EscritorXml.hpp"
+#include "../src/Estimativa.hpp"
+#include "../src/Exportador.hpp"
+#include "../src/SistemaFicheiros.hpp"
+#include "GeradorArvore.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Opcoes {
+    std::vector<uint64_t> nos = { 10000, 1000000, 10000000 };
+    int reps = 3;
+    GeradorArvore::Parametros arvore;
+    std::string pasta;
+    uint64_t discoAte = 1000000;
+    std::vector<std::string> cenarios;
+    std::string saida;
+    std::string gerarXml, gerarDisco;
+};
+
+std::vector<std::string> separar(const std::string& s) {
+    std::vector<std::string> partes;
+    std::stringstream ss(s);
+    for (std::string p; std::getline(ss, p, ',');) if (!p.empty()) partes.push_back(p);
+    return partes;
+}
+
+bool lerOpcoes(int argc, char** argv, Opcoes& o) {
+    o.pasta = fs::is_directory("/dev/shm") ? "/dev/shm" : fs::temp_directory_path().string();
+    for (int i = 1; i < argc; ++i) {
+        std::string chave = argv[i];
+        if (i + 1 >= argc) { std::cerr << "Falta o valor de " << chave << "\n"; return false; }
+        std::string v = argv[++i];
+        try {
+            if (chave == "--nos") {
+                o.nos.clear();
+                for (const auto& p : separar(v)) o.nos.push_back(std::stoull(p));
+            }
+            else if (chave == "--reps") o.reps = std::max(1, std::stoi(v));
+            else if (chave == "--semente") o.arvore.semente = std::stoull(v);
+            else if (chave == "--profundidade") o.arvore.profundidade = std::stoi(v);
+            else if (chave == "--ramificacao") o.arvore.ramificacao = std::stoi(v);
+            else if (chave == "--ficheiros") o.arvore.ficheirosPorDiretoria = std::stod(v);
+            else if (chave == "--nomes") o.arvore.nomesDistintos = std::stoull(v);
+            else if (chave == "--skew") o.arvore.skew = std::stod(v);
+            else if (chave == "--tamanhos") {
+                if (!GeradorArvore::Tamanhos::ler(v, o.arvore.tamanhos)) {
+                    std::cerr << "Distribuicao de tamanhos invalida: " << v << "\n";
+                    return false;
+                }
+            }
+            else if (chave == "--pasta") o.pasta = v;
+            else if (chave == "--disco-ate") o.discoAte = std::stoull(v);
+            else if (chave == "--cenarios") o.cenarios = separar(v);
+            else if (chave == "--saida") o.saida = v;
+            else if (chave == "--gerar-xml") o.gerarXml = v;
+            else if (chave == "--gerar-disco") o.gerarDisco = v;
+            else { std::cerr << "Opcao desconhecida: " << chave << "\n"; return false; }
+        } catch (const std::exception&) {
+            std::cerr << "Valor invalido para " << chave << ": " << v << "\n";
+            return false;
+        }
+    }
+    if (o.nos.empty()) { std::cerr << "--nos sem valores\n"; return false; }
+    return true;
+}
+
+// ----------------------------------------
+// JSON (só o necessário: objetos, números e texto)
+std::string jsonTexto(const std::string& s) {
+    std::string r = "\"";
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': r += "\\\""; break;
+            case '\\': r += "\\\\"; break;
+            case '\n': r += "\\n"; break;
+            case '\t': r += "\\t"; break;
+            default:
+                if (c < 0x20) { char b[8]; std::snprintf(b, sizeof(b), "\\u%04x", c); r += b; }
+                else r += static_cast<char>(c);
+        }
+    }
+    return r + "\"";
+}
+
+std::string jsonNumero(double v) {
+    char b[32];
+    std::snprintf(b, sizeof(b), "%.4f", v);
+    return b;
+}
+
+// ----------------------------------------
+// Medição
+struct Medicao {
+    std::string nome;
+    std::vector<double> ms;   // Uma entrada por repetição, pela ordem.
+    std::string omitido;      // Motivo, se o cenário não correu.
+    std::string detalhe;      // Resultado da operação (para confirmar que fez o mesmo trabalho).
+};
+
+double agoraMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Corre fn `reps` vezes; preparar (se existir) corre antes de cada repetição, fora da medição.
+Medicao medir(const std::string& nome, int reps, const std::function<std::string()>& fn,
+              const std::function<void()>& preparar = nullptr) {
+    Medicao m;
+    m.nome = nome;
+    for (int r = 0; r < reps; ++r) {
+        if (preparar) preparar();
+        auto t0 = std::chrono::steady_clock::now();
+        m.detalhe = fn();
+        m.ms.push_back(agoraMs(t0));
+    }
+    return m;
+}
+
+std::string jsonMedicao(const Medicao& m) {
+    std::ostringstream os;
+    os << "{\"nome\": " << jsonTexto(m.nome);
+    if (!m.omitido.empty()) {
+        os << ", \"omitido\": " << jsonTexto(m.omitido) << "}";
+        return os.str();
+    }
+    std::vector<double> v = m.ms;
+    std::sort(v.begin(), v.end());
+    double soma = 0;
+    for (double x : v) soma += x;
+    double mediana = v.size() % 2 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+    os << ", \"reps\": " << v.size()
+       << ", \"primeira_ms\": " << jsonNumero(m.ms.front())
+       << ", \"min_ms\": " << jsonNumero(v.front())
+       << ", \"mediana_ms\": " << jsonNumero(mediana)
+       << ", \"media_ms\": " << jsonNumero(soma / v.size())
+       << ", \"max_ms\": " << jsonNumero(v.back())
+       << ", \"resultado\": " << jsonTexto(m.detalhe) << "}";
+    return os.str();
+}
+
+std::string dataUtc() {
+    std::time_t t = std::time(nullptr);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &t);
+#else
+    gmtime_r(&t, &utc);
+#endif
+    char b[32];
+    std::strftime(b, sizeof(b), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return b;
+}
+
+std::string compilador() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "desconhecido";
+#endif
+}
+
+// ----------------------------------------
+// Cenários de um tamanho
+class Execucao {
+public:
+    Execucao(const Opcoes& o, uint64_t nos) : op(o), par(o.arvore) { par.nos = nos; }
+
+    std::string correr() {
+        GeradorArvore gerador(par);
+        auto t0 = std::chrono::steady_clock::now();
+        std::shared_ptr<Directory> raiz = gerador.gerar();
+        double gerarMs = agoraMs(t0);
+        const GeradorArvore::Resumo& r = gerador.resumo();
+        std::cerr << "[" << par.nos << "] gerada: " << r.diretorias << " diretorias, " << r.ficheiros
+                  << " ficheiros em " << static_cast<long long>(gerarMs) << " ms\n";
+
+        // Nomes usados nas consultas: o mais frequente, um do meio do vocabulário e um inexistente.
+        const std::string frequente = gerador.nomeFicheiro(0);
+        const std::string raro = gerador.nomeFicheiro(std::max<uint64_t>(1, r.ficheiros / 16) - 1);
+        const std::string dirComum = GeradorArvore::nomeDiretoriaComum();
+        const std::string base = (fs::path(op.pasta) / ("gestor_suite_" + std::to_string(par.nos))).string();
+        const std::string xml = base + ".xml";
+
+        SistemaFicheiros sf;
+        sf.SetRoot(raiz);
+        raiz.reset();
+        auto novaArvore = [&] {
+            sf.clearSystem();
+            sf.SetRoot(gerador.gerar());
+        };
+
+        // Ler / escrever
+        if (quer("Escrever_XML")) adicionar(medir("Escrever_XML", op.reps, [&] {
+            sf.Escrever_XML(xml);
+            std::error_code ec;
+            return std::to_string(fs::file_size(xml, ec)) + " bytes";
+        }));
+        if (quer("EscritorXml")) {
+            // A mesma exportação com uma thread e com todas: mede o ganho da formatação em paralelo.
+            const Directory& arvore = *sf.GetRoot();
+            std::vector<size_t> threads{ 1 };
+            if (EscritorXml().threads() > 1) threads.push_back(EscritorXml().threads());
+            for (size_t n : threads) {
+                EscritorXml escritor(n);
+                adicionar(medir("EscritorXml (" + std::to_string(escritor.threads()) + " threads)", op.reps, [&] {
+                    bool ok = escritor.escrever(arvore, xml);
+                    std::error_code ec;
+                    return ok ? std::to_string(fs::file_size(xml, ec)) + " bytes, " + std::to_string(escritor.blocos()) + " blocos"
+                              : std::string("falhou");
+                }));
+            }
+        }
+        if (quer("Exportador")) {
+            // Exportação tabular da versão congelada, nos três formatos.
+            FlatTree ft(*sf.GetRoot());
+            const std::pair<const char*, Exportador::Formato> formatos[] = {
+                { "csv", Exportador::Csv }, { "jsonl", Exportador::JsonLinhas }, { "col", Exportador::Colunas } };
+            Exportador exportador;
+            for (const auto& f : formatos) {
+                adicionar(medir(std::string("Exportador (") + f.first + ")", op.reps, [&] {
+                    bool ok = exportador.escrever(ft, f.second, xml);
+                    std::error_code ec;
+                    return ok ? std::to_string(fs::file_size(xml, ec)) + " bytes, " + std::to_string(exportador.lotes()) + " lotes"
+                              : std::string("falhou");
+                }));
+            }
+        }
+        if (quer("Consulta")) {
+            // Pipeline de filtros sobre a versão congelada: índice de nomes, máscara de globs e colunas.
+            FlatTree ft(*sf.GetRoot());
+            const std::pair<const char*, std::string> consultas[] = {
+                { "nome exato", "name = \"" + raro + "\" | count" },
+                { "extensao e tamanho", "ext = log and size > 1M | sum" },
+                { "glob ou data", "(name = \"*ba*\" or date < 2000-01-01) and depth >= 3 | count" },
+                { "top 10", "| top 10" },
+            };
+            Consulta consulta;
+            for (const auto& c : consultas) {
+                std::string erro;
+                consulta.compilar(c.second, erro);
+                adicionar(medir(std::string("Consulta (") + c.first + ")", op.reps, [&] {
+                    Consulta::Resultado res;
+                    if (!consulta.executar(ft, nullptr, nullptr, res, erro)) return erro;
+                    return std::to_string(res.ficheiros) + " ficheiros, " + std::to_string(res.bytes) + " bytes";
+                }));
+            }
+        }
+        if (quer("Ler_XML")) {
+            if (!fs::exists(xml)) sf.Escrever_XML(xml);
+            adicionar(medir("Ler_XML", op.reps, [&] {
+                bool ok = sf.Ler_XML(xml);
+                return ok ? std::to_string(sf.ContarFicheiros()) + " ficheiros" : std::string("falhou");
+            }));
+        }
+        std::error_code ec;
+        fs::remove(xml, ec);
+        if (quer("Load") || quer("Estimativa") || quer("LoadCache")) medirLoad(gerador, base + "_disco", sf);
+
+        // Consultas (a árvore não é congelada: mede-se o caminho normal dos ponteiros)
+        novaArvore();
+        if (quer("Search")) {
+            adicionar(medir("Search (ficheiro raro)", op.reps, [&] { return sf.Search(raro, 0).value_or("-"); }));
+            adicionar(medir("Search (inexistente)", op.reps, [&] { return sf.Search("inexistente.none", 0).value_or("-"); }));
+            adicionar(medir("Search (diretoria)", op.reps, [&] { return sf.Search(dirComum, 1).value_or("-"); }));
+        }
+        if (quer("PesquisarAllDirectorias")) adicionar(medir("PesquisarAllDirectorias", op.reps, [&] {
+            std::list<std::string> l;
+            sf.PesquisarAllDirectorias(l, dirComum);
+            return std::to_string(l.size()) + " caminhos";
+        }));
+        if (quer("PesquisarAllFicheiros")) adicionar(medir("PesquisarAllFicheiros", op.reps, [&] {
+            std::list<std::string> l;
+            sf.PesquisarAllFicheiros(l, frequente);
+            return std::to_string(l.size()) + " caminhos";
+        }));
+        if (quer("DirectoriaMaisEspaco")) adicionar(medir("DirectoriaMaisEspaco", op.reps, [&] {
+            return sf.DirectoriaMaisEspaco().value_or("-");
+        }));
+        if (quer("GetFicheirosDuplicados")) adicionar(medir("GetFicheirosDuplicados", op.reps, [&] {
+            return std::to_string(sf.GetFicheirosDuplicados().size()) + " nomes";
+        }));
+
+        // Alterações: uma árvore nova por repetição
+        if (quer("CopyBatch")) {
+            // Os nomes com a sílaba "ba" (cerca de 1 em cada 7 do vocabulário), da primeira subdiretoria para a segunda.
+            std::string origem, destino;
+            adicionar(medir("CopyBatch", op.reps, [&] {
+                if (destino.empty()) return std::string("sem subdiretorias");
+                int antes = sf.ContarFicheiros();
+                sf.CopyBatch("ba", origem, destino);
+                return std::to_string(sf.ContarFicheiros() - antes) + " copias";
+            }, [&] {
+                novaArvore();
+                const auto& subs = sf.GetRoot()->getSubdirectories();
+                if (subs.size() >= 2) { origem = subs[0]->getName(); destino = subs[1]->getName(); }
+            }));
+        }
+        if (quer("RemoverAll")) {
+            adicionar(medir("RemoverAll (ficheiros)", op.reps, [&] {
+                int antes = sf.ContarFicheiros();
+                sf.RemoverAll(frequente, "FILE");
+                return std::to_string(antes - sf.ContarFicheiros()) + " removidos";
+            }, novaArvore));
+            adicionar(medir("RemoverAll (diretorias)", op.reps, [&] {
+                int antes = sf.ContarDirectorios();
+                sf.RemoverAll(dirComum, "DIR");
+                return std::to_string(antes - sf.ContarDirectorios()) + " removidas";
+            }, novaArvore));
+        }
+        sf.clearSystem();
+
+        char impressao[20];
+        std::snprintf(impressao, sizeof(impressao), "%016llx", static_cast<unsigned long long>(r.impressao));
+        std::ostringstream os;
+        os << "    {\"nos\": " << par.nos << ", \"diretorias\": " << r.diretorias
+           << ", \"ficheiros\": " << r.ficheiros << ", \"bytes\": " << r.bytes
+           << ", \"impressao\": \"" << impressao << "\", \"gerar_ms\": " << jsonNumero(gerarMs)
+           << ",\n     \"cenarios\": [\n";
+        for (size_t i = 0; i < medicoes.size(); ++i)
+            os << "      " << jsonMedicao(medicoes[i]) << (i + 1 < medicoes.size() ? ",\n" : "\n");
+        os << "     ]}";
+        return os.str();
+    }
+
+private:
+    bool quer(const std::string& nome) const {
+        return op.cenarios.empty() || std::find(op.cenarios.begin(), op.cenarios.end(), nome) != op.cenarios.end();
+    }
+
+    void adicionar(Medicao m) {
+        std::cerr << "[" << par.nos << "] " << m.nome;
+        if (m.omitido.empty()) std::cerr << ": " << static_cast<long long>(*std::min_element(m.ms.begin(), m.ms.end())) << " ms\n";
+        else std::cerr << ": omitido (" << m.omitido << ")\n";
+        medicoes.push_back(std::move(m));
+    }
+
+    // Load da árvore gerada no disco, o Load seguinte com a cache do anterior
+    // (lida e escrita como num arranque) e, sobre a mesma pasta, a estimativa
+    // por amostragem comparada com as contagens exatas do Load.
+    void medirLoad(GeradorArvore& gerador, const std::string& pasta, SistemaFicheiros& sf) {
+        Medicao m;
+        m.nome = "Load";
+        if (par.nos > op.discoAte) {
+            m.omitido = "acima de --disco-ate " + std::to_string(op.discoAte);
+            adicionar(std::move(m));
+            return;
+        }
+        std::error_code ec;
+        fs::remove_all(pasta, ec);
+        std::string erro;
+        if (!gerador.gerarNoDisco(pasta, erro)) {
+            m.omitido = "nao foi possivel criar a arvore no disco: " + erro;
+        } else {
+            m = medir("Load", op.reps, [&] {
+                bool ok = sf.Load(pasta);
+                return ok ? std::to_string(sf.ContarFicheiros()) + " ficheiros" : std::string("falhou");
+            });
+        }
+        bool temArvore = m.omitido.empty();
+        if (quer("Load")) adicionar(std::move(m));
+        if (quer("LoadCache") && temArvore) {
+            // As diretorias acabadas de criar só entram na cache depois da margem de segurança do mtime.
+            std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+            std::string ficheiro = pasta + ".cache";
+            CacheVarrimento inicial;
+            sf.Load(pasta, nullptr, &inicial);
+            inicial.escrever(ficheiro);
+            adicionar(medir("Load com cache", op.reps, [&] {
+                CacheVarrimento cache;
+                cache.ler(ficheiro);
+                SistemaFicheiros::Varrimento contas;
+                bool ok = sf.Load(pasta, &contas, &cache);
+                cache.escrever(ficheiro);
+                return ok ? std::to_string(contas.diretoriasReutilizadas) + " de " + std::to_string(contas.listagens) +
+                            " diretorias da cache" : std::string("falhou");
+            }));
+            fs::remove(ficheiro, ec);
+        }
+        if (quer("Estimativa") && temArvore) {
+            if (!quer("Load")) sf.Load(pasta); // contagens exatas para comparar
+            const double reais = sf.ContarFicheiros();
+            uint64_t semente = par.semente;
+            adicionar(medir("Estimativa (250 ms)", op.reps, [&] {
+                Estimativa e(pasta, sf.GetRegrasIgnorar(), ++semente);
+                e.amostrar(std::chrono::milliseconds(250));
+                Estimativa::Resultado r = e.resultado();
+                char b[160];
+                std::snprintf(b, sizeof(b), "%.0f +- %.0f ficheiros (reais %.0f, erro %.1f%%), %llu sondagens",
+                              r.ficheiros.valor, r.ficheiros.margem, reais,
+                              reais > 0 ? 100.0 * (r.ficheiros.valor - reais) / reais : 0.0,
+                              static_cast<unsigned long long>(r.sondagens));
+                return std::string(b);
+            }));
+        }
+        fs::remove_all(pasta, ec);
+    }
+
+    const Opcoes& op;
+    GeradorArvore::Parametros par;
+    std::vector<Medicao> medicoes;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Opcoes op;
+    if (!lerOpcoes(argc, argv, op)) return 1;
+
+    // Só gerar (para usar a árvore fora da suite)
+    if (!op.gerarXml.empty() || !op.gerarDisco.empty()) {
+        GeradorArvore::Parametros p = op.arvore;
+        p.nos = op.nos.front();
+        GeradorArvore gerador(p);
+        if (!op.gerarXml.empty()) {
+            SistemaFicheiros sf;
+            sf.SetRoot(gerador.gerar());
+            sf.Escrever_XML(op.gerarXml);
+        }
+        if (!op.gerarDisco.empty()) {
+            std::string erro;
+            if (!gerador.gerarNoDisco(op.gerarDisco, erro)) { std::cerr << erro << "\n"; return 1; }
+        }
+        const auto& r = gerador.resumo();
+        std::cerr << r.diretorias << " diretorias, " << r.ficheiros << " ficheiros, " << r.bytes << " bytes\n";
+        return 0;
+    }
+
+    const GeradorArvore::Parametros& p = op.arvore;
+    std::ostringstream json;
+    json << "{\n  \"suite\": \"gestor_ficheiros\",\n  \"formato\": 1,\n"
+         << "  \"data\": " << jsonTexto(dataUtc()) << ",\n"
+         << "  \"compilador\": " << jsonTexto(compilador()) << ",\n"
+         << "  \"threads\": " << std::thread::hardware_concurrency() << ",\n"
+         << "  \"parametros\": {\"semente\": " << p.semente << ", \"profundidade\": " << p.profundidade
+         << ", \"ramificacao\": " << p.ramificacao << ", \"ficheiros_por_diretoria\": " << jsonNumero(p.ficheirosPorDiretoria)
+         << ", \"nomes_distintos\": " << p.nomesDistintos << ", \"skew\": " << jsonNumero(p.skew)
+         << ", \"tamanhos\": " << jsonTexto(p.tamanhos.texto()) << ", \"reps\": " << op.reps << "},\n"
+         << "  \"resultados\": [\n";
+    for (size_t i = 0; i < op.nos.size(); ++i) {
+        Execucao e(op, op.nos[i]);
+        json << e.correr() << (i + 1 < op.nos.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (op.saida.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream f(op.saida);
+        if (!(f << json.str())) { std::cerr << "Nao foi possivel escrever " << op.saida << "\n"; return 1; }
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include "CacheVarrimento.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+#include "Perfil.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Cabeçalho do ficheiro: assinatura e versão do formato.
+constexpr char kAssinatura[4] = { 'G', 'D', 'C', 'V' };
+constexpr uint32_t kVersao = 1;
+
+#ifdef _WIN32
+// Converte a data do relógio do sistema de ficheiros para o relógio do sistema.
+std::chrono::system_clock::time_point paraSistema(fs::file_time_type t) {
+    return std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+        t - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+}
+#endif
+
+// Escrita e leitura dos campos em binário (ordem de bytes da máquina: a cache é local).
+template <typename T>
+void gravar(std::ofstream& ofs, T v) { ofs.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+void gravarTexto(std::ofstream& ofs, const std::string& s) {
+    gravar(ofs, static_cast<uint32_t>(s.size()));
+    ofs.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// Cursor sobre o conteúdo lido; qualquer leitura fora dos limites invalida o resto.
+struct Leitor {
+    const char* p;
+    const char* fim;
+    bool ok = true;
+
+    template <typename T>
+    T tirar() {
+        T v{};
+        if (!ok || static_cast<size_t>(fim - p) < sizeof(T)) { ok = false; return v; }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    std::string texto() {
+        uint32_t n = tirar<uint32_t>();
+        if (!ok || static_cast<size_t>(fim - p) < n) { ok = false; return std::string(); }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+} // namespace
+
+bool CacheVarrimento::estado(const std::string& caminho, Estado& e) {
+    perfil::chamadas(); // stat
+#ifdef _WIN32
+    // Sem inode: só a data de modificação identifica a versão da diretoria.
+    std::error_code ec;
+    auto t = fs::last_write_time(caminho, ec);
+    if (ec) return false;
+    e = Estado();
+    e.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(paraSistema(t).time_since_epoch()).count();
+    return true;
+#else
+    struct stat st;
+    if (::stat(caminho.c_str(), &st) != 0) return false;
+    e.dispositivo = static_cast<uint64_t>(st.st_dev);
+    e.inode = static_cast<uint64_t>(st.st_ino);
+    e.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    return true;
+#endif
+}
+
+// O tipo das entradas vem do getdents; só o que não é diretoria é consultado com stat.
+CacheVarrimento::Listagem CacheVarrimento::lerDiretoria(const std::string& caminho) {
+    Listagem l;
+    std::error_code ec;
+    for (fs::directory_iterator d(caminho, fs::directory_options::skip_permission_denied, ec), fim; !ec && d != fim; d.increment(ec)) {
+        const fs::directory_entry& entry = *d;
+        Entrada e;
+        e.nome = entry.path().filename().string();
+        std::error_code ecTipo;
+        if (entry.is_directory(ecTipo)) {
+            e.tipo = entry.is_symlink(ecTipo) ? LigacaoDiretoria : Diretoria;
+            l.entradas.push_back(std::move(e));
+            continue;
+        }
+        perfil::chamadas(); // stat
+#ifdef _WIN32
+        std::error_code ecTamanho;
+        e.tamanho = fs::file_size(entry.path(), ecTamanho);
+        if (!ecTamanho) {
+            auto t = fs::last_write_time(entry.path(), ecTamanho);
+            perfil::chamadas(); // stat
+            e.mtime = static_cast<int64_t>(std::chrono::system_clock::to_time_t(paraSistema(t)));
+            e.tipo = Ficheiro;
+        }
+#else
+        // Como fs::file_size: segue ligações simbólicas e só aceita ficheiros regulares.
+        struct stat st;
+        if (::stat(entry.path().c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            e.tipo = Ficheiro;
+            e.tamanho = static_cast<uint64_t>(st.st_size);
+            e.mtime = static_cast<int64_t>(st.st_mtime);
+            e.dispositivo = static_cast<uint64_t>(st.st_dev);
+            e.inode = static_cast<uint64_t>(st.st_ino);
+            e.ligacoes = static_cast<uint32_t>(st.st_nlink);
+        }
+#endif
+        l.entradas.push_back(std::move(e));
+    }
+    perfil::chamadas(2); // open + getdents
+    return l;
+}
+
+void CacheVarrimento::comecar(const std::string& pasta) {
+    std::error_code ec;
+    std::string absoluta = fs::weakly_canonical(fs::absolute(pasta, ec), ec).generic_string();
+    if (ec) absoluta = pasta;
+    if (absoluta != raiz) anteriores.clear();
+    // O que ficou por visitar no varrimento anterior continua a servir.
+    for (auto& p : atuais) anteriores.insert_or_assign(p.first, std::move(p.second));
+    atuais.clear();
+    raiz = absoluta;
+    inicio = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const CacheVarrimento::Listagem* CacheVarrimento::listar(const std::string& relativo, const std::string& caminho,
+                                                         bool& reutilizada) {
+    reutilizada = false;
+    Estado e;
+    if (!estado(caminho, e)) return nullptr;
+    auto it = anteriores.find(relativo);
+    if (it != anteriores.end()) {
+        Listagem guardada = std::move(it->second);
+        anteriores.erase(it);
+        if (guardada.estado == e) {
+            reutilizada = true;
+            return &atuais.insert_or_assign(relativo, std::move(guardada)).first->second;
+        }
+    }
+    Listagem l = lerDiretoria(caminho);
+    l.estado = e;
+    return &atuais.insert_or_assign(relativo, std::move(l)).first->second;
+}
+
+bool CacheVarrimento::ler(const std::string& ficheiro) {
+    perfil::Medida medida("CacheVarrimento::ler");
+    anteriores.clear();
+    atuais.clear();
+    raiz.clear();
+    std::ifstream ifs(ficheiro, std::ios::binary);
+    if (!ifs.is_open()) return false;
+    std::string conteudo((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    Leitor r{ conteudo.data(), conteudo.data() + conteudo.size() };
+
+    char assinatura[4];
+    for (char& c : assinatura) c = r.tirar<char>();
+    if (!r.ok || std::memcmp(assinatura, kAssinatura, sizeof(kAssinatura)) != 0 || r.tirar<uint32_t>() != kVersao) return false;
+    std::string pasta = r.texto();
+    uint64_t n = r.tirar<uint64_t>();
+    std::unordered_map<std::string, Listagem> lidas;
+    for (uint64_t i = 0; r.ok && i < n; ++i) {
+        std::string relativo = r.texto();
+        Listagem l;
+        l.estado.dispositivo = r.tirar<uint64_t>();
+        l.estado.inode = r.tirar<uint64_t>();
+        l.estado.mtime = r.tirar<int64_t>();
+        uint32_t entradas = r.tirar<uint32_t>();
+        // Cada entrada ocupa pelo menos 5 bytes: um número maior só pode vir de um ficheiro estragado.
+        if (!r.ok || entradas > static_cast<size_t>(r.fim - r.p) / 5) return false;
+        l.entradas.resize(entradas);
+        for (Entrada& e : l.entradas) {
+            e.nome = r.texto();
+            uint8_t tipo = r.tirar<uint8_t>();
+            if (tipo > Outro) r.ok = false;
+            e.tipo = static_cast<Tipo>(tipo);
+            if (e.tipo != Ficheiro) continue;
+            e.tamanho = r.tirar<uint64_t>();
+            e.mtime = r.tirar<int64_t>();
+            e.dispositivo = r.tirar<uint64_t>();
+            e.inode = r.tirar<uint64_t>();
+            e.ligacoes = r.tirar<uint32_t>();
+        }
+        lidas.emplace(std::move(relativo), std::move(l));
+    }
+    if (!r.ok || r.p != r.fim) return false;
+    perfil::nos(lidas.size());
+    raiz = std::move(pasta);
+    anteriores = std::move(lidas);
+    return true;
+}
+
+bool CacheVarrimento::escrever(const std::string& ficheiro) const {
+    perfil::Medida medida("CacheVarrimento::escrever");
+    // Só as listagens estáveis: uma diretoria alterada perto do início do
+    // varrimento pode voltar a mudar sem que o mtime mude.
+    uint64_t n = 0;
+    for (const auto& p : atuais)
+        if (p.second.estado.mtime + kMargemNs <= inicio) ++n;
+
+    std::string temporario = ficheiro + ".tmp";
+    {
+        std::ofstream ofs(temporario, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        ofs.write(kAssinatura, sizeof(kAssinatura));
+        gravar(ofs, kVersao);
+        gravarTexto(ofs, raiz);
+        gravar(ofs, n);
+        for (const auto& p : atuais) {
+            const Listagem& l = p.second;
+            if (l.estado.mtime + kMargemNs > inicio) continue;
+            gravarTexto(ofs, p.first);
+            gravar(ofs, l.estado.dispositivo);
+            gravar(ofs, l.estado.inode);
+            gravar(ofs, l.estado.mtime);
+            gravar(ofs, static_cast<uint32_t>(l.entradas.size()));
+            for (const Entrada& e : l.entradas) {
+                gravarTexto(ofs, e.nome);
+                gravar(ofs, static_cast<uint8_t>(e.tipo));
+                if (e.tipo != Ficheiro) continue;
+                gravar(ofs, e.tamanho);
+                gravar(ofs, e.mtime);
+                gravar(ofs, e.dispositivo);
+                gravar(ofs, e.inode);
+                gravar(ofs, e.ligacoes);
+            }
+        }
+        perfil::nos(n);
+        if (!ofs.flush()) return false;
+    }
+    std::error_code ec;
+    fs::rename(temporario, ficheiro, ec);
+    if (ec) { fs::remove(temporario, ec); return false; }
+    return true;
+}
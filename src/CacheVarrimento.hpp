@@ -0,0 +1,116 @@
+#ifndef CACHEVARRIMENTO_HPP
+#define CACHEVARRIMENTO_HPP
+
+/**
+ * @file CacheVarrimento.hpp
+ * @brief Declara a classe CacheVarrimento (listagens do disco guardadas entre execuções do Load).
+ */
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class CacheVarrimento
+ * @brief Guarda a listagem de cada diretoria lida pelo Load, validada pelo mtime da diretoria.
+ *
+ * Criar, remover ou renomear uma entrada muda o mtime da diretoria que a
+ * contém. Um Load seguinte faz só um stat a cada diretoria e, se o
+ * (dispositivo, inode, mtime) for o guardado, usa a listagem anterior sem
+ * abrir a diretoria nem consultar os ficheiros.
+ *
+ * Um ficheiro reescrito no mesmo sítio (sem criar nem renomear entradas) não
+ * muda o mtime da diretoria: o tamanho e a data guardados ficam desatualizados
+ * até a diretoria mudar ou a cache ser descartada. As diretorias alteradas
+ * perto do início do varrimento não ficam guardadas (o mtime pode não
+ * distinguir essa alteração de uma seguinte).
+ *
+ * A listagem é a da diretoria completa, antes das regras de ignorar, para que
+ * mudar as regras não a invalide.
+ */
+class CacheVarrimento {
+public:
+    /** @brief Tipo de uma entrada de uma diretoria. */
+    enum Tipo : uint8_t {
+        Ficheiro = 0,        ///< Ficheiro regular (com tamanho e data).
+        Diretoria = 1,       ///< Diretoria a percorrer.
+        LigacaoDiretoria = 2,///< Ligação simbólica para uma diretoria: conta, mas não se desce.
+        Outro = 3            ///< Sem tamanho (ligação quebrada, socket, ...): só conta se ignorado.
+    };
+
+    /** @brief Entrada de uma diretoria; os campos numéricos só valem para ficheiros. */
+    struct Entrada {
+        std::string nome;
+        Tipo tipo = Outro;
+        uint64_t tamanho = 0;
+        int64_t mtime = 0;       ///< Segundos desde a época.
+        uint64_t dispositivo = 0;
+        uint64_t inode = 0;
+        uint32_t ligacoes = 1;
+    };
+
+    /** @brief Identidade e versão de uma diretoria (o que decide se a listagem guardada serve). */
+    struct Estado {
+        uint64_t dispositivo = 0;
+        uint64_t inode = 0;
+        int64_t mtime = 0;       ///< Nanossegundos desde a época.
+        bool operator==(const Estado& o) const {
+            return dispositivo == o.dispositivo && inode == o.inode && mtime == o.mtime;
+        }
+    };
+
+    /** @brief Conteúdo de uma diretoria, pela ordem da leitura. */
+    struct Listagem {
+        Estado estado;
+        std::vector<Entrada> entradas;
+    };
+
+    /**
+     * @brief Lê uma cache escrita por escrever().
+     * @return false se o ficheiro não existir ou for inválido (a cache fica vazia).
+     */
+    bool ler(const std::string& ficheiro);
+    /**
+     * @brief Escreve as listagens do último varrimento (num ficheiro temporário, depois renomeado).
+     * @return false se não foi possível escrever.
+     */
+    bool escrever(const std::string& ficheiro) const;
+
+    /**
+     * @brief Começa um varrimento de pasta: as listagens lidas de outra pasta são descartadas.
+     * @details Só as diretorias visitadas a partir daqui são escritas por escrever().
+     */
+    void comecar(const std::string& pasta);
+
+    /**
+     * @brief Listagem de uma diretoria, da cache se o estado for o guardado ou lida do disco.
+     * @param relativo Caminho relativo à pasta de comecar(), com '/' ("" para a própria pasta).
+     * @param caminho Caminho da diretoria no disco.
+     * @param reutilizada Fica true se a listagem veio da cache.
+     * @return nullptr se a diretoria não pôde ser consultada.
+     */
+    const Listagem* listar(const std::string& relativo, const std::string& caminho, bool& reutilizada);
+
+    /** @brief Lê uma diretoria do disco (um stat por entrada que não é diretoria). */
+    static Listagem lerDiretoria(const std::string& caminho);
+    /** @brief Estado atual de uma diretoria no disco. @return false se não pôde ser consultada. */
+    static bool estado(const std::string& caminho, Estado& e);
+
+    /** @brief Pasta do último comecar() (absoluta). */
+    const std::string& pasta() const { return raiz; }
+    /** @brief Diretorias guardadas. */
+    size_t tamanho() const { return atuais.size(); }
+
+private:
+    // Diferença mínima entre o mtime e o início do varrimento para uma listagem ser guardada.
+    static constexpr int64_t kMargemNs = 2'000'000'000;
+
+    std::string raiz;
+    int64_t inicio = 0; // início do varrimento (ns)
+    std::unordered_map<std::string, Listagem> anteriores; // lidas do ficheiro, ainda não visitadas
+    std::unordered_map<std::string, Listagem> atuais;     // visitadas neste varrimento
+};
+
+#endif // CACHEVARRIMENTO_HPP
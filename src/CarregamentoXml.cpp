@@ -0,0 +1,145 @@
+#include "CarregamentoXml.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include "Perfil.hpp"
+
+namespace {
+
+std::string unescapeXml(const std::string &in) {
+    std::string out; out.reserve(in.size());
+    size_t pos = 0;
+    while (pos < in.size()) {
+        if (in[pos] == '&') {
+            if (in.compare(pos, 5, "&amp;") == 0) { out += '&'; pos += 5; }
+            else if (in.compare(pos, 4, "&lt;") == 0) { out += '<'; pos += 4; }
+            else if (in.compare(pos, 4, "&gt;") == 0) { out += '>'; pos += 4; }
+            else if (in.compare(pos, 6, "&quot;") == 0) { out += '"'; pos += 6; }
+            else if (in.compare(pos, 6, "&apos;") == 0) { out += '\''; pos += 6; }
+            else { out += in[pos++]; }
+        } else { out += in[pos++]; }
+    }
+    return out;
+}
+
+// Extrai o valor de um atributo na linha XML
+std::string extractAttribute(const std::string &line, const std::string &attr) {
+    std::string pattern = attr + "=\"";
+    size_t start = line.find(pattern);
+    if (start == std::string::npos) return "";
+    start += pattern.size();
+    size_t end = line.find("\"", start);
+    if (end == std::string::npos) return "";
+    return line.substr(start, end - start);
+}
+
+} // namespace
+
+// ----------------------------------------
+// LeitorXml
+void LeitorXml::linha(std::string& line) {
+    line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+    line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+    if (line.find("<Directory") != std::string::npos) {
+        std::string name = unescapeXml(extractAttribute(line, "name"));
+        auto dir = std::make_shared<Directory>(name);
+        if (pilha.empty()) primeira = dir;
+        else pilha.back()->addSubdirectoryPtr(dir);
+        pilha.push_back(dir.get());
+    } else if (line.find("</Directory>") != std::string::npos) {
+        if (!pilha.empty()) pilha.pop_back();
+    } else if (line.find("<File") != std::string::npos) {
+        std::string name = unescapeXml(extractAttribute(line, "name"));
+        std::string sizeStr = extractAttribute(line, "size");
+        std::string dateStr = unescapeXml(extractAttribute(line, "date"));
+        size_t size = std::stoull(sizeStr);
+        if (!pilha.empty()) {
+            pilha.back()->addFilePtr(std::make_shared<File>(name, size, dateStr));
+        }
+    }
+}
+
+// ----------------------------------------
+// CarregamentoXml
+CarregamentoXml::CarregamentoXml(const std::string& ficheiro) {
+    std::error_code ec;
+    uintmax_t n = std::filesystem::file_size(ficheiro, ec);
+    tamanho = ec ? 0 : static_cast<uint64_t>(n);
+    thread = std::thread(&CarregamentoXml::ler, this, ficheiro);
+}
+
+CarregamentoXml::~CarregamentoXml() {
+    prog.cancelar = true;
+    if (thread.joinable()) thread.join();
+}
+
+void CarregamentoXml::ler(const std::string& ficheiro) {
+    perfil::Medida medida("CarregamentoXml::ler");
+    bool ok = false;
+    try {
+        std::ifstream ifs(ficheiro);
+        if (ifs.is_open()) {
+            std::string line;
+            bool fimFicheiro = false;
+            while (!fimFicheiro && !prog.cancelado()) {
+                // Quem pediu o bloqueio passa à frente do lote seguinte.
+                while (pedidos.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    for (size_t k = 0; k < kLinhasPorLote; ++k) {
+                        if (!std::getline(ifs, line)) { fimFicheiro = true; break; }
+                        perfil::nos();
+                        prog.entradas.fetch_add(1, std::memory_order_relaxed);
+                        prog.bytes.fetch_add(line.size() + 1, std::memory_order_relaxed);
+                        leitor.linha(line);
+                    }
+                }
+                mudou.notify_all();
+            }
+            ok = fimFicheiro;
+        }
+    } catch (...) { ok = false; }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        sucesso = ok;
+        fim.store(true, std::memory_order_release);
+    }
+    mudou.notify_all();
+}
+
+std::shared_ptr<Directory> CarregamentoXml::esperarRaiz() {
+    std::unique_lock<std::mutex> lock(mtx);
+    mudou.wait(lock, [this] { return fim.load(std::memory_order_relaxed) || leitor.raiz(); });
+    if (fim.load(std::memory_order_relaxed) && !sucesso) return nullptr;
+    return leitor.raiz();
+}
+
+std::unique_lock<std::mutex> CarregamentoXml::bloquear() {
+    pedidos.fetch_add(1, std::memory_order_acq_rel);
+    std::unique_lock<std::mutex> lock(mtx);
+    pedidos.fetch_sub(1, std::memory_order_acq_rel);
+    return lock;
+}
+
+bool CarregamentoXml::completa(const Directory* d) const {
+    if (fim.load(std::memory_order_relaxed)) return true;
+    const auto& abertas = leitor.abertas();
+    return std::find(abertas.begin(), abertas.end(), d) == abertas.end();
+}
+
+void CarregamentoXml::esperar(std::unique_lock<std::mutex>& bloqueio, const std::function<bool()>& pronto) {
+    mudou.wait(bloqueio, [&] { return fim.load(std::memory_order_relaxed) || pronto(); });
+}
+
+std::shared_ptr<Directory> CarregamentoXml::concluir() {
+    if (thread.joinable()) thread.join();
+    return sucesso ? leitor.raiz() : nullptr;
+}
+
+int CarregamentoXml::percentagem() const {
+    if (terminado()) return 100;
+    if (tamanho == 0) return 0;
+    uint64_t lidos = prog.bytes.load(std::memory_order_relaxed);
+    return static_cast<int>(std::min<uint64_t>(99, lidos * 100 / tamanho));
+}
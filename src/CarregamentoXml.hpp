@@ -0,0 +1,101 @@
+#ifndef CARREGAMENTOXML_HPP
+#define CARREGAMENTOXML_HPP
+
+/**
+ * @file CarregamentoXml.hpp
+ * @brief Declara LeitorXml (leitura incremental do XML) e CarregamentoXml (leitura em segundo plano).
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Directory.hpp"
+#include "Tarefas.hpp"
+
+/**
+ * @class LeitorXml
+ * @brief Constrói a árvore a partir das linhas do formato de Escrever_XML, uma de cada vez.
+ *
+ * O ficheiro está em pré-ordem: uma diretoria só fica completa (todos os
+ * descendentes lidos) quando aparece o seu </Directory>. As diretorias ainda
+ * abertas são, por isso, as únicas incompletas.
+ */
+class LeitorXml {
+public:
+    /** @brief Processa uma linha. @throws std::exception se um tamanho for inválido. */
+    void linha(std::string& l);
+
+    /** @brief Primeira diretoria lida (nullptr enquanto não houver nenhuma). */
+    const std::shared_ptr<Directory>& raiz() const { return primeira; }
+    /** @brief Diretorias por fechar, da raiz para a mais funda. */
+    const std::vector<Directory*>& abertas() const { return pilha; }
+
+private:
+    std::shared_ptr<Directory> primeira;
+    std::vector<Directory*> pilha;
+};
+
+/**
+ * @class CarregamentoXml
+ * @brief Lê um ficheiro XML numa thread própria, ligando os nós à árvore à medida que são lidos.
+ *
+ * A thread lê lotes de linhas com o mutex fechado. Quem quiser ler (ou
+ * alterar) a parte já carregada fecha-o com bloquear(); o carregamento fica
+ * parado até o bloqueio ser libertado e não retoma enquanto houver alguém à
+ * espera dele. Com o bloqueio, completa(d) diz se a subárvore de d já foi lida
+ * e esperar() liberta-o até uma condição se cumprir.
+ */
+class CarregamentoXml {
+public:
+    /** @brief Começa a ler ficheiro em segundo plano. */
+    explicit CarregamentoXml(const std::string& ficheiro);
+    /** @brief Cancela a leitura (se ainda estiver a decorrer) e espera pela thread. */
+    ~CarregamentoXml();
+    CarregamentoXml(const CarregamentoXml&) = delete;
+    CarregamentoXml& operator=(const CarregamentoXml&) = delete;
+
+    /** @brief Espera pela raiz da árvore; nullptr se o ficheiro não tiver nenhuma ou não puder ser lido. */
+    std::shared_ptr<Directory> esperarRaiz();
+    /** @brief Pára o carregamento enquanto o bloqueio devolvido existir. */
+    std::unique_lock<std::mutex> bloquear();
+    /** @brief (Com o bloqueio) true se toda a subárvore de d já foi lida. */
+    bool completa(const Directory* d) const;
+    /** @brief (Com o bloqueio) espera que pronto() seja verdadeiro ou que a leitura termine. */
+    void esperar(std::unique_lock<std::mutex>& bloqueio, const std::function<bool()>& pronto);
+    /**
+     * @brief Espera pelo fim da leitura.
+     * @return A árvore lida, ou nullptr se o ficheiro não pôde ser lido até ao fim.
+     */
+    std::shared_ptr<Directory> concluir();
+
+    /** @brief true quando a thread já terminou (com ou sem sucesso). */
+    bool terminado() const { return fim.load(std::memory_order_acquire); }
+    /** @brief Percentagem do ficheiro já lida (0 a 100). */
+    int percentagem() const;
+    /** @brief Linhas e bytes lidos. */
+    const Progresso& progresso() const { return prog; }
+
+private:
+    void ler(const std::string& ficheiro);
+
+    // Linhas lidas de cada vez que o mutex é fechado.
+    static constexpr size_t kLinhasPorLote = 4096;
+
+    mutable std::mutex mtx;
+    std::condition_variable mudou;
+    std::atomic<int> pedidos{0};
+    std::atomic<bool> fim{false};
+    bool sucesso = false;
+    uint64_t tamanho = 0;
+    Progresso prog;
+    LeitorXml leitor;
+    std::thread thread;
+};
+
+#endif // CARREGAMENTOXML_HPP
@@ -0,0 +1,708 @@
+#include "Consulta.hpp"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "Kernels.hpp"
+#include "Perfil.hpp"
+#include "RegrasIgnorar.hpp"
+
+namespace {
+
+constexpr uint32_t kBloco = 65536;     // Ficheiros filtrados de cada vez (o vetor de seleção cabe na cache L2).
+constexpr size_t kJanelaPorThread = 4; // Blocos filtrados à espera de serem entregues, por thread.
+constexpr uint32_t kSemPosicao = UINT32_MAX;
+
+bool mesmaPalavra(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    return true;
+}
+
+std::string emMinusculas(std::string_view s) {
+    std::string r(s);
+    for (char& c : r) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return r;
+}
+
+// Extensão como no export: depois do último '.', sem contar ficheiros ocultos do tipo ".bashrc".
+std::string_view extensao(std::string_view nome) {
+    size_t ponto = nome.rfind('.');
+    if (ponto == std::string_view::npos || ponto == 0 || ponto + 1 == nome.size()) return std::string_view();
+    return nome.substr(ponto + 1);
+}
+
+bool numero(std::string_view s, uint64_t& v) {
+    if (s.empty() || s.size() > 19) return false;
+    v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+// "100", "1.5M", "10KB", "2GiB": sufixos em potências de 1024.
+bool tamanho(std::string_view s, uint64_t& v) {
+    size_t fim = 0;
+    while (fim < s.size() && (std::isdigit(static_cast<unsigned char>(s[fim])) || s[fim] == '.')) ++fim;
+    std::string_view unidade = s.substr(fim);
+    if (fim == 0) return false;
+    double mult = 1;
+    if (!unidade.empty()) {
+        static const char kUnidades[] = "KMGT";
+        char u = static_cast<char>(std::toupper(static_cast<unsigned char>(unidade[0])));
+        const char* q = u ? std::strchr(kUnidades, u) : nullptr;
+        std::string_view resto = unidade;
+        if (q) {
+            for (const char* k = kUnidades; k <= q; ++k) mult *= 1024;
+            resto = unidade.substr(1);
+            if (mesmaPalavra(resto, "ib")) resto = resto.substr(2);
+        }
+        if (mesmaPalavra(resto, "b")) resto = resto.substr(1);
+        if (!resto.empty()) return false;
+    }
+    std::string digitos(s.substr(0, fim));
+    char* final = nullptr;
+    double x = std::strtod(digitos.c_str(), &final);
+    if (final != digitos.c_str() + digitos.size() || !(x * mult < 1.8e19)) return false;
+    v = static_cast<uint64_t>(x * mult + 0.5);
+    return true;
+}
+
+// "2024-01-31", "2024|1|31" ou "20240131" para AAAAMMDD.
+bool data(std::string_view s, uint64_t& v) {
+    uint64_t partes[3] = { 0, 0, 0 };
+    size_t n = 0, i = 0;
+    if (s.find_first_of("-|/") == std::string_view::npos) {
+        if (s.size() != 8 || !numero(s, v)) return false;
+        partes[0] = v / 10000;
+        partes[1] = v / 100 % 100;
+        partes[2] = v % 100;
+    } else {
+        while (n < 3) {
+            size_t j = s.find_first_of("-|/", i);
+            if (j == std::string_view::npos) j = s.size();
+            if (!numero(s.substr(i, j - i), partes[n++])) return false;
+            if (j == s.size()) break;
+            i = j + 1;
+        }
+        if (n != 3 || i > s.size()) return false;
+    }
+    if (partes[0] < 1 || partes[0] > 9999 || partes[1] < 1 || partes[1] > 12 || partes[2] < 1 || partes[2] > 31) return false;
+    v = partes[0] * 10000 + partes[1] * 100 + partes[2];
+    return true;
+}
+
+// Dia (AAAAMMDD, hora local) de há d dias.
+uint64_t diaDeHa(uint64_t d) {
+    std::time_t t = std::time(nullptr) - static_cast<std::time_t>(std::min<uint64_t>(d, 3'000'000) * 86400);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
+    return static_cast<uint64_t>(local.tm_year + 1900) * 10000 + static_cast<uint64_t>(local.tm_mon + 1) * 100 +
+           static_cast<uint64_t>(local.tm_mday);
+}
+
+// Aplica pred às posições de entrada (ou ao intervalo [de, de + n) se entrada for nula)
+// e guarda em sel, pela ordem, as que passam; sel pode ser a própria entrada.
+template <typename Pred>
+size_t selecionar(uint32_t* sel, const uint32_t* entrada, size_t n, uint32_t de, Pred pred) {
+    size_t m = 0;
+    if (entrada) {
+        for (size_t k = 0; k < n; ++k) {
+            uint32_t p = entrada[k];
+            sel[m] = p;
+            m += pred(p) ? 1 : 0;
+        }
+    } else {
+        for (uint32_t k = 0; k < n; ++k) {
+            sel[m] = de + k;
+            m += pred(de + k) ? 1 : 0;
+        }
+    }
+    return m;
+}
+
+} // namespace
+
+// ----------------------------------------
+// Compilação: análise léxica e descida recursiva.
+
+class Consulta::Leitor {
+public:
+    Leitor(Consulta& c, std::string_view texto) : c(c), texto(texto) { avancar(); }
+
+    bool consulta(std::string& erro) {
+        if (atual.classe == Fim || simbolo("|")) {
+            c.raiz = c.acrescentar(No());
+        } else {
+            c.raiz = expressao();
+        }
+        if (falhou()) return terminar(erro);
+        if (simbolo("|")) {
+            avancar();
+            if (palavra("count")) {
+                c.agreg = Agregacao::Contar;
+            } else if (palavra("sum")) {
+                c.agreg = Agregacao::Somar;
+            } else if (palavra("top")) {
+                avancar();
+                uint64_t k = 0;
+                if (atual.classe != Palavra || !numero(atual.valor, k) || k == 0 || k > 1'000'000)
+                    return falhar("esperado um numero depois de top", erro);
+                c.agreg = Agregacao::Maiores;
+                c.topN = static_cast<size_t>(k);
+            } else {
+                return falhar("agregacao desconhecida (count, sum ou top N)", erro);
+            }
+            avancar();
+        }
+        if (atual.classe != Fim) return falhar("texto a mais", erro);
+        return terminar(erro);
+    }
+
+private:
+    enum Classe { Fim, Palavra, Texto, Simbolo };
+    struct Token {
+        Classe classe = Fim;
+        std::string valor;
+        size_t posicao = 0;
+    };
+
+    void avancar() {
+        while (pos < texto.size() && std::isspace(static_cast<unsigned char>(texto[pos]))) ++pos;
+        atual = Token();
+        atual.posicao = pos;
+        if (pos >= texto.size()) return;
+        char ch = texto[pos];
+        if (ch == '"') {
+            size_t fim = texto.find('"', pos + 1);
+            if (fim == std::string_view::npos) { falha = "aspas por fechar"; pos = texto.size(); return; }
+            atual.classe = Texto;
+            atual.valor = std::string(texto.substr(pos + 1, fim - pos - 1));
+            pos = fim + 1;
+        } else if (ch == '(' || ch == ')' || ch == '|') {
+            atual.classe = Simbolo;
+            atual.valor = std::string(1, ch);
+            ++pos;
+        } else if (ch == '=' || ch == '!' || ch == '<' || ch == '>') {
+            size_t n = (pos + 1 < texto.size() && texto[pos + 1] == '=') ? 2 : 1;
+            atual.classe = Simbolo;
+            atual.valor = std::string(texto.substr(pos, n));
+            pos += n;
+        } else {
+            size_t fim = pos;
+            while (fim < texto.size() && !std::isspace(static_cast<unsigned char>(texto[fim])) &&
+                   std::string_view("()|=!<>\"").find(texto[fim]) == std::string_view::npos) ++fim;
+            atual.classe = Palavra;
+            atual.valor = std::string(texto.substr(pos, fim - pos));
+            pos = fim;
+        }
+    }
+
+    bool simbolo(std::string_view s) const { return atual.classe == Simbolo && atual.valor == s; }
+    bool palavra(std::string_view s) const { return atual.classe == Palavra && mesmaPalavra(atual.valor, s); }
+    bool falhou() const { return !falha.empty(); }
+
+    uint32_t erro(const std::string& mensagem) {
+        if (falha.empty()) falha = mensagem;
+        return kSemPosicao;
+    }
+    bool falhar(const std::string& mensagem, std::string& saida) {
+        erro(mensagem);
+        return terminar(saida);
+    }
+    bool terminar(std::string& saida) {
+        if (falha.empty()) return true;
+        saida = falha + " (posicao " + std::to_string(atual.posicao + 1) + ")";
+        return false;
+    }
+
+    uint32_t binario(Tipo t, uint32_t a, uint32_t b) {
+        No no;
+        no.tipo = t;
+        no.a = a;
+        no.b = b;
+        return c.acrescentar(std::move(no));
+    }
+
+    uint32_t expressao() {
+        uint32_t a = termo();
+        while (!falhou() && palavra("or")) {
+            avancar();
+            uint32_t b = termo();
+            if (falhou()) break;
+            a = binario(Tipo::Ou, a, b);
+        }
+        return a;
+    }
+
+    // "and" é opcional: duas condições seguidas têm de ser ambas verdadeiras.
+    uint32_t termo() {
+        uint32_t a = fator();
+        while (!falhou()) {
+            if (palavra("and")) avancar();
+            else if (!(simbolo("(") || (atual.classe == Palavra && !palavra("or")))) break;
+            uint32_t b = fator();
+            if (falhou()) break;
+            a = binario(Tipo::E, a, b);
+        }
+        return a;
+    }
+
+    uint32_t fator() {
+        if (palavra("not")) {
+            avancar();
+            uint32_t a = fator();
+            if (falhou()) return a;
+            // Numa folha sem datas basta inverter a comparação (a folha continua a ser uma etapa simples).
+            static const Op kContraria[] = { Op::Diferente, Op::Igual, Op::MaiorIgual, Op::Maior, Op::MenorIgual, Op::Menor };
+            No& no = c.nos[a];
+            if (no.tipo == Tipo::Nome || no.tipo == Tipo::Extensao || no.tipo == Tipo::Tamanho || no.tipo == Tipo::Profundidade) {
+                no.op = kContraria[static_cast<int>(no.op)];
+                return a;
+            }
+            return binario(Tipo::Nao, a, 0);
+        }
+        if (simbolo("(")) {
+            avancar();
+            uint32_t a = expressao();
+            if (falhou()) return a;
+            if (!simbolo(")")) return erro("esperado ')'");
+            avancar();
+            return a;
+        }
+        return condicao();
+    }
+
+    uint32_t condicao() {
+        if (atual.classe != Palavra) return erro("esperada uma condicao");
+        No no;
+        std::string campo = emMinusculas(atual.valor);
+        if (campo == "name") no.tipo = Tipo::Nome;
+        else if (campo == "ext") no.tipo = Tipo::Extensao;
+        else if (campo == "under") no.tipo = Tipo::Sob;
+        else if (campo == "size") no.tipo = Tipo::Tamanho;
+        else if (campo == "date" || campo == "age") no.tipo = Tipo::Data;
+        else if (campo == "depth") no.tipo = Tipo::Profundidade;
+        else return erro("campo desconhecido '" + atual.valor + "' (name, ext, size, date, age, depth, under)");
+        avancar();
+
+        if (no.tipo == Tipo::Sob) {
+            if (simbolo("=")) avancar();
+        } else {
+            static const std::pair<const char*, Op> kOps[] = {
+                { "=", Op::Igual }, { "!=", Op::Diferente }, { "<", Op::Menor },
+                { "<=", Op::MenorIgual }, { ">", Op::Maior }, { ">=", Op::MaiorIgual },
+            };
+            auto it = std::find_if(std::begin(kOps), std::end(kOps),
+                                   [&](const auto& o) { return atual.classe == Simbolo && atual.valor == o.first; });
+            if (it == std::end(kOps)) return erro("esperado um operador depois de " + campo);
+            no.op = it->second;
+            bool texto = no.tipo == Tipo::Nome || no.tipo == Tipo::Extensao;
+            if (texto && no.op != Op::Igual && no.op != Op::Diferente) return erro(campo + " so aceita = e !=");
+            avancar();
+        }
+        if (atual.classe != Palavra && atual.classe != Texto) return erro("esperado um valor depois de " + campo);
+        const std::string& v = atual.valor;
+
+        switch (no.tipo) {
+        case Tipo::Nome:
+        case Tipo::Sob:
+            no.texto = v;
+            break;
+        case Tipo::Extensao:
+            no.texto = emMinusculas(v.size() > 1 && v[0] == '.' ? std::string_view(v).substr(1) : std::string_view(v));
+            break;
+        case Tipo::Tamanho:
+            if (!tamanho(v, no.valor)) return erro("tamanho invalido '" + v + "'");
+            break;
+        case Tipo::Profundidade:
+            if (!numero(v, no.valor) || no.valor > UINT16_MAX) return erro("profundidade invalida '" + v + "'");
+            break;
+        case Tipo::Data:
+            if (campo == "date") {
+                if (!data(v, no.valor)) return erro("data invalida '" + v + "' (AAAA-MM-DD)");
+            } else {
+                // Mais antigo do que d dias = data anterior a há d dias: inverte a comparação.
+                std::string_view dias = v;
+                if (!dias.empty() && (dias.back() == 'd' || dias.back() == 'D')) dias.remove_suffix(1);
+                uint64_t d = 0;
+                if (!numero(dias, d)) return erro("idade invalida '" + v + "' (dias, ex.: 30d)");
+                no.valor = diaDeHa(d);
+                static const Op kInversa[] = { Op::Igual, Op::Diferente, Op::Maior, Op::MaiorIgual, Op::Menor, Op::MenorIgual };
+                no.op = kInversa[static_cast<int>(no.op)];
+            }
+            break;
+        default:
+            break;
+        }
+        avancar();
+        return c.acrescentar(std::move(no));
+    }
+
+    Consulta& c;
+    std::string_view texto;
+    size_t pos = 0;
+    Token atual;
+    std::string falha;
+};
+
+Consulta::Consulta(size_t threads) : nThreads(threads) {
+    if (nThreads == 0) nThreads = std::min<size_t>(8, std::max(1u, std::thread::hardware_concurrency()));
+}
+
+uint32_t Consulta::acrescentar(No no) {
+    nos.push_back(std::move(no));
+    return static_cast<uint32_t>(nos.size() - 1);
+}
+
+bool Consulta::compilar(std::string_view texto, std::string& erro) {
+    nos.clear();
+    raiz = 0;
+    agreg = Agregacao::Listar;
+    topN = 0;
+    if (Leitor(*this, texto).consulta(erro)) return true;
+    nos.clear();
+    nos.push_back(No());
+    return false;
+}
+
+// ----------------------------------------
+// Execução.
+
+struct Consulta::Ligacao {
+    uint32_t de = 0, ate = 0;                       // intervalo de ficheiros a varrer
+    std::vector<uint32_t> etapas;                   // condições do nível de topo, pela ordem de execução
+    std::vector<std::vector<uint8_t>> mascara;      // Nome/Extensao: verdadeiro por handle de nome
+    std::vector<std::pair<uint32_t, uint32_t>> sob; // Sob: nós [início, fim) da subárvore
+    std::string plano;
+};
+
+namespace {
+
+template <typename T, typename F>
+auto comOperador(uint8_t op, T v, F&& f) {
+    switch (op) {
+    case 0: return f([v](T x) { return x == v; });
+    case 1: return f([v](T x) { return x != v; });
+    case 2: return f([v](T x) { return x < v; });
+    case 3: return f([v](T x) { return x <= v; });
+    case 4: return f([v](T x) { return x > v; });
+    default: return f([v](T x) { return x >= v; });
+    }
+}
+
+template <typename T>
+bool comparar(uint8_t op, T x, T v) {
+    return comOperador(op, v, [x](auto cmp) { return cmp(x); });
+}
+
+} // namespace
+
+bool Consulta::avaliar(const FlatTree& ft, const Ligacao& l, uint32_t i, uint32_t p) const {
+    const No& n = nos[i];
+    const uint8_t op = static_cast<uint8_t>(n.op);
+    switch (n.tipo) {
+    case Tipo::Tudo: return true;
+    case Tipo::E: return avaliar(ft, l, n.a, p) && avaliar(ft, l, n.b, p);
+    case Tipo::Ou: return avaliar(ft, l, n.a, p) || avaliar(ft, l, n.b, p);
+    case Tipo::Nao: return !avaliar(ft, l, n.a, p);
+    case Tipo::Nome:
+    case Tipo::Extensao: return l.mascara[i][ft.nameId[ft.fileNodes[p]]] != 0;
+    case Tipo::Sob: return ft.fileNodes[p] >= l.sob[i].first && ft.fileNodes[p] < l.sob[i].second;
+    case Tipo::Tamanho: return comparar<uint64_t>(op, ft.fileSizes[p], n.valor);
+    case Tipo::Data: return ft.fileDates[p] != 0 && comparar<int32_t>(op, ft.fileDates[p], static_cast<int32_t>(n.valor));
+    case Tipo::Profundidade: return comparar<uint32_t>(op, ft.depth[ft.fileNodes[p]], static_cast<uint32_t>(n.valor));
+    }
+    return false;
+}
+
+// Prepara a execução sobre ft: resolve as pastas de "under", calcula as
+// máscaras de nomes e escolhe o intervalo e a ordem das etapas.
+bool Consulta::ligar(const FlatTree& ft, const Resolver& resolver, Ligacao& l, std::string& erro) const {
+    l = Ligacao();
+    l.ate = static_cast<uint32_t>(ft.fileNodes.size());
+    l.mascara.resize(nos.size());
+    l.sob.resize(nos.size());
+    std::vector<uint32_t> aceites(nos.size(), 0); // nomes aceites por cada máscara
+    for (uint32_t i = 0; i < nos.size(); ++i) {
+        const No& n = nos[i];
+        if (n.tipo == Tipo::Sob) {
+            uint32_t d = resolver ? resolver(n.texto) : FlatTree::npos;
+            if (d >= ft.size() || ft.kind[d] != FlatTree::DirNode) {
+                erro = "Diretoria nao encontrada: " + n.texto;
+                return false;
+            }
+            l.sob[i] = { d, ft.subtreeEnd[d] };
+        } else if (n.tipo == Tipo::Nome || n.tipo == Tipo::Extensao) {
+            const uint8_t diferente = n.op == Op::Diferente;
+            std::vector<uint8_t>& m = l.mascara[i];
+            m.assign(ft.nameCount(), diferente);
+            if (n.tipo == Tipo::Nome && !RegrasIgnorar::temCuringas(n.texto)) {
+                // Nome exato: o índice de nomes dá o handle sem olhar para os outros nomes.
+                uint32_t h = ft.lookupName(n.texto);
+                if (h != FlatTree::npos) m[h] = !diferente;
+            } else {
+                for (uint32_t h = 0; h < m.size(); ++h) {
+                    const std::string& nome = ft.name(h);
+                    bool casa = n.tipo == Tipo::Nome ? RegrasIgnorar::casa(n.texto, nome)
+                                                     : mesmaPalavra(extensao(nome), n.texto);
+                    m[h] = casa != static_cast<bool>(diferente);
+                }
+            }
+            aceites[i] = static_cast<uint32_t>(std::count(m.begin(), m.end(), 1));
+        }
+    }
+
+    // Condições ligadas por "and" no nível de topo, pela ordem em que foram escritas.
+    std::vector<uint32_t> conjuncoes, pilha{ raiz };
+    while (!pilha.empty()) {
+        uint32_t i = pilha.back();
+        pilha.pop_back();
+        if (nos[i].tipo == Tipo::E) {
+            pilha.push_back(nos[i].b);
+            pilha.push_back(nos[i].a);
+        } else if (nos[i].tipo != Tipo::Tudo) {
+            conjuncoes.push_back(i);
+        }
+    }
+    std::string sob;
+    for (uint32_t i : conjuncoes) {
+        if (nos[i].tipo == Tipo::Sob) {
+            // A subárvore é um intervalo de nós, e por isso também de ficheiros.
+            l.de = std::max(l.de, ft.fileStart[l.sob[i].first]);
+            l.ate = std::min(l.ate, ft.fileStart[l.sob[i].second]);
+            sob += (sob.empty() ? "under " : ", ") + nos[i].texto;
+        } else {
+            if ((nos[i].tipo == Tipo::Nome || nos[i].tipo == Tipo::Extensao) && aceites[i] == 0) l.ate = l.de;
+            l.etapas.push_back(i);
+        }
+    }
+    if (l.ate < l.de) l.ate = l.de;
+
+    // Seletividade de cada etapa numa amostra do intervalo: as folhas simples
+    // (um ciclo sobre uma coluna) correm primeiro, da mais seletiva para a menos.
+    constexpr uint32_t kAmostra = 256;
+    const uint32_t total = l.ate - l.de;
+    struct Estimativa {
+        bool composta;
+        double fracao;
+        uint32_t no;
+    };
+    std::vector<Estimativa> ordem;
+    for (uint32_t i : l.etapas) {
+        uint32_t n = std::min(total, kAmostra), passam = 0;
+        for (uint32_t k = 0; k < n; ++k)
+            passam += avaliar(ft, l, i, l.de + static_cast<uint32_t>(static_cast<uint64_t>(k) * total / n)) ? 1 : 0;
+        bool composta = nos[i].tipo == Tipo::Ou || nos[i].tipo == Tipo::Nao;
+        ordem.push_back({ composta, n ? static_cast<double>(passam) / n : 0.0, i });
+    }
+    std::stable_sort(ordem.begin(), ordem.end(), [](const Estimativa& x, const Estimativa& y) {
+        return x.composta != y.composta ? y.composta : x.fracao < y.fracao;
+    });
+
+    l.plano = std::to_string(total) + " de " + std::to_string(ft.fileNodes.size()) + " ficheiros";
+    if (!sob.empty()) l.plano += " (" + sob + ")";
+    for (size_t k = 0; k < ordem.size(); ++k) {
+        uint32_t i = ordem[k].no;
+        l.etapas[k] = i;
+        const No& n = nos[i];
+        static const char* kNomes[] = { "", "", "expressao", "expressao", "name", "ext", "under", "size", "date", "depth" };
+        l.plano += k == 0 ? "; " : " > ";
+        l.plano += kNomes[static_cast<int>(n.tipo)];
+        if (n.tipo == Tipo::Nome && !RegrasIgnorar::temCuringas(n.texto)) l.plano += " (indice)";
+        else if (n.tipo == Tipo::Nome || n.tipo == Tipo::Extensao) l.plano += " (" + std::to_string(aceites[i]) + " nomes)";
+        int pct = static_cast<int>(ordem[k].fracao * 100 + 0.5);
+        l.plano += " ~" + std::to_string(pct) + "%";
+    }
+    return true;
+}
+
+// Uma etapa do pipeline: as folhas simples têm um ciclo próprio sobre a coluna
+// (sem recursão nem switch por ficheiro); o resto é avaliado ficheiro a ficheiro.
+size_t Consulta::etapa(const FlatTree& ft, const Ligacao& l, uint32_t i, uint32_t* sel, const uint32_t* entrada,
+                       size_t n, uint32_t de) const {
+    const No& no = nos[i];
+    const uint8_t op = static_cast<uint8_t>(no.op);
+    const uint32_t* ficheiro = ft.fileNodes.data();
+    auto passa = [&](auto pred) { return selecionar(sel, entrada, n, de, pred); };
+    switch (no.tipo) {
+    case Tipo::Nome:
+    case Tipo::Extensao: {
+        const uint8_t* m = l.mascara[i].data();
+        const uint32_t* nome = ft.nameId.data();
+        return passa([=](uint32_t p) { return m[nome[ficheiro[p]]] != 0; });
+    }
+    case Tipo::Sob: {
+        const uint32_t a = l.sob[i].first, b = l.sob[i].second;
+        return passa([=](uint32_t p) { return ficheiro[p] >= a && ficheiro[p] < b; });
+    }
+    case Tipo::Tamanho: {
+        const uint64_t* v = ft.fileSizes.data();
+        return comOperador(op, no.valor, [&](auto cmp) { return passa([=](uint32_t p) { return cmp(v[p]); }); });
+    }
+    case Tipo::Data: {
+        const int32_t* v = ft.fileDates.data();
+        return comOperador(op, static_cast<int32_t>(no.valor),
+                           [&](auto cmp) { return passa([=](uint32_t p) { return v[p] != 0 && cmp(v[p]); }); });
+    }
+    case Tipo::Profundidade: {
+        const uint16_t* v = ft.depth.data();
+        return comOperador(op, static_cast<uint32_t>(no.valor), [&](auto cmp) {
+            return passa([=](uint32_t p) { return cmp(static_cast<uint32_t>(v[ficheiro[p]])); });
+        });
+    }
+    default:
+        return passa([&](uint32_t p) { return avaliar(ft, l, i, p); });
+    }
+}
+
+bool Consulta::executar(const FlatTree& ft, const Resolver& resolver, const Emitir& emitir, Resultado& r,
+                        std::string& erro, Progresso* prog) const {
+    perfil::Medida medida("Consulta::executar");
+    r = Resultado();
+    Ligacao l;
+    if (!ligar(ft, resolver, l, erro)) return false;
+    r.avaliados = l.ate - l.de;
+    r.plano = l.plano;
+    perfil::nos(r.avaliados);
+
+    // Sem condições por avaliar, contar e somar são reduções sobre o intervalo.
+    if (l.etapas.empty() && (agreg == Agregacao::Contar || agreg == Agregacao::Somar)) {
+        r.ficheiros = r.avaliados;
+        r.bytes = kernels::sum(ft.fileSizes.data() + l.de, r.avaliados);
+        if (prog) prog->entradas.fetch_add(r.avaliados, std::memory_order_relaxed);
+        return true;
+    }
+    // Top N sem condições: o intervalo é uma subárvore e o índice de máximos da FlatTree
+    // dá os maiores sem percorrer os ficheiros.
+    if (l.etapas.empty() && agreg == Agregacao::Maiores) {
+        r.ficheiros = r.avaliados;
+        r.bytes = kernels::sum(ft.fileSizes.data() + l.de, r.avaliados);
+        ft.largestFiles(l.de, l.ate, topN, r.maiores);
+        r.plano += "; indice de tamanhos";
+        if (prog) prog->entradas.fetch_add(r.avaliados, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Top N: monte com o pior candidato no topo (mais pequeno; em empate, o último na ordem DFS).
+    using Candidato = std::pair<uint64_t, uint32_t>; // tamanho, posição
+    auto melhor = [](const Candidato& x, const Candidato& y) {
+        return x.first != y.first ? x.first > y.first : x.second < y.second;
+    };
+    std::vector<Candidato> monte;
+    const uint64_t* tamanhos = ft.fileSizes.data();
+
+    // Os blocos são entregues aqui pela ordem, por isso as agregações não dependem das threads.
+    auto entregar = [&](std::vector<uint32_t>& sel) {
+        r.ficheiros += sel.size();
+        for (uint32_t p : sel) r.bytes += tamanhos[p];
+        if (agreg == Agregacao::Maiores) {
+            for (uint32_t p : sel) {
+                Candidato c{ tamanhos[p], p };
+                if (monte.size() < topN) {
+                    monte.push_back(c);
+                    std::push_heap(monte.begin(), monte.end(), melhor);
+                } else if (melhor(c, monte.front())) {
+                    std::pop_heap(monte.begin(), monte.end(), melhor);
+                    monte.back() = c;
+                    std::push_heap(monte.begin(), monte.end(), melhor);
+                }
+            }
+        } else if (agreg == Agregacao::Listar && emitir && !sel.empty()) {
+            for (uint32_t& p : sel) p = ft.fileNodes[p];
+            emitir(sel.data(), sel.size());
+        }
+    };
+    auto filtrar = [&](size_t k, std::vector<uint32_t>& sel) {
+        uint32_t a = l.de + static_cast<uint32_t>(k) * kBloco;
+        uint32_t n = std::min(kBloco, l.ate - a);
+        sel.resize(n);
+        size_t m = l.etapas.empty() ? selecionar(sel.data(), nullptr, n, a, [](uint32_t) { return true; })
+                                    : etapa(ft, l, l.etapas[0], sel.data(), nullptr, n, a);
+        for (size_t s = 1; s < l.etapas.size() && m > 0; ++s) m = etapa(ft, l, l.etapas[s], sel.data(), sel.data(), m, 0);
+        sel.resize(m);
+        if (prog) prog->entradas.fetch_add(n, std::memory_order_relaxed);
+    };
+
+    const size_t blocos = (r.avaliados + kBloco - 1) / kBloco;
+    bool cancelado = false;
+    if (nThreads <= 1 || blocos <= 2) {
+        std::vector<uint32_t> sel;
+        for (size_t k = 0; k < blocos; ++k) {
+            if (prog && prog->cancelado()) { cancelado = true; break; }
+            filtrar(k, sel);
+            entregar(sel);
+        }
+    } else {
+        // Como em EscritaBlocos: as threads filtram os blocos pela ordem, no máximo
+        // uma janela à frente do último entregue; esta thread só entrega.
+        std::vector<std::vector<uint32_t>> prontos(blocos);
+        std::vector<char> pronto(blocos, 0);
+        std::mutex mtx;
+        std::condition_variable cvPronto, cvJanela;
+        size_t proximo = 0, entregues = 0;
+        bool parar = false;
+        const size_t janela = nThreads * kJanelaPorThread;
+
+        auto trabalhador = [&] {
+            for (;;) {
+                size_t k;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cvJanela.wait(lock, [&] { return parar || proximo >= blocos || proximo < entregues + janela; });
+                    if (parar || proximo >= blocos) return;
+                    k = proximo++;
+                }
+                std::vector<uint32_t> sel;
+                filtrar(k, sel);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    prontos[k] = std::move(sel);
+                    pronto[k] = 1;
+                }
+                cvPronto.notify_one();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < nThreads; ++t) pool.emplace_back(trabalhador);
+
+        for (size_t k = 0; k < blocos; ++k) {
+            std::vector<uint32_t> sel;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cvPronto.wait(lock, [&] { return pronto[k] != 0; });
+                sel = std::move(prontos[k]);
+            }
+            entregar(sel);
+            cancelado = prog && prog->cancelado();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                entregues = k + 1;
+                if (cancelado) parar = true;
+            }
+            cvJanela.notify_all();
+            if (cancelado) break;
+        }
+        for (auto& t : pool) t.join();
+    }
+    if (cancelado) {
+        erro = "consulta cancelada";
+        return false;
+    }
+
+    std::sort_heap(monte.begin(), monte.end(), melhor);
+    for (const Candidato& c : monte) r.maiores.push_back(ft.fileNodes[c.second]);
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef CONSULTA_HPP
+#define CONSULTA_HPP
+
+/**
+ * @file Consulta.hpp
+ * @brief Declara a classe Consulta (expressões de procura sobre uma versão congelada da árvore).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FlatTree.hpp"
+#include "Tarefas.hpp"
+
+/**
+ * @class Consulta
+ * @brief Filtro de ficheiros compilado a partir de uma expressão, com agregação opcional.
+ *
+ * Gramática (palavras-chave sem distinção de maiúsculas):
+ * @code
+ *   consulta  := [expressao] ['|' (count | sum | top N)]
+ *   expressao := termo {or termo}
+ *   termo     := fator {[and] fator}
+ *   fator     := not fator | '(' expressao ')' | condicao
+ *   condicao  := name (= | !=) glob | ext (= | !=) extensao | under caminho
+ *              | (size | date | age | depth) (= | != | < | <= | > | >=) valor
+ * @endcode
+ * Os tamanhos aceitam os sufixos K, M, G e T (potências de 1024), as datas
+ * AAAA-MM-DD ou AAAAMMDD e a idade um número de dias ("30d": age > 30d são os
+ * ficheiros com data anterior a há 30 dias); um ficheiro sem data não passa
+ * nenhuma condição de data. As extensões não distinguem maiúsculas. A
+ * profundidade conta a partir da raiz (0). Valores com espaços, parênteses ou
+ * '|' vão entre aspas.
+ *
+ * A execução é um pipeline de vetores de seleção sobre as colunas de
+ * ficheiros: "under" no nível de topo passa a um intervalo de ficheiros
+ * (a subárvore é contígua), um nome sem curingas passa a uma comparação do
+ * handle do nome, e globs e extensões a uma máscara calculada uma vez por nome
+ * distinto. As condições ligadas por "and" no nível de topo correm das mais
+ * seletivas para as menos, cada uma só sobre os ficheiros que passaram as
+ * anteriores; o que está dentro de or/not é avaliado ficheiro a ficheiro no
+ * fim. Os blocos de ficheiros são filtrados por várias threads e entregues
+ * pela ordem DFS, à medida que ficam prontos.
+ * "top N" sem outras condições além de "under" usa o índice de máximos da
+ * FlatTree (FlatTree::largestFiles) em vez de percorrer a subárvore.
+ */
+class Consulta {
+public:
+    /** @brief O que fazer com os ficheiros selecionados. */
+    enum class Agregacao { Listar, Contar, Somar, Maiores };
+
+    /** @brief Devolve o nó de uma diretoria dado o caminho de "under" (FlatTree::npos se não existir). */
+    using Resolver = std::function<uint32_t(std::string_view caminho)>;
+    /** @brief Recebe os nós selecionados de um bloco, pela ordem DFS. */
+    using Emitir = std::function<void(const uint32_t* nos, size_t n)>;
+
+    /** @brief Resultado de executar(). */
+    struct Resultado {
+        uint64_t ficheiros = 0;          ///< Ficheiros selecionados.
+        uint64_t bytes = 0;              ///< Soma dos seus tamanhos.
+        uint64_t avaliados = 0;          ///< Ficheiros dentro do intervalo varrido.
+        std::vector<uint32_t> maiores;   ///< Com top N: nós dos maiores, do maior para o menor.
+        std::string plano;               ///< Descrição do plano usado (intervalo e ordem dos filtros).
+    };
+
+    /** @param threads Threads de filtragem (0 = uma por núcleo, até 8). */
+    explicit Consulta(size_t threads = 0);
+
+    /**
+     * @brief Compila uma expressão; "age" é relativa ao dia da compilação.
+     * @return false com a mensagem em erro se a expressão for inválida.
+     */
+    bool compilar(std::string_view texto, std::string& erro);
+
+    /**
+     * @brief Executa a consulta compilada sobre ft.
+     * @param resolver Resolve os caminhos de "under".
+     * @param emitir Com Agregacao::Listar, recebe os ficheiros selecionados (pode ser vazio).
+     * @param prog Progresso (ficheiros avaliados) e cancelamento.
+     * @return false com a mensagem em erro (ex.: pasta de "under" inexistente) ou se foi cancelada.
+     */
+    bool executar(const FlatTree& ft, const Resolver& resolver, const Emitir& emitir, Resultado& r,
+                  std::string& erro, Progresso* prog = nullptr) const;
+
+    Agregacao agregacao() const { return agreg; }
+    /** @brief N de "top N". */
+    size_t limite() const { return topN; }
+    /** @brief Número de threads de filtragem. */
+    size_t threads() const { return nThreads; }
+
+private:
+    enum class Tipo : uint8_t { Tudo, E, Ou, Nao, Nome, Extensao, Sob, Tamanho, Data, Profundidade };
+    enum class Op : uint8_t { Igual, Diferente, Menor, MenorIgual, Maior, MaiorIgual };
+
+    // Nó da expressão; a e b são filhos (E, Ou, Nao) em nos.
+    struct No {
+        Tipo tipo = Tipo::Tudo;
+        Op op = Op::Igual;
+        uint32_t a = 0, b = 0;
+        uint64_t valor = 0;   // tamanho, data AAAAMMDD ou profundidade
+        std::string texto;    // glob, extensão ou caminho
+    };
+
+    // Dados de uma execução: o que cada folha passou a ser sobre ft.
+    struct Ligacao;
+    class Leitor;
+
+    uint32_t acrescentar(No no);
+    bool avaliar(const FlatTree& ft, const Ligacao& l, uint32_t i, uint32_t p) const;
+    size_t etapa(const FlatTree& ft, const Ligacao& l, uint32_t i, uint32_t* sel, const uint32_t* entrada,
+                 size_t n, uint32_t de) const;
+    bool ligar(const FlatTree& ft, const Resolver& resolver, Ligacao& l, std::string& erro) const;
+
+    std::vector<No> nos;
+    uint32_t raiz = 0;
+    Agregacao agreg = Agregacao::Listar;
+    size_t topN = 0;
+    size_t nThreads;
+};
+
+#endif // CONSULTA_HPP
@@ -0,0 +1,221 @@
+#include "Daemon.hpp"
+#include <iostream>
+#include "Protocolo.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Estado de uma ligação: a sua Shell (sobre a árvore partilhada) e os buffers de I/O.
+struct Daemon::Sessao {
+    std::istringstream in;
+    std::ostringstream out;
+    Shell shell;
+    std::string leitura;  // bytes recebidos ainda não processados
+    std::string escrita;  // respostas por enviar
+    size_t enviado = 0;   // bytes de escrita já enviados
+    bool fechar = false;  // fechar depois de enviar o que falta
+    bool querEscrever = false; // registado com EPOLLOUT
+
+    Sessao(SistemaFicheiros& sf, Shell::Opcoes opcoes) : shell(sf, in, out, opcoes) {}
+};
+
+Daemon::Daemon(Shell::Opcoes opcoes) : opcoes(opcoes) {
+    sf.SetRoot(std::make_shared<Directory>("/"));
+    if (opcoes.autoLoad && sf.Ler_XML(Shell::kFicheiroEstado)) {
+        std::cerr << "Sistema carregado de " << Shell::kFicheiroEstado << "\n";
+    }
+}
+
+#ifdef __linux__
+Daemon::~Daemon() {
+    sessoes.clear();
+    if (listenFd >= 0) { ::close(listenFd); ::unlink(caminhoSocket.c_str()); }
+    if (epollFd >= 0) ::close(epollFd);
+    if (paragemFd >= 0) ::close(paragemFd);
+}
+
+bool Daemon::abrir(const std::string& caminho) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (caminho.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Caminho do socket demasiado longo: " << caminho << "\n";
+        return false;
+    }
+    std::memcpy(addr.sun_path, caminho.c_str(), caminho.size() + 1);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) { std::perror("socket"); return false; }
+    ::unlink(caminho.c_str());
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+        std::perror("bind/listen");
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    caminhoSocket = caminho;
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    paragemFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || paragemFd < 0) { std::perror("epoll/eventfd"); return false; }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = paragemFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, paragemFd, &ev);
+    return true;
+}
+
+void Daemon::parar() {
+    uint64_t um = 1;
+    if (paragemFd >= 0) (void)!::write(paragemFd, &um, sizeof(um));
+}
+
+void Daemon::run() {
+    epoll_event eventos[64];
+    while (!aTerminar) {
+        int n = ::epoll_wait(epollFd, eventos, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = eventos[i].data.fd;
+            uint32_t ev = eventos[i].events;
+            if (fd == paragemFd) { aTerminar = true; continue; }
+            if (fd == listenFd) { aceitar(); continue; }
+            if (!sessoes.count(fd)) continue; // fechada por um evento anterior neste lote
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) ler(fd);
+            if (sessoes.count(fd) && (ev & EPOLLOUT)) escrever(fd);
+        }
+    }
+
+    // Fecha as ligações (as Shells esperam pelas exportações em curso) e guarda o estado.
+    sessoes.clear();
+    if (opcoes.autoSave) {
+        sf.Escrever_XML(Shell::kFicheiroEstado);
+        std::cerr << "Sistema guardado em " << Shell::kFicheiroEstado << "\n";
+    }
+}
+
+void Daemon::aceitar() {
+    for (;;) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: não há mais ligações pendentes
+        }
+        Shell::Opcoes sessaoOpcoes;
+        sessaoOpcoes.interativo = false;
+        sessaoOpcoes.autoLoad = false;
+        sessaoOpcoes.autoSave = false;
+        sessoes[fd] = std::make_unique<Sessao>(sf, sessaoOpcoes);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void Daemon::ler(int fd) {
+    Sessao& s = *sessoes[fd];
+    char buf[64 * 1024];
+    for (;;) {
+        ssize_t k = ::recv(fd, buf, sizeof(buf), 0);
+        if (k > 0) { s.leitura.append(buf, static_cast<size_t>(k)); continue; }
+        if (k < 0 && errno == EINTR) continue;
+        if (k == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) s.fechar = true;
+        break;
+    }
+
+    // Executa todos os pedidos completos; as respostas seguem juntas num só envio.
+    size_t pos = 0;
+    std::string cmd;
+    while (!aTerminar) {
+        std::string_view payload;
+        size_t consumido = 0;
+        int st = protocolo::lerFrame(s.leitura.data() + pos, s.leitura.size() - pos, payload, consumido);
+        if (st == 0) break;
+        if (st < 0) { fecharSessao(fd); return; }
+        pos += consumido;
+
+        s.in.clear();
+        s.in.str(std::string(payload));
+        if (!(s.in >> cmd)) {
+            protocolo::escreverResposta(s.escrita, protocolo::Ok, "");
+        } else if (cmd == "exit" || cmd == "shutdown") {
+            if (cmd == "shutdown") aTerminar = true;
+            protocolo::escreverResposta(s.escrita, protocolo::Fim, "A sair...\n");
+            s.fechar = true;
+            break;
+        } else {
+            size_t antes = s.shell.comandosInvalidos();
+            s.shell.executar(cmd);
+            std::string texto = s.out.str();
+            s.out.str(std::string());
+            protocolo::escreverResposta(s.escrita,
+                s.shell.comandosInvalidos() != antes ? protocolo::Invalido : protocolo::Ok, texto);
+        }
+    }
+    s.leitura.erase(0, pos);
+    escrever(fd);
+}
+
+void Daemon::escrever(int fd) {
+    Sessao& s = *sessoes[fd];
+    while (s.enviado < s.escrita.size()) {
+        ssize_t k = ::send(fd, s.escrita.data() + s.enviado, s.escrita.size() - s.enviado, MSG_NOSIGNAL);
+        if (k > 0) { s.enviado += static_cast<size_t>(k); continue; }
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // O cliente não está a ler: espera por EPOLLOUT em vez de bloquear o ciclo.
+            atualizarInteresse(fd, true);
+            return;
+        }
+        fecharSessao(fd);
+        return;
+    }
+    s.escrita.clear();
+    s.enviado = 0;
+    if (s.fechar) { fecharSessao(fd); return; }
+    atualizarInteresse(fd, false);
+}
+
+void Daemon::atualizarInteresse(int fd, bool querEscrever) {
+    Sessao& s = *sessoes[fd];
+    if (s.querEscrever == querEscrever) return;
+    s.querEscrever = querEscrever;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (querEscrever ? EPOLLOUT : 0u);
+    ev.data.fd = fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void Daemon::fecharSessao(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    sessoes.erase(fd);
+}
+#else
+// O modo daemon usa epoll e sockets Unix, disponíveis apenas em Linux.
+Daemon::~Daemon() {}
+bool Daemon::abrir(const std::string&) {
+    std::cerr << "O modo daemon so esta disponivel em Linux.\n";
+    return false;
+}
+void Daemon::run() {}
+void Daemon::parar() {}
+void Daemon::aceitar() {}
+void Daemon::ler(int) {}
+void Daemon::escrever(int) {}
+void Daemon::fecharSessao(int) {}
+void Daemon::atualizarInteresse(int, bool) {}
+#endif
@@ -0,0 +1,68 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+/**
+ * @file Daemon.hpp
+ * @brief Declara a classe Daemon (árvore residente servida por um socket Unix).
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include "Shell.hpp"
+#include "SistemaFicheiros.hpp"
+
+/**
+ * @class Daemon
+ * @brief Mantém a árvore em memória e executa comandos de vários clientes.
+ *
+ * Um único ciclo epoll aceita ligações e lê pedidos (ver Protocolo.hpp). Os
+ * comandos de todas as ligações são executados nessa thread, um de cada vez,
+ * por isso a árvore não precisa de locks; cada ligação tem a sua Shell (e a
+ * sua diretoria atual) sobre o mesmo SistemaFicheiros. Um cliente pode enviar
+ * vários pedidos de seguida: são todos executados antes de a resposta ser
+ * escrita, numa só chamada de sistema.
+ *
+ * Comandos especiais: "exit" fecha a ligação e "shutdown" pára o servidor.
+ */
+class Daemon {
+public:
+    /**
+     * @param opcoes autoLoad carrega sistema_saved.xml no arranque; autoSave grava-o ao parar.
+     */
+    explicit Daemon(Shell::Opcoes opcoes);
+    ~Daemon();
+    Daemon(const Daemon&) = delete;
+    Daemon& operator=(const Daemon&) = delete;
+
+    /** @brief Cria o socket em caminho (substituindo um socket antigo). */
+    bool abrir(const std::string& caminho);
+    /** @brief Serve pedidos até parar() ou ao comando shutdown. */
+    void run();
+    /** @brief Pede ao ciclo para terminar (seguro dentro de um handler de sinal). */
+    void parar();
+
+    /** @brief Árvore servida. */
+    SistemaFicheiros& sistema() { return sf; }
+
+private:
+    struct Sessao;
+
+    void aceitar();
+    void ler(int fd);
+    void escrever(int fd);
+    void fecharSessao(int fd);
+    void atualizarInteresse(int fd, bool querEscrever);
+
+    Shell::Opcoes opcoes;
+    SistemaFicheiros sf;
+    std::string caminhoSocket;
+    int listenFd = -1;
+    int epollFd = -1;
+    int paragemFd = -1; // eventfd usado por parar()
+    bool aTerminar = false;
+    std::unordered_map<int, std::unique_ptr<Sessao>> sessoes;
+};
+
+#endif // DAEMON_HPP
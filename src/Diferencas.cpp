@@ -0,0 +1,146 @@
+#include "Diferencas.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include "Perfil.hpp"
+
+namespace {
+
+// Par de diretorias com o mesmo caminho nas duas versões.
+struct Par {
+    const Directory* a;
+    const Directory* b;
+    std::string caminho;
+};
+
+// Nó que só existe de um lado (candidato a movimento).
+struct Pendente {
+    const File* f;
+    const Directory* d;
+    std::string caminho;
+};
+
+std::string juntar(const std::string& base, const std::string& nome, char sep) {
+    return base.empty() ? nome : base + sep + nome;
+}
+
+// Ordem por nome; nomes repetidos emparelham pelo tamanho e pela data.
+std::vector<const File*> ficheirosOrdenados(const Directory& d) {
+    std::vector<const File*> v;
+    v.reserve(d.getFiles().size());
+    for (const auto& f : d.getFiles()) v.push_back(f.get());
+    std::sort(v.begin(), v.end(), [](const File* x, const File* y) {
+        if (x->getName() != y->getName()) return x->getName() < y->getName();
+        if (x->getSize() != y->getSize()) return x->getSize() < y->getSize();
+        return x->getDate() < y->getDate();
+    });
+    return v;
+}
+
+std::vector<const Directory*> diretoriasOrdenadas(const Directory& d) {
+    std::vector<const Directory*> v;
+    v.reserve(d.getSubdirectories().size());
+    for (const auto& s : d.getSubdirectories()) v.push_back(s.get());
+    std::sort(v.begin(), v.end(), [](const Directory* x, const Directory* y) { return x->getName() < y->getName(); });
+    return v;
+}
+
+// Junta duas listas ordenadas pelo nome: soA(x), soB(y) ou ambos(x, y).
+template <typename T, typename SoA, typename SoB, typename Ambos>
+void emparelhar(const std::vector<T>& a, const std::vector<T>& b, SoA soA, SoB soB, Ambos ambos) {
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        int c = i == a.size() ? 1 : (j == b.size() ? -1 : a[i]->getName().compare(b[j]->getName()));
+        if (c < 0) soA(a[i++]);
+        else if (c > 0) soB(b[j++]);
+        else { ambos(a[i], b[j]); ++i; ++j; }
+    }
+}
+
+Diferencas::Alteracao entradaUnica(Diferencas::Alteracao::Tipo tipo, const Pendente& p) {
+    Diferencas::Alteracao alt;
+    alt.tipo = tipo;
+    alt.caminho = p.caminho;
+    if (p.f) {
+        alt.antes = alt.depois = p.f->getSize();
+    } else {
+        alt.diretoria = true;
+        alt.antes = alt.depois = p.d->getTotalSize();
+        alt.ficheiros = static_cast<uint64_t>(p.d->getTotalFiles());
+    }
+    return alt;
+}
+
+} // namespace
+
+Diferencas::Resultado Diferencas::comparar(const Directory& a, const Directory& b, char sep) {
+    perfil::Medida medida("Diferencas::comparar");
+    Resultado r;
+    if (a.digest() == b.digest()) return r;
+
+    std::vector<Pendente> saiu, entrou;
+    std::vector<Par> pilha{ {&a, &b, std::string()} };
+    while (!pilha.empty()) {
+        Par p = std::move(pilha.back());
+        pilha.pop_back();
+        r.diretoriasComparadas++;
+        perfil::nos(2 + p.a->getElementCount() + p.b->getElementCount());
+
+        emparelhar(ficheirosOrdenados(*p.a), ficheirosOrdenados(*p.b),
+            [&](const File* f) { saiu.push_back({f, nullptr, juntar(p.caminho, f->getName(), sep)}); },
+            [&](const File* f) { entrou.push_back({f, nullptr, juntar(p.caminho, f->getName(), sep)}); },
+            [&](const File* x, const File* y) {
+                if (x->getSize() == y->getSize() && x->getDate() == y->getDate()) return;
+                Alteracao alt;
+                alt.tipo = x->getSize() != y->getSize() ? Alteracao::Redimensionado : Alteracao::DataAlterada;
+                alt.caminho = juntar(p.caminho, x->getName(), sep);
+                alt.antes = x->getSize();
+                alt.depois = y->getSize();
+                r.alteracoes.push_back(std::move(alt));
+            });
+
+        emparelhar(diretoriasOrdenadas(*p.a), diretoriasOrdenadas(*p.b),
+            [&](const Directory* d) { saiu.push_back({nullptr, d, juntar(p.caminho, d->getName(), sep)}); },
+            [&](const Directory* d) { entrou.push_back({nullptr, d, juntar(p.caminho, d->getName(), sep)}); },
+            [&](const Directory* x, const Directory* y) {
+                if (x->digest() == y->digest()) { r.subarvoresIguais++; return; }
+                pilha.push_back({x, y, juntar(p.caminho, x->getName(), sep)});
+            });
+    }
+
+    // Movimentos: o mesmo ficheiro (nome, tamanho, data) ou a mesma subárvore
+    // (resumo) a sair de um sítio e a entrar noutro. Diretorias vazias só com o mesmo nome.
+    std::unordered_map<uint64_t, std::vector<size_t>> ficheirosSaidos, diretoriasSaidas;
+    for (size_t k = 0; k < saiu.size(); ++k) {
+        if (saiu[k].f) ficheirosSaidos[Directory::fileDigest(*saiu[k].f)].push_back(k);
+        else diretoriasSaidas[saiu[k].d->digest()].push_back(k);
+    }
+    std::vector<bool> movido(saiu.size(), false);
+    for (const Pendente& e : entrou) {
+        auto& mapa = e.f ? ficheirosSaidos : diretoriasSaidas;
+        auto it = mapa.find(e.f ? Directory::fileDigest(*e.f) : e.d->digest());
+        size_t origem = saiu.size();
+        if (it != mapa.end()) {
+            for (size_t k : it->second) {
+                if (movido[k]) continue;
+                if (e.d && e.d->getElementCount() == 0 && saiu[k].d->getName() != e.d->getName()) continue;
+                origem = k;
+                break;
+            }
+        }
+        if (origem == saiu.size()) {
+            r.alteracoes.push_back(entradaUnica(Alteracao::Adicionado, e));
+            continue;
+        }
+        movido[origem] = true;
+        Alteracao alt = entradaUnica(Alteracao::Movido, saiu[origem]);
+        alt.destino = e.caminho;
+        r.alteracoes.push_back(std::move(alt));
+    }
+    for (size_t k = 0; k < saiu.size(); ++k) {
+        if (!movido[k]) r.alteracoes.push_back(entradaUnica(Alteracao::Removido, saiu[k]));
+    }
+
+    std::sort(r.alteracoes.begin(), r.alteracoes.end(),
+        [](const Alteracao& x, const Alteracao& y) { return x.caminho < y.caminho; });
+    return r;
+}
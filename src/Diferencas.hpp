@@ -0,0 +1,56 @@
+#ifndef DIFERENCAS_HPP
+#define DIFERENCAS_HPP
+
+/**
+ * @file Diferencas.hpp
+ * @brief Declara a classe Diferencas (comparação de duas árvores pelos resumos Merkle).
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Directory.hpp"
+
+/**
+ * @class Diferencas
+ * @brief Lista o que mudou entre duas versões da árvore.
+ *
+ * As duas árvores são percorridas em paralelo, emparelhando os filhos pelo
+ * nome; uma subdiretoria com o mesmo resumo (Directory::digest) dos dois lados
+ * é saltada sem ser visitada, por isso, com os resumos já calculados, o
+ * trabalho é proporcional às diretorias alteradas e aos seus filhos diretos.
+ * Uma subárvore que só existe de um lado é reportada como uma única entrada.
+ *
+ * No fim, um ficheiro removido e um adicionado com o mesmo nome, tamanho e
+ * data, ou uma diretoria removida e uma adicionada com o mesmo resumo, passam
+ * a ser um só movimento.
+ */
+class Diferencas {
+public:
+    /** @brief Uma alteração entre a versão A e a versão B. */
+    struct Alteracao {
+        enum Tipo { Adicionado, Removido, Redimensionado, DataAlterada, Movido };
+        Tipo tipo = Adicionado;
+        bool diretoria = false;
+        std::string caminho;   ///< Relativo à raiz: em B para Adicionado, em A nos restantes.
+        std::string destino;   ///< Movido: caminho em B.
+        uint64_t antes = 0;    ///< Tamanho em A (diretorias: bytes da subárvore).
+        uint64_t depois = 0;   ///< Tamanho em B (diretorias: bytes da subárvore).
+        uint64_t ficheiros = 0;///< Diretorias: ficheiros na subárvore.
+    };
+
+    /** @brief Alterações (ordenadas pelo caminho) e quanto da árvore foi preciso ver. */
+    struct Resultado {
+        std::vector<Alteracao> alteracoes;
+        uint64_t diretoriasComparadas = 0; ///< Pares de diretorias com resumos diferentes.
+        uint64_t subarvoresIguais = 0;     ///< Subdiretorias saltadas por terem o mesmo resumo.
+    };
+
+    /**
+     * @brief Compara a árvore a (versão antiga) com b (versão nova).
+     * @param sep Separador dos caminhos devolvidos.
+     */
+    static Resultado comparar(const Directory& a, const Directory& b, char sep);
+};
+
+#endif // DIFERENCAS_HPP
@@ -3,25 +3,63 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include "Perfil.hpp"
+
+std::atomic<unsigned long long> Directory::structureCounter{0};
+std::atomic<unsigned long long> Directory::filesCounter{0};
+std::atomic<unsigned long long> Directory::relabelCounter{0};
+
+namespace {
+
+// Espaço de rótulos de uma árvore (a raiz fica com ele todo).
+constexpr uint64_t kRotuloMaximo = UINT64_MAX >> 1;
+// Uma subdiretoria nova precisa de pelo menos isto por diretoria que traz; abaixo, reetiqueta-se.
+constexpr uint64_t kParteMinima = 64;
+// Passo mínimo de uma reetiquetagem: sobe-se pelos antepassados até haver esta folga.
+constexpr uint64_t kPassoMinimo = 4096;
+
+std::atomic<uint32_t> proximaArvore{1};
+
+uint64_t contarDiretorias(const Directory& d) {
+    uint64_t n = 1;
+    for (const auto& s : d.getSubdirectories()) n += contarDiretorias(*s);
+    return n;
+}
+
+} // namespace
 
 // Construtor simples: guarda o nome e quem é o pai (se houver).
+// Até ser ligada a um pai, a diretoria é a raiz de uma árvore própria.
 Directory::Directory(const std::string& name, Directory* parent)
-    : name(name), parent(parent) {}
+    : name(name), parent(parent), rotuloInicio(0), rotuloLivre(1), rotuloFim(kRotuloMaximo),
+      rotuloArvore(proximaArvore.fetch_add(1, std::memory_order_relaxed)) {}
 
-std::string Directory::getName() const {
+const std::string& Directory::getName() const {
     return name;
 }
 
 void Directory::setName(const std::string& newName) {
     name = newName;
+    // O nome entra no resumo do pai, não no desta diretoria.
+    if (parent) parent->invalidateDigest();
+    ++structureCounter;
 }
 
 const std::vector<std::shared_ptr<Directory>>& Directory::getSubdirectories() const {
     return subdirectories;
 }
 
-const std::vector<std::shared_ptr<File>>& Directory::getFiles() const {
-    return files;
+const Directory::ListaFicheiros& Directory::getFiles() const {
+    static const ListaFicheiros vazia;
+    return files ? *files : vazia;
+}
+
+// Antes de alterar a lista: cria-a se ainda não existir e separa-a se for partilhada.
+Directory::ListaFicheiros& Directory::ficheirosParaEscrita() {
+    invalidateDigest();
+    if (!files) files = std::make_shared<ListaFicheiros>();
+    else if (files.use_count() > 1) files = std::make_shared<ListaFicheiros>(*files);
+    return *files;
 }
 
 Directory* Directory::getParent() const {
@@ -32,12 +70,18 @@ void Directory::addSubdirectory(const std::string& name) {
     // Cria a subdiretoria e define este nó como pai.
     auto newDir = std::make_shared<Directory>(name, this);
     subdirectories.push_back(newDir);
+    rotularFilho(*newDir);
+    invalidateDigest();
+    ++structureCounter;
 }
 
 void Directory::addSubdirectoryPtr(std::shared_ptr<Directory> dir) {
     if (!dir) return;
     dir->setParent(this);
     subdirectories.push_back(dir);
+    rotularFilho(*dir);
+    invalidateDigest();
+    ++structureCounter;
 }
 
 // Retira a subdiretoria dos filhos e devolve o ponteiro para poder anexar noutro sítio.
@@ -47,18 +91,23 @@ std::shared_ptr<Directory> Directory::takeSubdirectory(const std::string& name)
     if (it == subdirectories.end()) return nullptr;
     std::shared_ptr<Directory> ptr = *it;
     subdirectories.erase(it);
+    invalidateDigest();
+    ptr->setParent(nullptr);
+    ptr->rotularComoRaiz();
     return ptr;
 }
 
 void Directory::addFile(const std::string& name, size_t size) {
     // Cria um ficheiro com o tamanho indicado e adiciona-o.
     auto newFile = std::make_shared<File>(name, size);
-    files.push_back(newFile);
+    ficheirosParaEscrita().push_back(newFile);
+    ++filesCounter;
 }
 
 void Directory::addFilePtr(std::shared_ptr<File> fptr) {
     if (!fptr) return;
-    files.push_back(fptr);
+    ficheirosParaEscrita().push_back(fptr);
+    ++filesCounter;
 }
 
 void Directory::removeSubdirectory(const std::string& name) {
@@ -67,80 +116,125 @@ void Directory::removeSubdirectory(const std::string& name) {
         [&name](const auto& dir) { return dir->getName() == name; });
 
     if (it != subdirectories.end()) {
+        // Desliga o filho para que referências que sobrevivam não apontem para este nó
+        // (nem o contem como antepassado: só se reetiqueta se alguém a mantiver viva).
+        (*it)->setParent(nullptr);
+        if (it->use_count() > 1) (*it)->rotularComoRaiz();
         subdirectories.erase(it);
+        invalidateDigest();
     }
 }
 
 void Directory::removeFile(const std::string& name) {
     // Remove o primeiro ficheiro com o nome correspondente.
-    auto it = std::find_if(files.begin(), files.end(),
+    const auto& atual = getFiles();
+    auto it = std::find_if(atual.begin(), atual.end(),
         [&name](const auto& file) { return file->getName() == name; });
-    if (it != files.end()) {
-        files.erase(it);
+    if (it != atual.end()) {
+        // Só separa a lista partilhada quando há mesmo algo a remover.
+        size_t pos = static_cast<size_t>(it - atual.begin());
+        auto& lista = ficheirosParaEscrita();
+        lista.erase(lista.begin() + pos);
+        ++filesCounter;
     }
 }
 
-std::shared_ptr<Directory> Directory::findSubdirectory(const std::string& name) const {
+std::shared_ptr<Directory> Directory::findSubdirectory(std::string_view name) const {
     auto it = std::find_if(subdirectories.begin(), subdirectories.end(),
         [&name](const auto& dir) { return dir->getName() == name; });
     return (it != subdirectories.end()) ? *it : nullptr;
 }
 
+// Cópia da subárvore: as diretorias são novas, as listas de ficheiros são partilhadas
+// (e separadas na primeira alteração de qualquer dos lados).
+// A cópia é outra árvore (rotuloArvore novo, mesmo com newParent) até ser ligada e
+// reetiquetada por rotularFilho; até lá nunca é antepassada nem descendente da original.
+std::shared_ptr<Directory> Directory::clone(Directory* newParent) const {
+    return clonar(newParent, proximaArvore.fetch_add(1, std::memory_order_relaxed));
+}
+
+std::shared_ptr<Directory> Directory::clonar(Directory* newParent, uint32_t arvore) const {
+    auto copy = std::make_shared<Directory>(name, newParent);
+    copy->files = files;
+    // Mesmo conteúdo: o resumo (se já calculado) também serve à cópia.
+    copy->resumo = resumo;
+    copy->resumoValido = resumoValido;
+    copy->resumoVersaoFicheiros = resumoVersaoFicheiros;
+    // Os intervalos da original continuam válidos entre si (a forma é a mesma).
+    copy->rotuloInicio = rotuloInicio;
+    copy->rotuloLivre = rotuloLivre;
+    copy->rotuloFim = rotuloFim;
+    copy->rotuloArvore = arvore;
+    copy->subdirectories.reserve(subdirectories.size());
+    for (const auto& d : subdirectories) copy->subdirectories.push_back(d->clonar(copy.get(), arvore));
+    return copy;
+}
+
 void Directory::setParent(Directory* p) {
     parent = p;
+    ++structureCounter;
 }
 
 std::shared_ptr<File> Directory::findFile(const std::string& name) const {
-    auto it = std::find_if(files.begin(), files.end(),
+    const auto& fs = getFiles();
+    auto it = std::find_if(fs.begin(), fs.end(),
         [&name](const auto& f) { return f->getName() == name; });
-    return (it != files.end()) ? *it : nullptr;
+    return (it != fs.end()) ? *it : nullptr;
 }
 
 void Directory::listContents() const {
+    listContents(std::cout);
+}
+
+void Directory::listContents(std::ostream& out) const {
     // Impressão amigável do conteúdo direto.
-    std::cout << "Diretoria: " << name << "\n";
+    out << "Diretoria: " << name << "\n";
 
-    std::cout << "Subdiretorias:\n";
+    out << "Subdiretorias:\n";
     for (const auto& dir : subdirectories) {
-        std::cout << "  " << dir->getName() << "/\n";
+        out << "  " << dir->getName() << "/\n";
     }
 
-    std::cout << "Ficheiros:\n";
-    for (const auto& file : files) {
-        std::cout << "  " << file->getName() << " (" << file->getSize() << " bytes)";
-        if (!file->getDate().empty()) std::cout << " - " << file->getDate();
-        std::cout << "\n";
+    out << "Ficheiros:\n";
+    for (const auto& file : getFiles()) {
+        out << "  " << file->getName() << " (" << file->getSize() << " bytes)";
+        if (!file->getDate().empty()) out << " - " << file->getDate();
+        out << "\n";
     }
 }
 
 size_t Directory::getTotalSize() const {
+    perfil::nos(1 + getFiles().size());
     size_t total = 0;
-    for (const auto& file : files) total += file->getSize();
+    for (const auto& file : getFiles()) total += file->getSize();
     for (const auto& dir : subdirectories) total += dir->getTotalSize();
     return total;
 }
 
 int Directory::getTotalFiles() const {
-    int total = static_cast<int>(files.size());
+    perfil::nos();
+    int total = static_cast<int>(getFiles().size());
     for (const auto& dir : subdirectories) total += dir->getTotalFiles();
     return total;
 }
 
 int Directory::getTotalDirectories() const {
+    perfil::nos();
     int total = 1; // conta-se a própria
     for (const auto& dir : subdirectories) total += dir->getTotalDirectories();
     return total;
 }
 
 int Directory::getElementCount() const {
-    return static_cast<int>(subdirectories.size() + files.size());
+    return static_cast<int>(subdirectories.size() + getFiles().size());
 }
 
 std::shared_ptr<File> Directory::findLargestFile() const {
     // Procura recursivamente o maior ficheiro.
+    perfil::nos(1 + getFiles().size());
     std::shared_ptr<File> best = nullptr;
     size_t bestSize = 0;
-    for (const auto& f : files) {
+    for (const auto& f : getFiles()) {
         if (!best || f->getSize() > bestSize) {
             best = f;
             bestSize = f->getSize();
@@ -156,70 +250,62 @@ std::shared_ptr<File> Directory::findLargestFile() const {
     return best;
 }
 
-std::pair<std::string, size_t> Directory::findLargestFileWithPath(const std::string& currentPath) const {
-    // Igual ao anterior mas devolve também o caminho construído.
-    std::string bestPath;
-    size_t bestSize = 0;
-    bool found = false;
-
-    for (const auto& file : files) {
-        size_t s = file->getSize();
-        std::string p = currentPath.empty() ? file->getName() : currentPath + "\\" + file->getName();
-        if (!found || s > bestSize) {
-            found = true;
-            bestSize = s;
-            bestPath = p;
+NodeRef Directory::findLargestFileRef() const {
+    // Igual ao anterior mas devolve a referência (diretoria + ficheiro) em vez de copiar caminhos.
+    perfil::nos(1 + getFiles().size());
+    NodeRef best;
+    for (const auto& file : getFiles()) {
+        if (!best.file || file->getSize() > best.file->getSize()) {
+            best.dir = this;
+            best.file = file.get();
         }
     }
-
     for (const auto& dir : subdirectories) {
-        std::string subPath = currentPath.empty() ? dir->getName() : currentPath + "\\" + dir->getName();
-        auto [childPath, childSize] = dir->findLargestFileWithPath(subPath);
-        if (!childPath.empty() && (!found || childSize > bestSize)) {
-            found = true;
-            bestSize = childSize;
-            bestPath = childPath;
+        NodeRef cand = dir->findLargestFileRef();
+        if (cand.file && (!best.file || cand.file->getSize() > best.file->getSize())) {
+            best = cand;
         }
     }
-
-    return found ? std::make_pair(bestPath, bestSize) : std::make_pair(std::string(), static_cast<size_t>(0));
+    return best;
 }
 
-void Directory::findAllDirectories(const std::string& name, std::list<std::string>& paths, const std::string& currentPath) {
-    // Se o nome corresponder, adiciona o caminho; depois continua pela subárvore.
-    std::string newPath = currentPath.empty() ? this->name : currentPath + "\\" + this->name;
+void Directory::findAllDirectories(const std::string& name, std::vector<NodeRef>& out) const {
+    // Se o nome corresponder, guarda a referência; depois continua pela subárvore.
+    perfil::nos();
     if (this->name == name) {
-        paths.push_back(newPath);
+        out.push_back({this, nullptr});
     }
     for (const auto& d : subdirectories) {
-        d->findAllDirectories(name, paths, newPath);
+        d->findAllDirectories(name, out);
     }
 }
 
-void Directory::findAllFiles(const std::string& name, std::list<std::string>& paths, const std::string& currentPath) {
-    // Adiciona todos os caminhos dos ficheiros com o nome pedido nesta subárvore.
-    std::string base = currentPath.empty() ? this->name : currentPath + "\\" + this->name;
-    for (const auto& f : files) {
+void Directory::findAllFiles(const std::string& name, std::vector<NodeRef>& out) const {
+    // Guarda referências para todos os ficheiros com o nome pedido nesta subárvore.
+    perfil::nos(1 + getFiles().size());
+    for (const auto& f : getFiles()) {
         if (f->getName() == name) {
-            paths.push_back(base + "\\" + f->getName());
+            out.push_back({this, f.get()});
         }
     }
     for (const auto& d : subdirectories) {
-        d->findAllFiles(name, paths, base);
+        d->findAllFiles(name, out);
     }
 }
 
 bool Directory::containsFile(const std::string& name) const {
-    for (const auto& f : files) if (f->getName() == name) return true;
+    perfil::nos(1 + getFiles().size());
+    for (const auto& f : getFiles()) if (f->getName() == name) return true;
     for (const auto& d : subdirectories) if (d->containsFile(name)) return true;
     return false;
 }
 
 void Directory::generateTree(std::ostream& out, const std::string& prefix) const {
     // Desenha uma árvore textual com dois espaços por nível.
+    perfil::nos(1 + getFiles().size());
     out << prefix << getName() << "/\n";
     std::string childPrefix = prefix + "  ";
-    for (const auto& f : files) {
+    for (const auto& f : getFiles()) {
         out << childPrefix << f->getName() << " (" << f->getSize() << ")\n";
     }
     for (const auto& d : subdirectories) {
@@ -227,11 +313,145 @@ void Directory::generateTree(std::ostream& out, const std::string& prefix) const
     }
 }
 
+// Um descendente tem o intervalo estritamente dentro do do antepassado.
 bool Directory::isSubdirectoryOf(const Directory* other) const {
-    const Directory* cur = parent;
-    while (cur) {
-        if (cur == other) return true;
-        cur = cur->getParent();
+    return other && other->rotuloArvore == rotuloArvore && other->rotuloInicio < rotuloInicio &&
+           rotuloFim < other->rotuloFim;
+}
+
+// Cada subdiretoria nova fica com espaço / (irmãos + 1) do que resta: os irmãos
+// seguintes ficam com partes cada vez menores mas não a metade de cada vez, e a
+// primeira subdiretoria de cada nível ainda fica com metade (para a sua descendência).
+void Directory::rotularFilho(Directory& f) {
+    const uint64_t n = f.subdirectories.empty() ? 1 : contarDiretorias(f);
+    const uint64_t parte = (rotuloFim - rotuloLivre) / (subdirectories.size() + 1);
+    if (parte / n >= kParteMinima) {
+        const uint64_t inicio = rotuloLivre;
+        rotuloLivre += parte;
+        if (n == 1) {
+            f.rotuloInicio = inicio;
+            f.rotuloLivre = inicio + 1;
+            f.rotuloFim = inicio + parte - 1;
+            f.rotuloArvore = rotuloArvore;
+        } else {
+            f.reetiquetar(inicio, inicio + parte - 1, rotuloArvore, n);
+        }
+        return;
     }
-    return false;
+    // Sem espaço: sobe até ao antepassado cujo intervalo chega para a subárvore
+    // com folga e redistribui-o. Só se contam as subárvores dos irmãos pelo caminho.
+    Directory* a = this;
+    uint64_t total = contarDiretorias(*this);
+    while (a->parent && (a->rotuloFim - a->rotuloInicio) / (3 * total) < kPassoMinimo) {
+        Directory* p = a->parent;
+        uint64_t m = 1;
+        for (const auto& s : p->subdirectories) m += s.get() == a ? total : contarDiretorias(*s);
+        a = p;
+        total = m;
+    }
+    if (!a->parent) {
+        // A raiz é dona do espaço todo (uma cópia feita por clone() começa com o intervalo da original).
+        a->rotuloInicio = 0;
+        a->rotuloFim = kRotuloMaximo;
+    }
+    a->reetiquetar(a->rotuloInicio, a->rotuloFim, a->rotuloArvore, total);
+}
+
+void Directory::rotularComoRaiz() {
+    reetiquetar(0, kRotuloMaximo, proximaArvore.fetch_add(1, std::memory_order_relaxed), contarDiretorias(*this));
+}
+
+// Pré-ordem com passo fixo: cada diretoria ocupa um passo no início e fica com
+// (1 + filhos) passos livres no fim, porque as que já têm mais filhos são as que
+// mais provavelmente recebem outros.
+void Directory::reetiquetar(uint64_t inicio, uint64_t fim, uint32_t arvore, uint64_t n) {
+    ++relabelCounter;
+    perfil::nos(n);
+    const uint64_t passo = (fim - inicio) / (3 * n);
+    uint64_t c = inicio;
+    auto visitar = [&](auto& self, Directory& d) -> void {
+        d.rotuloInicio = c;
+        d.rotuloArvore = arvore;
+        c += passo;
+        for (const auto& s : d.subdirectories) self(self, *s);
+        d.rotuloLivre = c;
+        c += passo * (1 + d.subdirectories.size());
+        d.rotuloFim = c - 1;
+    };
+    visitar(visitar, *this);
+    rotuloInicio = inicio;
+    rotuloFim = fim;
+}
+
+// Um antepassado de uma diretoria desatualizada também está desatualizado,
+// por isso a subida pára no primeiro que já o esteja.
+void Directory::invalidateDigest() {
+    for (Directory* d = this; d && d->resumoValido; d = d->parent) d->resumoValido = false;
+}
+
+// Finalizador do splitmix64: espalha os bits antes de somar os resumos dos filhos.
+static uint64_t misturar(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t resumoTexto(const std::string& s) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+    return misturar(h ^ s.size());
+}
+
+uint64_t Directory::fileDigest(const File& f) {
+    uint64_t h = resumoTexto(f.getName());
+    h = misturar(h ^ misturar(static_cast<uint64_t>(f.getSize()) ^ 0x46494c45ull));
+    return misturar(h ^ resumoTexto(f.getDate()));
+}
+
+// Os filhos entram por soma (módulo 2^64) dos seus resumos misturados, que não
+// depende da ordem; as contagens distinguem, por exemplo, listas vazias.
+// Ficheiros alterados diretamente (File::setName/setDate) não sabem em que
+// diretoria estão, por isso a versão global dos ficheiros também é verificada.
+uint64_t Directory::digest() const {
+    unsigned long long versao = File::modificationVersion();
+    if (resumoValido && resumoVersaoFicheiros == versao) return resumo;
+    perfil::nos(1 + getFiles().size());
+    uint64_t soma = 0;
+    for (const auto& f : getFiles()) soma += misturar(fileDigest(*f) ^ 0x46ull);
+    for (const auto& d : subdirectories) soma += misturar(resumoTexto(d->name) ^ misturar(d->digest() ^ 0x44ull));
+    resumo = misturar(soma ^ misturar(getFiles().size() * 0x100000001b3ull + subdirectories.size()));
+    resumoValido = true;
+    resumoVersaoFicheiros = versao;
+    return resumo;
+}
+
+unsigned long long Directory::structureVersion() {
+    return structureCounter;
+}
+
+unsigned long long Directory::relabelCount() {
+    return relabelCounter;
+}
+
+unsigned long long Directory::contentVersion() {
+    return structureCounter + filesCounter;
+}
+
+// Acrescenta um segmento, evitando separador duplo depois de uma raiz como "/".
+static void appendSegment(std::string& out, const std::string& seg, char sep) {
+    if (!out.empty() && out.back() != '/' && out.back() != '\\') out.push_back(sep);
+    out += seg;
+}
+
+static void appendDirPath(const Directory* dir, std::string& out, char sep, const Directory* base) {
+    if (!dir || dir == base) return;
+    appendDirPath(dir->getParent(), out, sep, base);
+    appendSegment(out, dir->getName(), sep);
+}
+
+void Directory::renderPath(const NodeRef& ref, std::string& out, char sep, const Directory* base) {
+    out.clear();
+    appendDirPath(ref.dir, out, sep, base);
+    if (ref.file) appendSegment(out, ref.file->getName(), sep);
 }
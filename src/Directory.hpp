@@ -6,23 +6,81 @@
  * @brief Declara a classe Directory (nó da árvore de diretórios).
  */
 
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <list>
 #include <ostream>
 #include "File.hpp"
 
+class Directory;
+
+/**
+ * @struct NodeRef
+ * @brief Referência leve a um nó da árvore, usada como resultado das pesquisas.
+ * @details O caminho só é construído quando é pedido (Directory::renderPath).
+ */
+struct NodeRef {
+    const Directory* dir = nullptr; ///< Diretoria (ou a diretoria que contém o ficheiro).
+    const File* file = nullptr;     ///< Ficheiro, ou nullptr se o nó é a própria diretoria.
+};
+
 /**
  * @class Directory
  * @brief Nó da árvore: guarda subdiretorias, ficheiros e ponteiro para o pai.
  */
 class Directory {
+    // Aplica alterações em bloco diretamente às listas (ver Lote.hpp).
+    friend class Lote;
+    // Mede e compacta os vetores e os nomes (ver Ocupacao.hpp).
+    friend class Ocupacao;
+
+public:
+    /** @brief Lista de ficheiros de uma diretoria. */
+    using ListaFicheiros = std::vector<std::shared_ptr<File>>;
+
 private:
     std::string name;
     std::vector<std::shared_ptr<Directory>> subdirectories;
-    std::vector<std::shared_ptr<File>> files;
+    // Partilhada (copy-on-write) entre as cópias feitas por clone(); nullptr se vazia.
+    // Os File de uma lista partilhada não são alterados: substituem-se por entradas novas.
+    std::shared_ptr<ListaFicheiros> files;
     Directory* parent;
+    // Resumo Merkle da subárvore, calculado em digest() e guardado até haver alterações.
+    mutable uint64_t resumo = 0;
+    mutable bool resumoValido = false;
+    mutable unsigned long long resumoVersaoFicheiros = 0;
+    // Rótulos de intervalo (pré/pós-ordem com folgas): a subárvore ocupa [rotuloInicio, rotuloFim]
+    // e as subdiretorias novas recebem uma parte de [rotuloLivre, rotuloFim). rotuloArvore
+    // distingue árvores diferentes, cujos intervalos se podem sobrepor.
+    uint64_t rotuloInicio;
+    uint64_t rotuloLivre;
+    uint64_t rotuloFim;
+    uint32_t rotuloArvore;
+
+    // Contador global incrementado sempre que a estrutura de diretorias muda
+    // (atómico: tarefas em segundo plano também constroem árvores).
+    static std::atomic<unsigned long long> structureCounter;
+    // Contador global incrementado quando a lista de ficheiros de uma diretoria muda.
+    static std::atomic<unsigned long long> filesCounter;
+    // Subárvores reetiquetadas por falta de espaço nos intervalos.
+    static std::atomic<unsigned long long> relabelCounter;
+
+    // Lista pronta a alterar (criada ou separada da cópia partilhada se for preciso).
+    ListaFicheiros& ficheirosParaEscrita();
+    // Marca o resumo desta diretoria e dos antepassados como desatualizado.
+    void invalidateDigest();
+    // Dá um intervalo à subdiretoria f, já ligada a este nó (reetiqueta um antepassado se não houver espaço).
+    void rotularFilho(Directory& f);
+    // A subárvore desligada passa a ser uma árvore própria, com o espaço de rótulos todo.
+    void rotularComoRaiz();
+    // Distribui [inicio, fim] pela subárvore (n diretorias), com folgas proporcionais ao número de filhos.
+    void reetiquetar(uint64_t inicio, uint64_t fim, uint32_t arvore, uint64_t n);
+    // Cópia recursiva de clone(): os mesmos intervalos relativos, todos na árvore arvore.
+    std::shared_ptr<Directory> clonar(Directory* newParent, uint32_t arvore) const;
 
 public:
     /**
@@ -33,13 +91,13 @@ public:
     Directory(const std::string& name, Directory* parent = nullptr);
 
     /** @brief Obtém o nome da diretoria. */
-    std::string getName() const;
+    const std::string& getName() const;
     /** @brief Atualiza o nome da diretoria. */
     void setName(const std::string& newName);
     /** @brief Lista de subdiretorias diretas. */
     const std::vector<std::shared_ptr<Directory>>& getSubdirectories() const;
     /** @brief Lista de ficheiros diretos. */
-    const std::vector<std::shared_ptr<File>>& getFiles() const;
+    const ListaFicheiros& getFiles() const;
     /** @brief Ponteiro para o pai (ou nullptr se raiz). */
     Directory* getParent() const;
 
@@ -62,13 +120,20 @@ public:
     /** @brief Remove um ficheiro pelo nome. */
     void removeFile(const std::string& name);
     /** @brief Procura uma subdiretoria pelo nome. */
-    std::shared_ptr<Directory> findSubdirectory(const std::string& name) const;
+    std::shared_ptr<Directory> findSubdirectory(std::string_view name) const;
+    /**
+     * @brief Copia a subárvore em O(diretorias): as listas de ficheiros ficam partilhadas.
+     * @param newParent Pai da cópia.
+     */
+    std::shared_ptr<Directory> clone(Directory* newParent = nullptr) const;
     /** @brief Atualiza o ponteiro para o pai. */
     void setParent(Directory* p);
     /** @brief Procura um ficheiro pelo nome. */
     std::shared_ptr<File> findFile(const std::string& name) const;
     /** @brief Imprime subdiretorias e ficheiros desta diretoria. */
     void listContents() const;
+    /** @brief Escreve em out as subdiretorias e ficheiros desta diretoria. */
+    void listContents(std::ostream& out) const;
     /** @brief Soma recursiva dos tamanhos dos ficheiros sob esta diretoria. */
     size_t getTotalSize() const;
     /** @brief Conta recursivamente todos os ficheiros. */
@@ -79,22 +144,55 @@ public:
     int getElementCount() const;
     /** @brief Procura o ficheiro maior na subárvore. */
     std::shared_ptr<File> findLargestFile() const;
-    /**
-     * @brief Procura o maior ficheiro e devolve também o caminho absoluto.
-     * @param currentPath Prefixo de caminho usado na recursão.
-     * @return Par (caminho, tamanho). Se não existir, caminho vazio e tamanho 0.
-     */
-    std::pair<std::string, size_t> findLargestFileWithPath(const std::string& currentPath = "") const;
-    /** @brief Lista todos os caminhos de diretorias com o nome indicado. */
-    void findAllDirectories(const std::string& name, std::list<std::string>& paths, const std::string& currentPath = "");
-    /** @brief Lista todos os caminhos de ficheiros com o nome indicado. */
-    void findAllFiles(const std::string& name, std::list<std::string>& paths, const std::string& currentPath = "");
+    /** @brief Referência para o ficheiro maior na subárvore (file == nullptr se não existir). */
+    NodeRef findLargestFileRef() const;
+    /** @brief Junta a out as diretorias da subárvore com o nome indicado. */
+    void findAllDirectories(const std::string& name, std::vector<NodeRef>& out) const;
+    /** @brief Junta a out os ficheiros da subárvore com o nome indicado. */
+    void findAllFiles(const std::string& name, std::vector<NodeRef>& out) const;
     /** @brief Indica se existe um ficheiro com o nome dado na subárvore. */
     bool containsFile(const std::string& name) const;
     /** @brief Gera uma representação textual em árvore com indentação. */
     void generateTree(std::ostream& out, const std::string& prefix = "") const;
-    /** @brief Verifica se esta diretoria é descendente de outra. */
+    /**
+     * @brief Verifica se esta diretoria é descendente de outra.
+     * @details O(1): compara os intervalos de rótulos, sem subir pelos pais.
+     */
     bool isSubdirectoryOf(const Directory* other) const;
+    /** @brief Primeiro rótulo da subárvore (os descendentes têm rótulos em ]labelBegin, labelEnd[). */
+    uint64_t labelBegin() const { return rotuloInicio; }
+    /** @brief Último rótulo da subárvore. */
+    uint64_t labelEnd() const { return rotuloFim; }
+    /** @brief Número de reetiquetagens de subárvores (por falta de folga) desde o arranque. */
+    static unsigned long long relabelCount();
+
+    /**
+     * @brief Resumo (Merkle) da subárvore: nomes, tamanhos e datas de todos os descendentes.
+     * @details Não depende do nome da própria diretoria nem da ordem dos filhos, por isso
+     *          uma diretoria movida ou renomeada mantém o resumo. É calculado só quando é
+     *          pedido e guardado; uma alteração invalida apenas a diretoria alterada e os
+     *          seus antepassados, e o cálculo seguinte só desce pelas desatualizadas.
+     */
+    uint64_t digest() const;
+    /** @brief Resumo de um ficheiro (nome, tamanho e data), tal como entra no da diretoria. */
+    static uint64_t fileDigest(const File& f);
+
+    /**
+     * @brief Escreve em out o caminho do nó, subindo pelos ponteiros parent.
+     * @param ref Nó a materializar.
+     * @param out Buffer reutilizável (é limpo antes de escrever).
+     * @param sep Separador entre segmentos.
+     * @param base Se indicada, o caminho é relativo a esta diretoria (exclusive).
+     */
+    static void renderPath(const NodeRef& ref, std::string& out, char sep, const Directory* base = nullptr);
+
+    /**
+     * @brief Versão da estrutura de diretorias (criar, remover, mover, renomear).
+     * @details Usada pelas caches de caminhos para saber quando revalidar.
+     */
+    static unsigned long long structureVersion();
+    /** @brief Versão do conteúdo (estrutura + listas de ficheiros de todas as diretorias). */
+    static unsigned long long contentVersion();
 };
 
 #endif // DIRECTORY_HPP
@@ -0,0 +1,197 @@
+#include "EscritaBlocos.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Perfil.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace {
+
+constexpr size_t kBlocoMinimo = 8192;   // Nós: abaixo disto não compensa repartir.
+constexpr size_t kBlocoMaximo = 131072; // Nós: limita a memória de cada buffer (cerca de 8 MB).
+constexpr size_t kBlocoSerie = 65536;   // Nós por bloco com uma só thread (só para não juntar tudo em memória).
+constexpr size_t kBlocosPorThread = 8;  // Blocos mais pequenos equilibram melhor as threads.
+constexpr size_t kJanelaPorThread = 4;  // Blocos formatados à espera de escrita, por thread.
+constexpr size_t kMaxIov = 64;          // Buffers por writev.
+
+// ----------------------------------------
+// Ficheiro de saída: writev em Linux, ofstream nos outros sistemas.
+class Saida {
+public:
+    ~Saida() { fechar(); }
+
+    bool abrir(const std::string& nome) {
+#ifdef __linux__
+        fd = ::open(nome.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        return fd >= 0;
+#else
+        ofs.open(nome, std::ios::binary);
+        return ofs.is_open();
+#endif
+    }
+
+    // Escreve os buffers pela ordem (um writev por kMaxIov buffers, retomando escritas parciais).
+    bool escrever(std::string* bufs, size_t n) {
+#ifdef __linux__
+        struct iovec iov[kMaxIov];
+        for (size_t base = 0; base < n; base += kMaxIov) {
+            size_t cnt = std::min(kMaxIov, n - base);
+            for (size_t i = 0; i < cnt; ++i) {
+                iov[i].iov_base = const_cast<char*>(bufs[base + i].data());
+                iov[i].iov_len = bufs[base + i].size();
+            }
+            size_t i = 0;
+            while (i < cnt) {
+                ssize_t r = ::writev(fd, iov + i, static_cast<int>(cnt - i));
+                perfil::chamadas();
+                if (r < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                bytes += static_cast<uint64_t>(r);
+                size_t resto = static_cast<size_t>(r);
+                while (i < cnt && resto >= iov[i].iov_len) { resto -= iov[i].iov_len; ++i; }
+                if (i < cnt) {
+                    iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + resto;
+                    iov[i].iov_len -= resto;
+                }
+            }
+        }
+        return true;
+#else
+        for (size_t i = 0; i < n; ++i) {
+            ofs.write(bufs[i].data(), static_cast<std::streamsize>(bufs[i].size()));
+            bytes += bufs[i].size();
+        }
+        return static_cast<bool>(ofs);
+#endif
+    }
+
+    bool fechar() {
+#ifdef __linux__
+        if (fd < 0) return true;
+        int r = ::close(fd);
+        fd = -1;
+        return r == 0;
+#else
+        if (!ofs.is_open()) return true;
+        ofs.close();
+        return !ofs.fail();
+#endif
+    }
+
+    uint64_t bytes = 0;
+
+private:
+#ifdef __linux__
+    int fd = -1;
+#else
+    std::ofstream ofs;
+#endif
+};
+
+} // namespace
+
+EscritaBlocos::EscritaBlocos(size_t threads) : nThreads(threads) {
+    if (nThreads == 0) nThreads = std::min<size_t>(8, std::max(1u, std::thread::hardware_concurrency()));
+}
+
+size_t EscritaBlocos::tamanhoBloco(uint64_t total) const {
+    if (nThreads <= 1) return kBlocoSerie;
+    return static_cast<size_t>(std::clamp<uint64_t>(total / (nThreads * kBlocosPorThread) + 1, kBlocoMinimo, kBlocoMaximo));
+}
+
+// A thread que chama só escreve; as outras formatam os blocos pela ordem,
+// sem passar mais de uma janela à frente do último bloco escrito.
+bool EscritaBlocos::escrever(const std::string& nome, size_t n, const Formatar& formatar,
+                             const std::function<uint64_t(size_t)>& fim, Progresso* prog) const {
+    Saida saida;
+    if (!saida.abrir(nome)) return false;
+    bool ok = true, cancelado = false;
+    auto progresso = [&](size_t escritos) {
+        if (!prog) return;
+        if (fim) prog->entradas.store(fim(escritos), std::memory_order_relaxed);
+        prog->bytes.store(saida.bytes, std::memory_order_relaxed);
+    };
+
+    if (nThreads <= 1 || n <= 2) {
+        for (size_t k = 0; k < n && ok; ++k) {
+            if (prog && prog->cancelado()) { cancelado = true; break; }
+            std::string buf;
+            formatar(k, buf);
+            ok = saida.escrever(&buf, 1);
+            progresso(k + 1);
+        }
+    } else {
+        std::vector<std::string> bufs(n);
+        std::vector<char> pronto(n, 0);
+        std::mutex mtx;
+        std::condition_variable cvPronto, cvJanela;
+        size_t proximo = 0, escritos = 0;
+        bool parar = false;
+        const size_t janela = nThreads * kJanelaPorThread;
+
+        auto trabalhador = [&] {
+            for (;;) {
+                size_t k;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cvJanela.wait(lock, [&] { return parar || proximo >= n || proximo < escritos + janela; });
+                    if (parar || proximo >= n) return;
+                    k = proximo++;
+                }
+                std::string out;
+                formatar(k, out);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    bufs[k] = std::move(out);
+                    pronto[k] = 1;
+                }
+                cvPronto.notify_one();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < nThreads; ++t) pool.emplace_back(trabalhador);
+
+        std::vector<std::string> lote;
+        for (size_t k = 0; k < n;) {
+            lote.clear();
+            {
+                // O bloco k já foi atribuído (está dentro da janela), por isso acaba por ficar pronto.
+                std::unique_lock<std::mutex> lock(mtx);
+                cvPronto.wait(lock, [&] { return pronto[k] != 0; });
+                for (size_t j = k; j < n && pronto[j] && lote.size() < kMaxIov; ++j) lote.push_back(std::move(bufs[j]));
+            }
+            ok = saida.escrever(lote.data(), lote.size());
+            k += lote.size();
+            cancelado = prog && prog->cancelado();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                escritos = k;
+                if (!ok || cancelado) parar = true;
+            }
+            cvJanela.notify_all();
+            progresso(k);
+            if (!ok || cancelado) break;
+        }
+        for (auto& t : pool) t.join();
+    }
+
+    ok = saida.fechar() && ok;
+    if (cancelado) {
+        std::remove(nome.c_str());
+        return false;
+    }
+    return ok;
+}
@@ -0,0 +1,52 @@
+#ifndef ESCRITABLOCOS_HPP
+#define ESCRITABLOCOS_HPP
+
+/**
+ * @file EscritaBlocos.hpp
+ * @brief Declara a classe EscritaBlocos (ficheiro escrito por blocos formatados em paralelo).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "Tarefas.hpp"
+
+/**
+ * @class EscritaBlocos
+ * @brief Escreve um ficheiro feito de n blocos independentes, formatados por várias threads.
+ *
+ * Cada thread formata um bloco num buffer próprio; a thread que chama escreve
+ * os buffers pela ordem, vários de cada vez com writev, e liberta-os. Só uma
+ * janela de blocos à frente do último escrito pode estar em memória; com uma
+ * só thread os blocos são formatados e escritos um a um. Como os blocos são
+ * escritos pela ordem, os mesmos blocos dão o mesmo ficheiro com qualquer
+ * número de threads.
+ */
+class EscritaBlocos {
+public:
+    /** @brief Formata o bloco k em out (out chega vazio). */
+    using Formatar = std::function<void(size_t k, std::string& out)>;
+
+    /** @param threads Threads de formatação (0 = uma por núcleo, até 8). */
+    explicit EscritaBlocos(size_t threads = 0);
+
+    /**
+     * @brief Escreve os blocos 0..n-1 em ficheiro.
+     * @param fim Para o progresso: número de nós escritos depois dos primeiros k blocos (pode ser vazio).
+     * @param prog Progresso (nós e bytes escritos) e cancelamento; cancelada, o ficheiro parcial é apagado.
+     * @return false se o ficheiro não pôde ser escrito ou a escrita foi cancelada.
+     */
+    bool escrever(const std::string& ficheiro, size_t n, const Formatar& formatar,
+                  const std::function<uint64_t(size_t)>& fim = nullptr, Progresso* prog = nullptr) const;
+
+    /** @brief Nós por bloco para total nós (blocos mais pequenos quando há mais threads). */
+    size_t tamanhoBloco(uint64_t total) const;
+    /** @brief Número de threads de formatação. */
+    size_t threads() const { return nThreads; }
+
+private:
+    size_t nThreads;
+};
+
+#endif // ESCRITABLOCOS_HPP
@@ -0,0 +1,200 @@
+#include "EscritorXml.hpp"
+#include <algorithm>
+#include <charconv>
+#include <vector>
+#include "Perfil.hpp"
+
+namespace {
+
+const char* const kCabecalho = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+
+// ----------------------------------------
+// Formatação (partilhada por todos os blocos, o que garante o mesmo resultado)
+void escapar(std::string& out, const std::string& s) {
+    for (char c : s) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&apos;"; break;
+            default: out += c; break;
+        }
+    }
+}
+
+void abrir(std::string& out, const std::string& nome, size_t ind) {
+    out.append(ind, ' ');
+    out += "<Directory name=\"";
+    escapar(out, nome);
+    out += "\">\n";
+}
+
+void fechar(std::string& out, size_t ind) {
+    out.append(ind, ' ');
+    out += "</Directory>\n";
+}
+
+void linhaFicheiro(std::string& out, const std::string& nome, uint64_t tamanho, const std::string& data, size_t ind) {
+    out.append(ind, ' ');
+    out += "<File name=\"";
+    escapar(out, nome);
+    out += "\" size=\"";
+    char num[24];
+    auto r = std::to_chars(num, num + sizeof(num), tamanho);
+    out.append(num, r.ptr);
+    out += "\" date=\"";
+    escapar(out, data);
+    out += "\" />\n";
+}
+
+void subarvore(std::string& out, const Directory& d, size_t ind) {
+    perfil::nos(1 + d.getFiles().size());
+    abrir(out, d.getName(), ind);
+    for (const auto& f : d.getFiles()) linhaFicheiro(out, f->getName(), f->getSize(), f->getDate(), ind + 2);
+    for (const auto& s : d.getSubdirectories()) subarvore(out, *s, ind + 2);
+    fechar(out, ind);
+}
+
+// Nós [a, b) de uma FlatTree. As diretorias abertas no início são os
+// antepassados do nó a - 1 (e ele próprio, se for diretoria); cada uma fecha
+// no bloco que contém o fim da sua subárvore.
+void intervalo(std::string& out, const FlatTree& ft, uint32_t a, uint32_t b) {
+    std::vector<uint32_t> abertas;
+    if (a > 0) {
+        for (uint32_t x = a - 1; x != FlatTree::npos; x = ft.parent[x]) {
+            if (ft.kind[x] == FlatTree::DirNode) abertas.push_back(x);
+        }
+        std::reverse(abertas.begin(), abertas.end());
+    }
+    auto fecharAte = [&](uint32_t j) {
+        while (!abertas.empty() && ft.subtreeEnd[abertas.back()] <= j) {
+            fechar(out, ft.depth[abertas.back()] * 2u);
+            abertas.pop_back();
+        }
+    };
+    for (uint32_t j = a; j < b; ++j) {
+        fecharAte(j);
+        if (ft.kind[j] == FlatTree::DirNode) {
+            abrir(out, ft.name(ft.nameId[j]), ft.depth[j] * 2u);
+            abertas.push_back(j);
+        } else {
+            linhaFicheiro(out, ft.name(ft.nameId[j]), ft.sizes[j], ft.dateText(j), ft.depth[j] * 2u);
+        }
+    }
+    if (b == ft.size()) fecharAte(b);
+    perfil::nos(b - a);
+}
+
+// ----------------------------------------
+// Blocos da árvore de ponteiros
+struct Segmento {
+    enum Tipo { Texto, Subarvore, Ficheiros };
+    Tipo tipo = Texto;
+    const Directory* dir = nullptr;
+    size_t ind = 0;
+    size_t de = 0, ate = 0; // Ficheiros: parte da lista de dir.
+    std::string texto;
+};
+
+// Nós (a diretoria, os ficheiros e os descendentes) e diretorias de cada subárvore, em pré-ordem.
+struct Peso {
+    uint64_t nos;
+    uint64_t diretorias;
+};
+
+Peso pesar(const Directory& d, std::vector<Peso>& pesos) {
+    size_t k = pesos.size();
+    pesos.push_back({0, 0});
+    Peso p{1 + d.getFiles().size(), 1};
+    for (const auto& s : d.getSubdirectories()) {
+        Peso q = pesar(*s, pesos);
+        p.nos += q.nos;
+        p.diretorias += q.diretorias;
+    }
+    pesos[k] = p;
+    return p;
+}
+
+std::string& texto(std::vector<Segmento>& segs) {
+    if (segs.empty() || segs.back().tipo != Segmento::Texto) segs.emplace_back();
+    return segs.back().texto;
+}
+
+// Uma subárvore até alvo nós é um só bloco; acima disso a diretoria fica
+// como texto e a lista de ficheiros e as subdiretorias são repartidas.
+void planear(const Directory& d, size_t ind, size_t& k, const std::vector<Peso>& pesos, size_t alvo,
+             std::vector<Segmento>& segs) {
+    const Peso& p = pesos[k];
+    if (p.nos <= alvo) {
+        Segmento s;
+        s.tipo = Segmento::Subarvore;
+        s.dir = &d;
+        s.ind = ind;
+        segs.push_back(std::move(s));
+        k += p.diretorias;
+        return;
+    }
+    ++k;
+    abrir(texto(segs), d.getName(), ind);
+    const auto& fs = d.getFiles();
+    for (size_t a = 0; a < fs.size(); a += alvo) {
+        Segmento s;
+        s.tipo = Segmento::Ficheiros;
+        s.dir = &d;
+        s.ind = ind + 2;
+        s.de = a;
+        s.ate = std::min(fs.size(), a + alvo);
+        segs.push_back(std::move(s));
+    }
+    for (const auto& sub : d.getSubdirectories()) planear(*sub, ind + 2, k, pesos, alvo, segs);
+    fechar(texto(segs), ind);
+}
+
+} // namespace
+
+EscritorXml::EscritorXml(size_t threads) : escrita(threads) {}
+
+bool EscritorXml::escrever(const Directory& raiz, const std::string& ficheiro) {
+    perfil::Medida medida("EscritorXml::escrever");
+    std::vector<Segmento> segs;
+    texto(segs) = kCabecalho;
+    std::vector<Peso> pesos;
+    uint64_t total = pesar(raiz, pesos).nos;
+    size_t k = 0;
+    planear(raiz, 0, k, pesos, escrita.tamanhoBloco(total), segs);
+    ultimosBlocos = segs.size();
+    return escrita.escrever(ficheiro, segs.size(), [&segs](size_t k, std::string& out) {
+        Segmento& s = segs[k];
+        switch (s.tipo) {
+            case Segmento::Texto:
+                out = std::move(s.texto);
+                break;
+            case Segmento::Subarvore:
+                subarvore(out, *s.dir, s.ind);
+                break;
+            case Segmento::Ficheiros: {
+                const auto& fs = s.dir->getFiles();
+                for (size_t i = s.de; i < s.ate; ++i) linhaFicheiro(out, fs[i]->getName(), fs[i]->getSize(), fs[i]->getDate(), s.ind);
+                perfil::nos(s.ate - s.de);
+                break;
+            }
+        }
+    }, nullptr, nullptr);
+}
+
+bool EscritorXml::escrever(const FlatTree& ft, const std::string& ficheiro, Progresso* prog) {
+    perfil::Medida medida("EscritorXml::escrever");
+    const uint32_t n = ft.size();
+    const size_t alvo = escrita.tamanhoBloco(n);
+    // Bloco 0 é o cabeçalho; o bloco k > 0 tem os nós [(k - 1) * alvo, k * alvo).
+    ultimosBlocos = 1 + (n + alvo - 1) / alvo;
+    auto fim = [n, alvo](size_t k) { return static_cast<uint64_t>(std::min<size_t>(n, k * alvo)); };
+    return escrita.escrever(ficheiro, ultimosBlocos, [&ft, n, alvo](size_t k, std::string& out) {
+        if (k == 0) { out = kCabecalho; return; }
+        uint32_t a = static_cast<uint32_t>((k - 1) * alvo);
+        uint32_t b = static_cast<uint32_t>(std::min<size_t>(n, a + alvo));
+        out.reserve(static_cast<size_t>(b - a) * 64);
+        intervalo(out, ft, a, b);
+    }, fim, prog);
+}
@@ -0,0 +1,52 @@
+#ifndef ESCRITORXML_HPP
+#define ESCRITORXML_HPP
+
+/**
+ * @file EscritorXml.hpp
+ * @brief Declara a classe EscritorXml (exportação XML repartida por várias threads).
+ */
+
+#include <cstddef>
+#include <string>
+#include "Directory.hpp"
+#include "EscritaBlocos.hpp"
+#include "FlatTree.hpp"
+#include "Tarefas.hpp"
+
+/**
+ * @class EscritorXml
+ * @brief Escreve a árvore no formato de Escrever_XML, formatando blocos em paralelo.
+ *
+ * A árvore é cortada em blocos de tamanho parecido: subárvores inteiras (ou
+ * partes da lista de ficheiros de uma diretoria muito grande) cuja indentação
+ * inicial é conhecida, separadas pelas etiquetas das diretorias que ficaram
+ * acima do corte. Numa FlatTree os blocos são simplesmente intervalos da ordem
+ * DFS. Os blocos são formatados e escritos por EscritaBlocos.
+ *
+ * Como todos os blocos usam as mesmas funções de formatação e são escritos
+ * pela ordem, o ficheiro é igual, byte a byte, ao escrito com uma só thread.
+ */
+class EscritorXml {
+public:
+    /** @param threads Threads de formatação (0 = uma por núcleo, até 8). */
+    explicit EscritorXml(size_t threads = 0);
+
+    /** @brief Escreve a subárvore de raiz. @return false se o ficheiro não pôde ser escrito. */
+    bool escrever(const Directory& raiz, const std::string& ficheiro);
+    /**
+     * @brief Escreve uma versão congelada.
+     * @param prog Progresso (nós e bytes escritos) e cancelamento; cancelada, o ficheiro parcial é apagado.
+     */
+    bool escrever(const FlatTree& ft, const std::string& ficheiro, Progresso* prog = nullptr);
+
+    /** @brief Número de threads de formatação. */
+    size_t threads() const { return escrita.threads(); }
+    /** @brief Blocos em que a última escrita foi repartida. */
+    size_t blocos() const { return ultimosBlocos; }
+
+private:
+    EscritaBlocos escrita;
+    size_t ultimosBlocos = 0;
+};
+
+#endif // ESCRITORXML_HPP
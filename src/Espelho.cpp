@@ -0,0 +1,258 @@
+#include "Espelho.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <system_error>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+Espelho::Espelho(size_t threads) : threads(threads == 0 ? 1 : threads) {}
+
+const char* Espelho::nomeModo(Modo m) {
+    switch (m) {
+        case Modo::Desligado: return "desligado";
+        case Modo::Simular: return "simular";
+        case Modo::Aplicar: return "aplicar";
+    }
+    return "?";
+}
+
+void Espelho::processar(std::vector<Operacao> plano) {
+    if (mod == Modo::Desligado) return;
+    ultimoPlano = std::move(plano);
+    executado = (mod == Modo::Aplicar);
+    ultimoResultado = executado ? executar(ultimoPlano, threads) : Resultado{};
+    porMostrar = true;
+}
+
+std::string Espelho::retirarRelatorio() {
+    if (!porMostrar) return {};
+    porMostrar = false;
+    std::ostringstream os;
+    uint64_t total = 0;
+    for (const auto& op : ultimoPlano) total += op.bytes;
+    os << "Disco (" << (executado ? "aplicado" : "simulacao, nada foi alterado") << "): " << ultimoPlano.size()
+       << " operacoes, " << total << " bytes\n";
+    const size_t maxLinhas = 20;
+    for (size_t i = 0; i < ultimoPlano.size() && i < maxLinhas; ++i) {
+        const auto& op = ultimoPlano[i];
+        switch (op.tipo) {
+            case Operacao::CriarDiretoria: os << "  mkdir " << op.destino << "\n"; break;
+            case Operacao::CopiarFicheiro: os << "  copiar " << op.origem << " -> " << op.destino << " (" << op.bytes << " bytes)\n"; break;
+            case Operacao::Mover: os << "  mover " << op.origem << " -> " << op.destino << "\n"; break;
+        }
+    }
+    if (ultimoPlano.size() > maxLinhas) os << "  ... mais " << ultimoPlano.size() - maxLinhas << " operacoes\n";
+    if (executado) {
+        const Resultado& r = ultimoResultado;
+        os << "Resultado: " << r.feitas << " feitas, " << r.falhadas << " falhadas, " << r.bytes << " bytes em "
+           << std::fixed << std::setprecision(3) << r.segundos * 1000.0 << " ms";
+        if (r.bytes > 0 && r.segundos > 0) os << " (" << std::setprecision(1) << r.bytes / r.segundos / 1e6 << " MB/s)";
+        os << " (reflink " << r.reflinks << ", copy_file_range " << r.copiasKernel
+           << ", read/write " << r.copiasBuffer << ")\n";
+        for (size_t i = 0; i < r.erros.size() && i < 5; ++i) os << "  erro: " << r.erros[i] << "\n";
+        if (r.erros.size() > 5) os << "  ... mais " << r.erros.size() - 5 << " erros\n";
+    }
+    return os.str();
+}
+
+// ----------------------------------------
+// Operações individuais
+#ifdef __linux__
+static std::string erroSistema(const std::string& onde, int e) {
+    return onde + ": " + std::strerror(e);
+}
+
+// Copia os dados de src para dst: reflink, senão copy_file_range, senão read/write.
+static bool copiarDados(int src, int dst, uint64_t tamanho, Espelho::Resultado& r, int& erro) {
+#ifdef FICLONE
+    if (::ioctl(dst, FICLONE, src) == 0) {
+        r.reflinks++;
+        r.bytes += tamanho;
+        return true;
+    }
+#endif
+    bool kernel = true;
+    uint64_t copiado = 0;
+    for (;;) {
+        ssize_t k = ::copy_file_range(src, nullptr, dst, nullptr, 1u << 30, 0);
+        if (k > 0) { copiado += static_cast<uint64_t>(k); continue; }
+        if (k == 0) break;
+        if (errno == EINTR) continue;
+        // Sem suporte (kernel antigo, outro sistema de ficheiros, ficheiro especial): copia por buffer.
+        if (copiado == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            kernel = false;
+            break;
+        }
+        erro = errno;
+        return false;
+    }
+    if (!kernel) {
+        std::vector<char> buf(1 << 20);
+        for (;;) {
+            ssize_t n = ::read(src, buf.data(), buf.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) { erro = errno; return false; }
+            if (n == 0) break;
+            for (ssize_t escrito = 0; escrito < n;) {
+                ssize_t w = ::write(dst, buf.data() + escrito, static_cast<size_t>(n - escrito));
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) { erro = errno; return false; }
+                escrito += w;
+            }
+            copiado += static_cast<uint64_t>(n);
+        }
+    }
+    (kernel ? r.copiasKernel : r.copiasBuffer)++;
+    r.bytes += copiado;
+    return true;
+}
+
+// Nunca substitui um destino existente (O_EXCL). Mantém permissões e data de modificação.
+static bool copiarFicheiro(const std::string& origem, const std::string& destino, Espelho::Resultado& r) {
+    int src = ::open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (src < 0) { r.erros.push_back(erroSistema(origem, errno)); return false; }
+    struct stat st{};
+    if (::fstat(src, &st) != 0) { r.erros.push_back(erroSistema(origem, errno)); ::close(src); return false; }
+    int dst = ::open(destino.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+    if (dst < 0) { r.erros.push_back(erroSistema(destino, errno)); ::close(src); return false; }
+
+    int erro = 0;
+    bool ok = copiarDados(src, dst, static_cast<uint64_t>(st.st_size), r, erro);
+    if (ok) {
+        struct timespec tempos[2] = { st.st_atim, st.st_mtim };
+        ::futimens(dst, tempos);
+    }
+    ::close(src);
+    if (::close(dst) != 0 && ok) { ok = false; erro = errno; }
+    if (!ok) {
+        ::unlink(destino.c_str());
+        r.erros.push_back(erroSistema(destino, erro));
+    }
+    return ok;
+}
+
+static bool mover(const std::string& origem, const std::string& destino, Espelho::Resultado& r) {
+    if (::renameat2(AT_FDCWD, origem.c_str(), AT_FDCWD, destino.c_str(), RENAME_NOREPLACE) == 0) return true;
+    int e = errno;
+    if (e == EINVAL || e == ENOSYS) {
+        // Sistema de ficheiros sem RENAME_NOREPLACE: verifica e usa rename simples.
+        if (::access(destino.c_str(), F_OK) == 0) { r.erros.push_back(erroSistema(destino, EEXIST)); return false; }
+        if (::rename(origem.c_str(), destino.c_str()) == 0) return true;
+        e = errno;
+    }
+    if (e == EXDEV) {
+        // Outro sistema de ficheiros: um ficheiro é copiado e apagado; diretorias não são suportadas.
+        struct stat st{};
+        if (::stat(origem.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            if (!copiarFicheiro(origem, destino, r)) return false;
+            if (::unlink(origem.c_str()) != 0) { r.erros.push_back(erroSistema(origem, errno)); return false; }
+            return true;
+        }
+    }
+    r.erros.push_back(erroSistema(origem + " -> " + destino, e));
+    return false;
+}
+
+static bool criarDiretoria(const std::string& destino, Espelho::Resultado& r) {
+    if (::mkdir(destino.c_str(), 0777) == 0) return true;
+    r.erros.push_back(erroSistema(destino, errno));
+    return false;
+}
+#else
+// Sem as chamadas de Linux: std::filesystem (sem reflinks nem cópias no kernel garantidas).
+static bool copiarFicheiro(const std::string& origem, const std::string& destino, Espelho::Resultado& r) {
+    std::error_code ec;
+    if (!fs::copy_file(origem, destino, fs::copy_options::none, ec)) {
+        r.erros.push_back(destino + ": " + (ec ? ec.message() : "ja existe"));
+        return false;
+    }
+    r.copiasBuffer++;
+    r.bytes += fs::file_size(destino, ec);
+    return true;
+}
+
+static bool mover(const std::string& origem, const std::string& destino, Espelho::Resultado& r) {
+    std::error_code ec;
+    if (fs::exists(destino, ec)) { r.erros.push_back(destino + ": ja existe"); return false; }
+    fs::rename(origem, destino, ec);
+    if (ec) { r.erros.push_back(origem + " -> " + destino + ": " + ec.message()); return false; }
+    return true;
+}
+
+static bool criarDiretoria(const std::string& destino, Espelho::Resultado& r) {
+    std::error_code ec;
+    if (fs::create_directory(destino, ec)) return true;
+    r.erros.push_back(destino + ": " + (ec ? ec.message() : "ja existe"));
+    return false;
+}
+#endif
+
+static bool executarUma(const Espelho::Operacao& op, Espelho::Resultado& r) {
+    switch (op.tipo) {
+        case Espelho::Operacao::CriarDiretoria: return criarDiretoria(op.destino, r);
+        case Espelho::Operacao::CopiarFicheiro: return copiarFicheiro(op.origem, op.destino, r);
+        case Espelho::Operacao::Mover: return mover(op.origem, op.destino, r);
+    }
+    return false;
+}
+
+static void juntar(Espelho::Resultado& total, Espelho::Resultado& parte) {
+    total.feitas += parte.feitas;
+    total.falhadas += parte.falhadas;
+    total.bytes += parte.bytes;
+    total.reflinks += parte.reflinks;
+    total.copiasKernel += parte.copiasKernel;
+    total.copiasBuffer += parte.copiasBuffer;
+    for (auto& e : parte.erros) total.erros.push_back(std::move(e));
+}
+
+Espelho::Resultado Espelho::executar(const std::vector<Operacao>& plano, size_t threads) {
+    Resultado total;
+    auto t0 = std::chrono::steady_clock::now();
+
+    // 1) Diretorias primeiro, pela ordem do plano (os pais aparecem antes dos filhos).
+    std::vector<const Operacao*> independentes;
+    for (const auto& op : plano) {
+        if (op.tipo != Operacao::CriarDiretoria) { independentes.push_back(&op); continue; }
+        if (executarUma(op, total)) total.feitas++;
+        else total.falhadas++;
+    }
+
+    // 2) Cópias e movimentos em paralelo; cada thread tira a próxima operação livre.
+    std::atomic<size_t> proxima{0};
+    std::mutex mtx;
+    auto trabalhador = [&] {
+        Resultado local;
+        for (size_t i; (i = proxima.fetch_add(1, std::memory_order_relaxed)) < independentes.size();) {
+            if (executarUma(*independentes[i], local)) local.feitas++;
+            else local.falhadas++;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        juntar(total, local);
+    };
+    size_t n = std::min(threads, independentes.size());
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < n; ++t) pool.emplace_back(trabalhador);
+    if (!independentes.empty()) trabalhador();
+    for (auto& t : pool) t.join();
+
+    total.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return total;
+}
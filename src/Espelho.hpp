@@ -0,0 +1,80 @@
+#ifndef ESPELHO_HPP
+#define ESPELHO_HPP
+
+/**
+ * @file Espelho.hpp
+ * @brief Declara a classe Espelho (aplicar no disco as cópias e movimentos feitos em memória).
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class Espelho
+ * @brief Executa no disco real um plano de cópias e movimentos.
+ *
+ * As cópias tentam primeiro um reflink (FICLONE, partilha de blocos em btrfs/xfs),
+ * depois copy_file_range (cópia dentro do kernel) e só em último caso read/write.
+ * Os movimentos usam renameat2(RENAME_NOREPLACE), que nunca substitui um destino
+ * existente; entre sistemas de ficheiros diferentes (EXDEV) um ficheiro é copiado
+ * e depois apagado. Fora de Linux usa-se std::filesystem.
+ *
+ * As diretorias a criar são feitas primeiro e por ordem; as restantes operações
+ * são independentes e são repartidas por várias threads.
+ */
+class Espelho {
+public:
+    /** @brief Modo de funcionamento. */
+    enum class Modo { Desligado, Simular, Aplicar };
+
+    /** @brief Uma operação no disco. */
+    struct Operacao {
+        enum Tipo { CriarDiretoria, CopiarFicheiro, Mover };
+        Tipo tipo;
+        std::string origem;  ///< Vazio em CriarDiretoria.
+        std::string destino;
+        uint64_t bytes = 0;  ///< Tamanho conhecido pelo modelo (para o relatório).
+    };
+
+    /** @brief Resultado da execução de um plano. */
+    struct Resultado {
+        size_t feitas = 0;
+        size_t falhadas = 0;
+        uint64_t bytes = 0;        ///< Bytes efetivamente copiados.
+        size_t reflinks = 0;       ///< Cópias feitas com FICLONE.
+        size_t copiasKernel = 0;   ///< Cópias feitas com copy_file_range.
+        size_t copiasBuffer = 0;   ///< Cópias feitas com read/write.
+        double segundos = 0.0;
+        std::vector<std::string> erros;
+    };
+
+    /** @param threads Threads usadas para as operações independentes. */
+    explicit Espelho(size_t threads = 4);
+
+    Modo modo() const { return mod; }
+    void setModo(Modo m) { mod = m; }
+    /** @brief Texto do modo ("desligado", "simular", "aplicar"). */
+    static const char* nomeModo(Modo m);
+
+    /**
+     * @brief Consoante o modo: não faz nada, só regista o plano, ou executa-o.
+     * @details O plano e o resultado ficam disponíveis em retirarRelatorio().
+     */
+    void processar(std::vector<Operacao> plano);
+    /** @brief Descrição do último plano processado (e do resultado); vazio se já foi retirada. */
+    std::string retirarRelatorio();
+
+    /** @brief Executa um plano (independente do modo). */
+    static Resultado executar(const std::vector<Operacao>& plano, size_t threads);
+
+private:
+    Modo mod = Modo::Desligado;
+    size_t threads;
+    std::vector<Operacao> ultimoPlano;
+    Resultado ultimoResultado;
+    bool executado = false;
+    bool porMostrar = false;
+};
+
+#endif // ESPELHO_HPP
@@ -0,0 +1,195 @@
+#include "Estimativa.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <system_error>
+#include "Perfil.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Quantil da normal para 95%.
+constexpr double kZ95 = 1.959964;
+
+} // namespace
+
+void Estimativa::Acumulador::juntar(double x) {
+    ++n;
+    double d = x - media;
+    media += d / static_cast<double>(n);
+    m2 += d * (x - media);
+}
+
+Estimativa::Estimativa(const std::string& pasta, const RegrasIgnorar& r, uint64_t semente)
+    : base(pasta), regras(r), rng(semente ? semente : std::random_device{}()) {
+    std::error_code ec;
+    if (!fs::is_directory(base, ec)) return;
+    // Como no Load: o .gitignore da pasta vem depois das regras configuradas.
+    fs::path gitignore = fs::path(base) / ".gitignore";
+    if (fs::is_regular_file(gitignore, ec)) regras.acrescentarFicheiro(gitignore.string());
+    raiz = listar(std::string());
+    for (const auto& nome : raiz.subdiretorias) {
+        Estrato e;
+        e.nome = nome;
+        estratos.push_back(std::move(e));
+    }
+    ok = true;
+}
+
+// Lê uma diretoria (relativo à pasta, com '/'). O tipo das entradas vem do
+// getdents; só os ficheiros amostrados são consultados com stat.
+const Estimativa::Listagem& Estimativa::listar(const std::string& relativo) {
+    auto it = cache.find(relativo);
+    if (it != cache.end()) return it->second;
+
+    perfil::Medida medida("Estimativa::listar");
+    Listagem l;
+    std::vector<fs::path> ficheiros;
+    std::error_code ec;
+    fs::path dir = relativo.empty() ? fs::path(base) : fs::path(base) / relativo;
+    for (fs::directory_iterator d(dir, fs::directory_options::skip_permission_denied, ec), fim; !ec && d != fim; d.increment(ec)) {
+        perfil::nos();
+        const fs::directory_entry& entry = *d;
+        std::error_code ecTipo;
+        bool eDiretoria = entry.is_directory(ecTipo);
+        std::string nome = entry.path().filename().string();
+        if (regras.ignorar(relativo.empty() ? nome : relativo + "/" + nome, eDiretoria)) continue;
+        if (!eDiretoria) ficheiros.push_back(entry.path());
+        else if (entry.is_symlink(ecTipo)) l.ligacoes++;
+        else l.subdiretorias.push_back(std::move(nome));
+    }
+    perfil::chamadas(2); // open + getdents
+    ++lidas;
+
+    // Numa diretoria grande, os tamanhos de uma amostra uniforme representam os restantes.
+    size_t n = ficheiros.size();
+    size_t amostra = std::min(n, kFicheirosPorDiretoria);
+    for (size_t i = 0; i < amostra; ++i) {
+        std::uniform_int_distribution<size_t> escolha(i, n - 1);
+        std::swap(ficheiros[i], ficheiros[escolha(rng)]);
+    }
+    double validos = 0, bytes = 0;
+    for (size_t i = 0; i < amostra; ++i) {
+        std::error_code ecTamanho;
+        auto tamanho = fs::file_size(ficheiros[i], ecTamanho);
+        perfil::chamadas(); // stat
+        if (ecTamanho) continue; // o Load também não conta o que não tem tamanho
+        validos += 1;
+        bytes += static_cast<double>(tamanho);
+    }
+    double escala = amostra ? static_cast<double>(n) / static_cast<double>(amostra) : 0.0;
+    if (amostra < n) extrapolada = true;
+    l.ficheiros = validos * escala;
+    l.bytes = bytes * escala;
+
+    if (cache.size() < kMaxCache) return cache.emplace(relativo, std::move(l)).first->second;
+    temporaria = std::move(l);
+    return temporaria;
+}
+
+void Estimativa::sondar(Estrato& e) {
+    double peso = 1, ficheiros = 0, bytes = 0, diretorias = 0;
+    std::string relativo = e.nome;
+    for (int profundidade = 0; profundidade < kProfundidadeMaxima; ++profundidade) {
+        const Listagem& l = listar(relativo);
+        ficheiros += peso * l.ficheiros;
+        bytes += peso * l.bytes;
+        diretorias += peso * (1.0 + static_cast<double>(l.ligacoes));
+        if (profundidade == 0 && l.subdiretorias.empty()) e.folha = true;
+        if (l.subdiretorias.empty()) break;
+        std::uniform_int_distribution<size_t> escolha(0, l.subdiretorias.size() - 1);
+        const std::string& proxima = l.subdiretorias[escolha(rng)];
+        peso *= static_cast<double>(l.subdiretorias.size());
+        relativo += '/';
+        relativo += proxima;
+    }
+    e.ficheiros.juntar(ficheiros);
+    e.bytes.juntar(bytes);
+    e.diretorias.juntar(diretorias);
+    ++sondagens;
+}
+
+// Duas sondagens por estrato (uma nas folhas); depois, alternadamente, o
+// estrato seguinte por rotação e o que mais baixa a variância do total de
+// bytes (max s²/(n(n+1))). A rotação impede que um estrato cujas primeiras
+// sondagens coincidiram (variância 0 por acaso) deixe de ser amostrado.
+Estimativa::Estrato* Estimativa::proximo() {
+    Estrato* melhor = nullptr;
+    double ganho = -1;
+    for (Estrato& e : estratos) {
+        if (e.folha && e.bytes.n > 0) continue;
+        if (e.bytes.n < 2) return &e;
+        double n = static_cast<double>(e.bytes.n);
+        double g = e.bytes.variancia() / (n * (n + 1));
+        if (g > ganho) { ganho = g; melhor = &e; }
+    }
+    if (!melhor || (sondagens & 1) == 0) return melhor;
+    for (size_t k = 0; k < estratos.size(); ++k) {
+        Estrato& e = estratos[rotacao++ % estratos.size()];
+        if (!e.folha) return &e;
+    }
+    return melhor;
+}
+
+uint64_t Estimativa::amostrar(std::chrono::milliseconds duracao, uint64_t maxSondagens) {
+    perfil::Medida medida("Estimativa::amostrar");
+    if (!ok) return 0;
+    auto limite = std::chrono::steady_clock::now() + duracao;
+    uint64_t feitas = 0;
+    while (maxSondagens == 0 || feitas < maxSondagens) {
+        Estrato* e = proximo();
+        if (!e) break; // tudo exato
+        sondar(*e);
+        ++feitas;
+        if ((feitas & 7) == 0 && std::chrono::steady_clock::now() >= limite) break;
+    }
+    return feitas;
+}
+
+Estimativa::Resultado Estimativa::resultado(size_t n) const {
+    Resultado r;
+    r.sondagens = sondagens;
+    r.diretoriasLidas = lidas;
+    r.ficheiros.valor = raiz.ficheiros;
+    r.bytes.valor = raiz.bytes;
+    r.diretorias.valor = 1.0 + static_cast<double>(raiz.ligacoes);
+    double vf = 0, vb = 0, vd = 0;
+    bool conhecida = true, exato = true;
+
+    auto intervalo = [](const Acumulador& a, bool folha) {
+        Intervalo i;
+        i.valor = a.media;
+        i.conhecida = folha || a.n > 1;
+        i.margem = a.n > 1 ? kZ95 * std::sqrt(a.variancia() / static_cast<double>(a.n)) : 0.0;
+        return i;
+    };
+    for (const Estrato& e : estratos) {
+        if (e.bytes.n == 0) { conhecida = false; exato = false; continue; }
+        r.ficheiros.valor += e.ficheiros.media;
+        r.bytes.valor += e.bytes.media;
+        r.diretorias.valor += e.diretorias.media;
+        double m = static_cast<double>(e.bytes.n);
+        vf += e.ficheiros.variancia() / m;
+        vb += e.bytes.variancia() / m;
+        vd += e.diretorias.variancia() / m;
+        if (!e.folha) { exato = false; if (e.bytes.n < 2) conhecida = false; }
+
+        Diretoria d;
+        d.nome = e.nome;
+        d.bytes = intervalo(e.bytes, e.folha);
+        d.ficheiros = intervalo(e.ficheiros, e.folha);
+        d.sondagens = e.bytes.n;
+        r.maiores.push_back(std::move(d));
+    }
+    r.ficheiros.margem = kZ95 * std::sqrt(vf);
+    r.bytes.margem = kZ95 * std::sqrt(vb);
+    r.diretorias.margem = kZ95 * std::sqrt(vd);
+    r.ficheiros.conhecida = r.bytes.conhecida = r.diretorias.conhecida = conhecida;
+    r.exato = exato && !extrapolada;
+
+    std::sort(r.maiores.begin(), r.maiores.end(),
+        [](const Diretoria& a, const Diretoria& b) { return a.bytes.valor > b.bytes.valor; });
+    if (r.maiores.size() > n) r.maiores.resize(n);
+    return r;
+}
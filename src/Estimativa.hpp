@@ -0,0 +1,133 @@
+#ifndef ESTIMATIVA_HPP
+#define ESTIMATIVA_HPP
+
+/**
+ * @file Estimativa.hpp
+ * @brief Declara a classe Estimativa (contagens de uma pasta do disco por amostragem, sem Load).
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RegrasIgnorar.hpp"
+
+/**
+ * @class Estimativa
+ * @brief Estima ficheiros, bytes, diretorias e as maiores subdiretorias de uma pasta sem a percorrer toda.
+ *
+ * Cada sondagem é um caminho aleatório de Knuth: desce da diretoria de
+ * partida escolhendo uma subdiretoria ao acaso até chegar a uma folha, e
+ * cada diretoria visitada conta com o peso do produto dos números de
+ * subdiretorias acima dela. A soma pesada é um estimador sem enviesamento do
+ * total da subárvore.
+ *
+ * As sondagens são estratificadas pelas subdiretorias da pasta: cada uma é
+ * um estrato com a sua média e variância, o que dá também a estimativa (e o
+ * intervalo) das maiores diretorias de topo. Depois de duas sondagens por
+ * estrato, a seguinte vai para o estrato onde mais reduz a variância dos
+ * bytes. Chamar amostrar() outra vez acumula mais sondagens e estreita os
+ * intervalos.
+ *
+ * As listagens lidas ficam em cache (até kMaxCache diretorias), por isso os
+ * níveis de cima só são lidos uma vez. Numa diretoria com muitos ficheiros só
+ * kFicheirosPorDiretoria são consultados (stat) e o tamanho é extrapolado.
+ * As entradas ignoradas pelo Load também o são aqui.
+ */
+class Estimativa {
+public:
+    /** @brief Valor estimado e meia largura do intervalo de confiança a 95%. */
+    struct Intervalo {
+        double valor = 0;
+        double margem = 0;
+        bool conhecida = true; ///< false enquanto algum estrato tiver uma só sondagem.
+    };
+
+    /** @brief Estimativa de uma subdiretoria da pasta. */
+    struct Diretoria {
+        std::string nome;
+        Intervalo bytes;
+        Intervalo ficheiros;
+        uint64_t sondagens = 0;
+    };
+
+    /** @brief Estado atual das estimativas. */
+    struct Resultado {
+        Intervalo ficheiros;
+        Intervalo bytes;
+        Intervalo diretorias;   ///< Inclui a própria pasta.
+        std::vector<Diretoria> maiores; ///< Por bytes estimados, decrescente.
+        uint64_t sondagens = 0;
+        uint64_t diretoriasLidas = 0;
+        bool exato = false;     ///< Todos os estratos são folhas: os valores são exatos.
+    };
+
+    /**
+     * @param pasta Pasta do disco a estimar.
+     * @param regras Regras do Load (as do .gitignore da pasta são acrescentadas).
+     * @param semente Semente do gerador (0 = aleatória).
+     */
+    Estimativa(const std::string& pasta, const RegrasIgnorar& regras, uint64_t semente = 0);
+
+    /** @brief false se a pasta não pôde ser lida. */
+    bool valida() const { return ok; }
+    /** @brief Pasta estimada. */
+    const std::string& pasta() const { return base; }
+
+    /**
+     * @brief Faz sondagens até passar duracao (ou até maxSondagens, se > 0).
+     * @return Sondagens feitas nesta chamada.
+     */
+    uint64_t amostrar(std::chrono::milliseconds duracao, uint64_t maxSondagens = 0);
+
+    /** @brief Estimativas com as sondagens feitas até agora; maiores tem até n diretorias. */
+    Resultado resultado(size_t n = 5) const;
+
+private:
+    struct Listagem {
+        std::vector<std::string> subdiretorias; // percorríveis (sem ligações simbólicas)
+        uint64_t ligacoes = 0;                  // diretorias por ligação simbólica: contam, mas não se desce
+        double ficheiros = 0;
+        double bytes = 0;
+    };
+
+    // Média e variância acumuladas (Welford).
+    struct Acumulador {
+        uint64_t n = 0;
+        double media = 0;
+        double m2 = 0;
+        void juntar(double x);
+        double variancia() const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+    };
+
+    struct Estrato {
+        std::string nome;
+        Acumulador ficheiros, bytes, diretorias;
+        bool folha = false; // sem subdiretorias: exato com uma sondagem
+    };
+
+    const Listagem& listar(const std::string& relativo);
+    void sondar(Estrato& e);
+    Estrato* proximo();
+
+    static constexpr size_t kMaxCache = 200000;
+    static constexpr size_t kFicheirosPorDiretoria = 1024;
+    static constexpr int kProfundidadeMaxima = 4096;
+
+    std::string base;
+    RegrasIgnorar regras;
+    bool ok = false;
+    Listagem raiz;
+    std::vector<Estrato> estratos;
+    std::unordered_map<std::string, Listagem> cache;
+    Listagem temporaria; // listagem lida quando a cache está cheia
+    uint64_t sondagens = 0;
+    uint64_t lidas = 0;
+    size_t rotacao = 0;
+    bool extrapolada = false; // alguma listagem só consultou uma amostra dos ficheiros
+    std::mt19937_64 rng;
+};
+
+#endif // ESTIMATIVA_HPP
@@ -0,0 +1,299 @@
+#include "Exportador.hpp"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include "Perfil.hpp"
+
+namespace {
+
+constexpr uint32_t kVersaoColunas = 1;
+constexpr uint32_t kDatasPorThread = 65536; // Textos de data: abaixo disto a conversão fica numa só thread.
+
+// Tipos das colunas no formato binário.
+enum TipoColuna : uint8_t { U32 = 1, U8 = 2, U64 = 3, I64 = 4, Texto = 5 };
+
+struct Coluna {
+    TipoColuna tipo;
+    const char* nome;
+};
+const Coluna kColunas[] = {
+    { U32, "id" }, { U32, "pai" }, { U8, "tipo" }, { Texto, "caminho" },
+    { Texto, "nome" }, { Texto, "extensao" }, { U64, "tamanho" }, { I64, "mtime" },
+};
+constexpr uint32_t kNumColunas = sizeof(kColunas) / sizeof(kColunas[0]);
+
+const char* const kCabecalhoCsv = "id,pai,tipo,caminho,nome,extensao,tamanho,mtime\n";
+
+// Dias desde 1970-01-01 de uma data do calendário gregoriano.
+int64_t diasDesdeEpoca(int y, int m, int d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t anoDaEra = y - era * 400;
+    const int64_t diaDoAno = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t diaDaEra = anoDaEra * 365 + anoDaEra / 4 - anoDaEra / 100 + diaDoAno;
+    return era * 146097 + diaDaEra - 719468;
+}
+
+std::string_view extensao(std::string_view nome) {
+    size_t ponto = nome.rfind('.');
+    if (ponto == std::string_view::npos || ponto == 0 || ponto + 1 == nome.size()) return std::string_view();
+    return nome.substr(ponto + 1);
+}
+
+template <typename T>
+void numero(std::string& out, T v) {
+    char num[24];
+    auto r = std::to_chars(num, num + sizeof(num), v);
+    out.append(num, r.ptr);
+}
+
+void campoCsv(std::string& out, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) { out += s; return; }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void textoJson(std::string& out, std::string_view s) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (u < 0x20) { out += "\\u00"; out += hex[u >> 4]; out += hex[u & 15]; }
+        else out += c;
+    }
+    out += '"';
+}
+
+template <typename T>
+void binario(std::string& out, T v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+void alinhar(std::string& out) { out.append((8 - out.size() % 8) % 8, '\0'); }
+
+// Caminhos dos nós de um bloco: o caminho de uma diretoria de profundidade d
+// ocupa buf[0, fim[d]); o de um nó é o do pai mais o separador e o nome.
+class Caminhos {
+public:
+    Caminhos(const FlatTree& ft, char sep, uint32_t inicio) : ft(ft), sep(sep) {
+        // Prefixos dos antepassados do primeiro nó do bloco.
+        std::vector<uint32_t> cadeia;
+        if (inicio < ft.size())
+            for (uint32_t x = ft.parent[inicio]; x != FlatTree::npos; x = ft.parent[x]) cadeia.push_back(x);
+        for (auto it = cadeia.rbegin(); it != cadeia.rend(); ++it) visitar(*it);
+    }
+
+    std::string_view visitar(uint32_t j) {
+        const size_t d = ft.depth[j];
+        buf.resize(d == 0 ? 0 : fim[d - 1]);
+        // Mesma regra de FlatTree::renderPath: sem separador duplo depois de "/".
+        if (!buf.empty() && buf.back() != '/' && buf.back() != '\\') buf.push_back(sep);
+        buf += ft.name(ft.nameId[j]);
+        if (ft.kind[j] == FlatTree::DirNode) {
+            if (fim.size() <= d) fim.resize(d + 1);
+            fim[d] = buf.size();
+        }
+        return buf;
+    }
+
+private:
+    const FlatTree& ft;
+    char sep;
+    std::string buf;
+    std::vector<size_t> fim;
+};
+
+} // namespace
+
+bool Exportador::formato(const std::string& nome, Formato& f) {
+    if (nome == "csv") f = Csv;
+    else if (nome == "jsonl") f = JsonLinhas;
+    else if (nome == "col") f = Colunas;
+    else return false;
+    return true;
+}
+
+Exportador::Exportador(size_t threads) : escrita(threads) {}
+
+// "AAAA|MM|DD" só tem o dia; a data do Load (asctime) tem também a hora.
+// Há tantos textos distintos quanto segundos distintos nos ficheiros, por
+// isso a conversão lê posições fixas, escreve os dígitos à mão e reparte os
+// textos pelas threads de formatação.
+void Exportador::converterDatas(const FlatTree& ft) {
+    const uint32_t total = ft.dateTextCount();
+    datas.assign(total, Data{ INT64_MIN, 0, {} });
+    const uint32_t partes = total < kDatasPorThread ? 1 : static_cast<uint32_t>(threads());
+    if (partes > 1) {
+        std::vector<std::thread> pool;
+        for (uint32_t k = 0; k < partes; ++k)
+            pool.emplace_back([this, &ft, k, partes, total] {
+                converterDatas(ft, static_cast<uint32_t>(uint64_t{total} * k / partes),
+                               static_cast<uint32_t>(uint64_t{total} * (k + 1) / partes));
+            });
+        for (auto& t : pool) t.join();
+    } else {
+        converterDatas(ft, 0, total);
+    }
+}
+
+void Exportador::converterDatas(const FlatTree& ft, uint32_t de, uint32_t ate) {
+    auto dois = [](const std::string& t, size_t i) {
+        return (t[i] == ' ' ? 0 : t[i] - '0') * 10 + (t[i + 1] - '0');
+    };
+    auto digitos = [](char* p, int v, int n) {
+        for (int k = n - 1; k >= 0; --k, v /= 10) p[k] = static_cast<char>('0' + v % 10);
+    };
+    for (uint32_t id = de; id < ate; ++id) {
+        const std::string& texto = ft.dateTextById(id);
+        int32_t ymd = FlatTree::parseDate(texto);
+        if (ymd == 0) continue;
+        int y = ymd / 10000, m = ymd / 100 % 100, d = ymd % 100;
+        bool hora = texto.size() >= 24 && texto[13] == ':' && texto[16] == ':';
+        int hh = hora ? dois(texto, 11) : 0, mm = hora ? dois(texto, 14) : 0, ss = hora ? dois(texto, 17) : 0;
+        Data& dt = datas[id];
+        dt.epoca = diasDesdeEpoca(y, m, d) * 86400 + hh * 3600 + mm * 60 + ss;
+        if (y > 9999) continue; // fora de AAAA: só a época
+        // "AAAA-MM-DDTHH:MM:SS"
+        std::memcpy(dt.iso, "0000-00-00T00:00:00", 19);
+        digitos(dt.iso, y, 4);
+        digitos(dt.iso + 5, m, 2);
+        digitos(dt.iso + 8, d, 2);
+        if (hora) {
+            digitos(dt.iso + 11, hh, 2);
+            digitos(dt.iso + 14, mm, 2);
+            digitos(dt.iso + 17, ss, 2);
+        }
+        dt.tamanho = hora ? 19 : 10;
+    }
+}
+
+bool Exportador::escrever(const FlatTree& ft, Formato f, const std::string& ficheiro, char sep, Progresso* prog) {
+    perfil::Medida medida("Exportador::escrever");
+    converterDatas(ft);
+    const uint32_t n = ft.size();
+    const size_t alvo = escrita.tamanhoBloco(n);
+    // Bloco 0 é o cabeçalho; o bloco k > 0 tem os nós [(k - 1) * alvo, k * alvo).
+    ultimosLotes = (n + alvo - 1) / alvo;
+    auto fim = [n, alvo](size_t k) { return static_cast<uint64_t>(std::min<size_t>(n, k * alvo)); };
+
+    auto cabecalho = [&](std::string& out) {
+        if (f == Csv) out = kCabecalhoCsv;
+        if (f != Colunas) return;
+        out.append("GDCOL\0\0\0", 8);
+        binario(out, kVersaoColunas);
+        binario(out, kNumColunas);
+        binario(out, static_cast<uint64_t>(n));
+        binario(out, static_cast<uint32_t>(alvo));
+        for (const Coluna& c : kColunas) {
+            binario(out, static_cast<uint8_t>(c.tipo));
+            binario(out, static_cast<uint8_t>(std::strlen(c.nome)));
+            out += c.nome;
+        }
+        alinhar(out);
+    };
+
+    auto linhas = [&](uint32_t a, uint32_t b, std::string& out) {
+        Caminhos caminhos(ft, sep, a);
+        out.reserve(static_cast<size_t>(b - a) * 128);
+        for (uint32_t j = a; j < b; ++j) {
+            std::string_view caminho = caminhos.visitar(j);
+            std::string_view nome = ft.name(ft.nameId[j]);
+            const bool ficheiro = ft.kind[j] == FlatTree::FileNode;
+            std::string_view ext = ficheiro ? extensao(nome) : std::string_view();
+            const Data& dt = datas[ft.dateTextId[j]];
+            std::string_view iso(dt.iso, dt.tamanho);
+            if (f == Csv) {
+                numero(out, j);
+                out += ',';
+                if (ft.parent[j] != FlatTree::npos) numero(out, ft.parent[j]);
+                out += ficheiro ? ",ficheiro," : ",diretoria,";
+                campoCsv(out, caminho);
+                out += ',';
+                campoCsv(out, nome);
+                out += ',';
+                campoCsv(out, ext);
+                out += ',';
+                numero(out, ft.sizes[j]);
+                out += ',';
+                out += iso;
+                out += '\n';
+            } else {
+                out += "{\"id\":";
+                numero(out, j);
+                out += ",\"pai\":";
+                if (ft.parent[j] != FlatTree::npos) numero(out, ft.parent[j]);
+                else out += "null";
+                out += ficheiro ? ",\"tipo\":\"ficheiro\",\"caminho\":" : ",\"tipo\":\"diretoria\",\"caminho\":";
+                textoJson(out, caminho);
+                out += ",\"nome\":";
+                textoJson(out, nome);
+                out += ",\"extensao\":";
+                textoJson(out, ext);
+                out += ",\"tamanho\":";
+                numero(out, ft.sizes[j]);
+                out += ",\"mtime\":";
+                if (dt.tamanho) textoJson(out, iso);
+                else out += "null";
+                out += "}\n";
+            }
+        }
+    };
+
+    // Um lote por bloco: as colunas de tamanho fixo copiadas das colunas da
+    // FlatTree e as de texto como deslocamentos seguidos dos bytes.
+    auto lote = [&](uint32_t a, uint32_t b, std::string& out) {
+        const uint32_t m = b - a;
+        binario(out, m);
+        binario(out, uint32_t{0});
+        auto coluna = [&out](uint64_t bytes) { binario(out, bytes); };
+        auto fixa = [&](size_t largura, auto valor) {
+            coluna(static_cast<uint64_t>(m) * largura);
+            for (uint32_t j = a; j < b; ++j) binario(out, valor(j));
+            alinhar(out);
+        };
+        // Reserva os deslocamentos, escreve os bytes e preenche-os no fim.
+        auto texto = [&](auto valor) {
+            size_t inicioColuna = out.size();
+            coluna(0);
+            size_t desl = out.size();
+            out.resize(desl + static_cast<size_t>(m + 1) * 4);
+            size_t dados = out.size();
+            for (uint32_t j = a; j < b; ++j) {
+                uint32_t o = static_cast<uint32_t>(out.size() - dados);
+                std::memcpy(&out[desl + static_cast<size_t>(j - a) * 4], &o, 4);
+                out += valor(j);
+            }
+            uint32_t o = static_cast<uint32_t>(out.size() - dados);
+            std::memcpy(&out[desl + static_cast<size_t>(m) * 4], &o, 4);
+            uint64_t bytes = out.size() - desl;
+            std::memcpy(&out[inicioColuna], &bytes, 8);
+            alinhar(out);
+        };
+        fixa(4, [](uint32_t j) { return j; });
+        fixa(4, [&ft](uint32_t j) { return ft.parent[j]; });
+        fixa(1, [&ft](uint32_t j) { return ft.kind[j]; });
+        Caminhos caminhos(ft, sep, a);
+        texto([&caminhos](uint32_t j) { return caminhos.visitar(j); });
+        texto([&ft](uint32_t j) { return std::string_view(ft.name(ft.nameId[j])); });
+        texto([&ft](uint32_t j) {
+            return ft.kind[j] == FlatTree::FileNode ? extensao(ft.name(ft.nameId[j])) : std::string_view();
+        });
+        fixa(8, [&ft](uint32_t j) { return ft.sizes[j]; });
+        fixa(8, [&](uint32_t j) { return datas[ft.dateTextId[j]].epoca; });
+    };
+
+    return escrita.escrever(ficheiro, 1 + ultimosLotes, [&](size_t k, std::string& out) {
+        if (k == 0) { cabecalho(out); return; }
+        uint32_t a = static_cast<uint32_t>((k - 1) * alvo);
+        uint32_t b = static_cast<uint32_t>(std::min<size_t>(n, a + alvo));
+        if (f == Colunas) lote(a, b, out);
+        else linhas(a, b, out);
+        perfil::nos(b - a);
+    }, fim, prog);
+}
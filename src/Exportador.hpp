@@ -0,0 +1,86 @@
+#ifndef EXPORTADOR_HPP
+#define EXPORTADOR_HPP
+
+/**
+ * @file Exportador.hpp
+ * @brief Declara a classe Exportador (exportação tabular da árvore: CSV, JSON Lines e colunas binárias).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EscritaBlocos.hpp"
+#include "FlatTree.hpp"
+#include "Tarefas.hpp"
+
+/**
+ * @class Exportador
+ * @brief Exporta uma versão congelada com uma linha por nó, pela ordem DFS da FlatTree.
+ *
+ * Cada linha tem: id (índice DFS), pai (id do pai; vazio/nulo na raiz), tipo
+ * (diretoria ou ficheiro), caminho completo, nome, extensão (depois do último
+ * '.', sem ficheiros ocultos do tipo ".bashrc"), tamanho (0 nas diretorias) e
+ * mtime. A data é a que foi gravada no Load (hora local de quem o fez):
+ * "AAAA-MM-DDTHH:MM:SS" no CSV e no JSON Lines ("AAAA-MM-DD" se só o dia for
+ * conhecido) e segundos desde 1970 no formato em colunas, contando a hora
+ * gravada como UTC.
+ *
+ * As linhas são formatadas em blocos de nós consecutivos por EscritaBlocos. O
+ * caminho de cada nó é o do pai (um prefixo do mesmo buffer) mais o nome, e as
+ * datas são convertidas uma vez por texto distinto: formatar uma linha não
+ * aloca memória.
+ *
+ * Formato em colunas (inteiros little-endian, cada secção alinhada a 8 bytes):
+ * - cabeçalho: "GDCOL" e três zeros, uint32 versão (1), uint32 colunas,
+ *   uint64 linhas, uint32 linhas por lote e, por coluna, uint8 tipo, uint8
+ *   comprimento do nome e o nome;
+ * - lotes: uint32 linhas, uint32 0 e, por coluna, uint64 bytes seguido dos
+ *   valores: uint32, uint8, uint64 ou int64 (tipos 1 a 4) ou, nos textos
+ *   (tipo 5), linhas + 1 deslocamentos uint32 seguidos dos bytes, como uma
+ *   coluna utf8 do Apache Arrow.
+ * O id é a posição da linha; pai = 4294967295 na raiz e mtime = INT64_MIN
+ * quando a data é desconhecida.
+ */
+class Exportador {
+public:
+    /** @brief Formatos de saída. */
+    enum Formato { Csv, JsonLinhas, Colunas };
+
+    /** @brief Converte "csv", "jsonl" ou "col". @return false se o nome não for conhecido. */
+    static bool formato(const std::string& nome, Formato& f);
+
+    /** @param threads Threads de formatação (0 = uma por núcleo, até 8). */
+    explicit Exportador(size_t threads = 0);
+
+    /**
+     * @brief Escreve todos os nós de ft em ficheiro.
+     * @param sep Separador dos caminhos.
+     * @param prog Progresso (nós e bytes escritos) e cancelamento; cancelada, o ficheiro parcial é apagado.
+     * @return false se o ficheiro não pôde ser escrito.
+     */
+    bool escrever(const FlatTree& ft, Formato f, const std::string& ficheiro, char sep = '/',
+                  Progresso* prog = nullptr);
+
+    /** @brief Número de threads de formatação. */
+    size_t threads() const { return escrita.threads(); }
+    /** @brief Lotes (blocos de linhas) da última escrita. */
+    size_t lotes() const { return ultimosLotes; }
+
+private:
+    // Data de um texto de data distinto, já nos dois formatos de saída.
+    struct Data {
+        int64_t epoca;   // INT64_MIN se desconhecida
+        uint8_t tamanho; // caracteres usados em iso (0 se desconhecida)
+        char iso[20];
+    };
+
+    void converterDatas(const FlatTree& ft);
+    void converterDatas(const FlatTree& ft, uint32_t de, uint32_t ate);
+
+    EscritaBlocos escrita;
+    std::vector<Data> datas;
+    size_t ultimosLotes = 0;
+};
+
+#endif // EXPORTADOR_HPP
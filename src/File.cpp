@@ -4,36 +4,58 @@
 #include <sstream>
 #include <iomanip>
 
+std::atomic<unsigned long long> File::modificationCounter{0};
+
 // Ao criar um ficheiro, registamos também a data (YYYY|MM|DD) do momento.
 File::File(const std::string& name, size_t size) 
-    : name(name), size(size) {
+    : name(name) {
     time_t now = time(0);
-    tm* ltm = localtime(&now);
+    // Versão reentrante: também se criam ficheiros em tarefas de segundo plano.
+    tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    const tm* ltm = &local;
     
     std::stringstream ss;
     ss << (1900 + ltm->tm_year) << "|" 
        << std::setw(2) << std::setfill('0') << (1 + ltm->tm_mon) << "|"
        << std::setw(2) << std::setfill('0') << ltm->tm_mday;
-    date = ss.str();
+    dados = std::make_shared<const Dados>(Dados{size, ss.str()});
 }
 
-std::string File::getName() const {
+File::File(const std::string& name, size_t size, const std::string& date)
+    : name(name), dados(std::make_shared<const Dados>(Dados{size, date})) {}
+
+File::File(const std::string& name, std::shared_ptr<const Dados> dados)
+    : name(name), dados(std::move(dados)) {}
+
+const std::string& File::getName() const {
     return name;
 }
 
 size_t File::getSize() const {
-    return size;
+    return dados->size;
 }
 
-std::string File::getDate() const {
-    return date;
+const std::string& File::getDate() const {
+    return dados->date;
 }
 
 void File::setName(const std::string& newName) {
     name = newName;
+    ++modificationCounter;
 }
 
 void File::setDate(const std::string& newDate) {
     // Útil quando importamos de XML ou ficamos com a data do disco.
-    date = newDate;
+    // A identidade no disco mantém-se: continua a ser o mesmo inode.
+    dados = std::make_shared<const Dados>(Dados{dados->size, newDate, dados->dispositivo, dados->inode, dados->ligacoes});
+    ++modificationCounter;
+}
+
+unsigned long long File::modificationVersion() {
+    return modificationCounter;
 }
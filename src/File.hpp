@@ -7,18 +7,45 @@
  * @brief Declara a classe File.
  */
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <ctime>
 
 /**
  * @class File
  * @brief Representa um ficheiro com nome, tamanho e data (YYYY|MM|DD).
+ *
+ * O tamanho e a data ficam num bloco imutável (Dados) partilhado entre as
+ * cópias do mesmo ficheiro; cada File é só a entrada numa diretoria (o nome e
+ * um ponteiro para os dados). Uma cópia não duplica a data e setDate cria
+ * dados novos em vez de alterar os partilhados.
+ *
+ * Os ficheiros lidos do disco guardam também a identidade (dispositivo,
+ * inode): as ligações físicas (hard links) ao mesmo inode partilham um só
+ * bloco de dados, o que permite contar os bytes aparentes e os únicos.
  */
 class File {
+    friend class Lote;
+    friend class Ocupacao;
+
+public:
+    /** @brief Conteúdo imutável de um ficheiro, partilhado pelas suas cópias. */
+    struct Dados {
+        size_t size;
+        std::string date;
+        uint64_t dispositivo = 0; ///< st_dev no Load (0 com inode = 0: desconhecido).
+        uint64_t inode = 0;       ///< st_ino no Load; 0 para ficheiros criados em memória ou lidos de XML.
+        uint32_t ligacoes = 1;    ///< st_nlink no Load (inclui ligações fora da pasta lida).
+    };
+
 private:
     std::string name;
-    size_t size;
-    std::string date; 
+    std::shared_ptr<const Dados> dados;
+
+    // Contador global incrementado sempre que um ficheiro é alterado.
+    static std::atomic<unsigned long long> modificationCounter;
 
 public:
     /**
@@ -27,21 +54,35 @@ public:
      * @param size Tamanho em bytes.
      */
     File(const std::string& name, size_t size);
+    /**
+     * @brief Constrói um ficheiro com uma data já conhecida (sem consultar o relógio).
+     * @param date Data no formato YYYY|MM|DD.
+     */
+    File(const std::string& name, size_t size, const std::string& date);
+    /** @brief Constrói uma entrada nova que partilha os dados de outro ficheiro. */
+    File(const std::string& name, std::shared_ptr<const Dados> dados);
     
     /** @brief Obtém o nome do ficheiro. */
-    std::string getName() const;
+    const std::string& getName() const;
     /** @brief Obtém o tamanho (bytes). */
     size_t getSize() const;
     /** @brief Obtém a data no formato YYYY|MM|DD. */
-    std::string getDate() const;
+    const std::string& getDate() const;
+    /** @brief Dados partilhados (para criar cópias sem duplicar a data). */
+    const std::shared_ptr<const Dados>& getDados() const { return dados; }
+    /** @brief true se o ficheiro veio do disco com a identidade (dispositivo, inode) conhecida. */
+    bool temInode() const { return dados->inode != 0; }
     
     /** @brief Atualiza o nome. */
     void setName(const std::string& newName);
     /**
-     * @brief Define uma data específica.
+     * @brief Define uma data específica (as outras cópias mantêm a data anterior).
      * @param newDate Data no formato YYYY|MM|DD.
      */
     void setDate(const std::string& newDate);
+
+    /** @brief Versão global dos ficheiros (muda a cada setName/setDate). */
+    static unsigned long long modificationVersion();
 };
 
 #endif
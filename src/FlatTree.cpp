@@ -0,0 +1,256 @@
+#include "FlatTree.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <cstdlib>
+#include <cstring>
+#include "Ocupacao.hpp"
+#include "Perfil.hpp"
+
+FlatTree::FlatTree(const Directory& root) {
+    // Reservamos tudo de uma vez para que as colunas fiquem contíguas.
+    size_t n = static_cast<size_t>(root.getTotalDirectories()) + static_cast<size_t>(root.getTotalFiles());
+    parent.reserve(n); firstChild.reserve(n); subtreeEnd.reserve(n); nameId.reserve(n);
+    sizes.reserve(n); dates.reserve(n); dateTextId.reserve(n); depth.reserve(n); kind.reserve(n);
+    fileStart.reserve(n + 1);
+    size_t nf = static_cast<size_t>(root.getTotalFiles());
+    fileSizes.reserve(nf); fileDates.reserve(nf); fileNodes.reserve(nf);
+
+    auto push = [&](uint32_t par, uint32_t nm, uint64_t sz, int32_t dt, uint32_t dtText, uint16_t dp, Kind k) {
+        uint32_t idx = size();
+        fileStart.push_back(static_cast<uint32_t>(fileNodes.size()));
+        if (k == FileNode) {
+            fileSizes.push_back(sz);
+            fileDates.push_back(dt);
+            fileNodes.push_back(idx);
+        }
+        parent.push_back(par);
+        firstChild.push_back(npos);
+        subtreeEnd.push_back(idx + 1);
+        nameId.push_back(nm);
+        sizes.push_back(sz);
+        dates.push_back(dt);
+        dateTextId.push_back(dtText);
+        depth.push_back(dp);
+        kind.push_back(k);
+        return idx;
+    };
+
+    const uint32_t noDate = dateTexts.intern(std::string());
+    std::function<void(const Directory&, uint32_t, uint16_t)> add;
+    add = [&](const Directory& d, uint32_t par, uint16_t dp) {
+        uint32_t idx = push(par, names.intern(d.getName()), 0, 0, noDate, dp, DirNode);
+        dirIndex.emplace(&d, idx);
+        for (const auto& f : d.getFiles()) {
+            push(idx, names.intern(f->getName()), f->getSize(), parseDate(f->getDate()),
+                 dateTexts.intern(f->getDate()), dp + 1, FileNode);
+        }
+        for (const auto& s : d.getSubdirectories()) add(*s, idx, dp + 1);
+        subtreeEnd[idx] = size();
+        if (subtreeEnd[idx] > idx + 1) firstChild[idx] = idx + 1;
+    };
+    add(root, npos, 0);
+    perfil::nos(size());
+    fileStart.push_back(static_cast<uint32_t>(fileNodes.size()));
+}
+
+uint32_t FlatTree::StringPool::intern(const std::string& s) {
+    auto it = lookup.find(s);
+    if (it != lookup.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(items.size());
+    items.push_back(s);
+    // A deque não move os elementos existentes, por isso a vista continua válida.
+    lookup.emplace(items.back(), id);
+    return id;
+}
+
+size_t FlatTree::StringPool::memoryBytes() const {
+    uint64_t b = items.size() * sizeof(std::string) + Ocupacao::bytesMapa(lookup);
+    for (const auto& t : items) b += Ocupacao::bytesTexto(t);
+    return static_cast<size_t>(b);
+}
+
+size_t FlatTree::memoryBytes() const {
+    uint64_t b = sizeof(FlatTree);
+    b += Ocupacao::bytesVetor(parent) + Ocupacao::bytesVetor(firstChild) + Ocupacao::bytesVetor(subtreeEnd)
+       + Ocupacao::bytesVetor(nameId) + Ocupacao::bytesVetor(sizes) + Ocupacao::bytesVetor(dates)
+       + Ocupacao::bytesVetor(dateTextId) + Ocupacao::bytesVetor(depth) + Ocupacao::bytesVetor(kind);
+    b += Ocupacao::bytesVetor(fileSizes) + Ocupacao::bytesVetor(fileDates) + Ocupacao::bytesVetor(fileNodes)
+       + Ocupacao::bytesVetor(fileStart) + maiorBytes.load(std::memory_order_relaxed);
+    b += names.memoryBytes() + dateTexts.memoryBytes() + Ocupacao::bytesMapa(dirIndex);
+    return static_cast<size_t>(b);
+}
+
+uint32_t FlatTree::lookupName(std::string_view n) const {
+    auto it = names.lookup.find(n);
+    return (it != names.lookup.end()) ? it->second : npos;
+}
+
+uint32_t FlatTree::indexOf(const Directory* dir) const {
+    auto it = dirIndex.find(dir);
+    return (it != dirIndex.end()) ? it->second : npos;
+}
+
+// Os ficheiros da subárvore de i são o intervalo [fileStart[i], fileStart[subtreeEnd[i]])
+// das colunas de ficheiros, por isso as agregações são reduções contíguas.
+uint64_t FlatTree::totalSize(uint32_t i) const {
+    uint32_t a = fileStart[i], b = fileStart[subtreeEnd[i]];
+    return kernels::sum(fileSizes.data() + a, b - a);
+}
+
+uint32_t FlatTree::countFiles(uint32_t i) const {
+    return fileStart[subtreeEnd[i]] - fileStart[i];
+}
+
+uint32_t FlatTree::countDirectories(uint32_t i) const {
+    return (subtreeEnd[i] - i) - countFiles(i);
+}
+
+uint32_t FlatTree::largestFile(uint32_t i) const {
+    uint32_t a = fileStart[i], b = fileStart[subtreeEnd[i]];
+    if (a == b) return npos;
+    perfil::nos(b - a);
+    kernels::MaxResult r = kernels::maxIndex(fileSizes.data() + a, b - a);
+    uint32_t best = fileNodes[a + r.index];
+    // Em empate fica o primeiro em largura (menor profundidade), como nas BFS do serviço.
+    for (uint32_t f = a + static_cast<uint32_t>(r.index) + 1; f < b; ++f) {
+        if (fileSizes[f] == r.value && depth[fileNodes[f]] < depth[best]) best = fileNodes[f];
+    }
+    return best;
+}
+
+namespace {
+// Ordem dos maiores: tamanho decrescente e, em empate, a posição DFS mais baixa.
+inline bool antes(const std::vector<uint64_t>& t, uint32_t a, uint32_t b) {
+    return t[a] > t[b] || (t[a] == t[b] && a < b);
+}
+}
+
+uint32_t FlatTree::maiorEntre(uint32_t de, uint32_t ate) const {
+    const uint32_t m = static_cast<uint32_t>(fileSizes.size());
+    uint32_t best = de;
+    for (uint32_t l = de + m, r = ate + m; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) { uint32_t c = maiorArvore[l++]; if (antes(fileSizes, c, best)) best = c; }
+        if (r & 1) { uint32_t c = maiorArvore[--r]; if (antes(fileSizes, c, best)) best = c; }
+    }
+    return best;
+}
+
+// Cada intervalo na fila é representado pelo seu maior ficheiro; tirar o melhor
+// parte o intervalo em dois, por isso k resultados custam k consultas ao índice.
+void FlatTree::largestFiles(uint32_t de, uint32_t ate, size_t k, std::vector<uint32_t>& out) const {
+    out.clear();
+    if (de >= ate || k == 0) return;
+    const uint32_t m = static_cast<uint32_t>(fileSizes.size());
+    std::call_once(maioresConstruido, [&] {
+        perfil::nos(m);
+        maiorArvore.resize(2 * static_cast<size_t>(m));
+        for (uint32_t f = 0; f < m; ++f) maiorArvore[m + f] = f;
+        for (uint32_t p = m; p-- > 1;) {
+            uint32_t a = maiorArvore[2 * p], b = maiorArvore[2 * p + 1];
+            maiorArvore[p] = antes(fileSizes, b, a) ? b : a;
+        }
+        maiorBytes.store(static_cast<size_t>(Ocupacao::bytesVetor(maiorArvore)), std::memory_order_relaxed);
+    });
+
+    struct Intervalo { uint32_t melhor, de, ate; };
+    auto pior = [this](const Intervalo& a, const Intervalo& b) { return antes(fileSizes, b.melhor, a.melhor); };
+    std::priority_queue<Intervalo, std::vector<Intervalo>, decltype(pior)> fila(pior);
+    fila.push({maiorEntre(de, ate), de, ate});
+    out.reserve(std::min<size_t>(k, ate - de));
+    while (!fila.empty() && out.size() < k) {
+        Intervalo t = fila.top();
+        fila.pop();
+        out.push_back(fileNodes[t.melhor]);
+        if (t.de < t.melhor) fila.push({maiorEntre(t.de, t.melhor), t.de, t.melhor});
+        if (t.melhor + 1 < t.ate) fila.push({maiorEntre(t.melhor + 1, t.ate), t.melhor + 1, t.ate});
+    }
+}
+
+void FlatTree::largestFilesUnder(uint32_t i, size_t k, std::vector<uint32_t>& out) const {
+    largestFiles(fileStart[i], fileStart[subtreeEnd[i]], k, out);
+}
+
+// Em ordem DFS cada filho vem depois do pai: uma passagem de trás para a frente
+// acumula os tamanhos de todas as subárvores.
+std::vector<uint64_t> FlatTree::directorySizes() const {
+    perfil::nos(size());
+    std::vector<uint64_t> acc(sizes);
+    for (uint32_t j = size(); j-- > 1;) acc[parent[j]] += acc[j];
+    return acc;
+}
+
+std::vector<uint32_t> FlatTree::elementCounts() const {
+    perfil::nos(size());
+    std::vector<uint32_t> cnt(size(), 0);
+    for (uint32_t j = 1; j < size(); ++j) ++cnt[parent[j]];
+    return cnt;
+}
+
+// Numa BFS, nós à mesma profundidade aparecem pela mesma ordem que em DFS;
+// por isso basta escolher o de menor profundidade e, em empate, o de menor índice.
+uint32_t FlatTree::findFirst(std::string_view n, Kind k) const {
+    uint32_t id = lookupName(n);
+    if (id == npos) return npos;
+    perfil::nos(size());
+    uint32_t best = npos;
+    for (uint32_t j = 0; j < size(); ++j) {
+        if (nameId[j] == id && kind[j] == k && (best == npos || depth[j] < depth[best])) best = j;
+    }
+    return best;
+}
+
+void FlatTree::findAll(std::string_view n, Kind k, std::vector<uint32_t>& out) const {
+    uint32_t id = lookupName(n);
+    if (id == npos) return;
+    perfil::nos(size());
+    for (uint32_t j = 0; j < size(); ++j) {
+        if (nameId[j] == id && kind[j] == k) out.push_back(j);
+    }
+}
+
+void FlatTree::generateTree(std::ostream& out) const {
+    std::string indent;
+    perfil::nos(size());
+    for (uint32_t j = 0; j < size(); ++j) {
+        indent.assign(static_cast<size_t>(depth[j]) * 2, ' ');
+        if (kind[j] == DirNode) out << indent << name(nameId[j]) << "/\n";
+        else out << indent << name(nameId[j]) << " (" << sizes[j] << ")\n";
+    }
+}
+
+void FlatTree::appendPath(uint32_t i, std::string& out, char sep) const {
+    if (parent[i] != npos) appendPath(parent[i], out, sep);
+    // Mesma regra de Directory::renderPath: sem separador duplo depois de "/".
+    if (!out.empty() && out.back() != '/' && out.back() != '\\') out.push_back(sep);
+    out += name(nameId[i]);
+}
+
+void FlatTree::renderPath(uint32_t i, std::string& out, char sep) const {
+    out.clear();
+    if (i < size()) appendPath(i, out, sep);
+}
+
+int32_t FlatTree::parseDate(const std::string& date) {
+    if (date.empty()) return 0;
+    int y = 0, m = 0, d = 0;
+    if (date.find('|') != std::string::npos) {
+        // "AAAA|MM|DD" (também aceita mês/dia sem zero à esquerda)
+        char* end = nullptr;
+        y = static_cast<int>(std::strtol(date.c_str(), &end, 10));
+        if (*end == '|') m = static_cast<int>(std::strtol(end + 1, &end, 10));
+        if (*end == '|') d = static_cast<int>(std::strtol(end + 1, &end, 10));
+    } else if (date.size() >= 24) {
+        // asctime: "Wed Jun 30 21:49:08 1993"
+        static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        for (int k = 0; k < 12; ++k) {
+            if (std::strncmp(date.c_str() + 4, months[k], 3) == 0) { m = k + 1; break; }
+        }
+        d = std::atoi(date.c_str() + 8);
+        y = std::atoi(date.c_str() + date.size() - 4);
+    }
+    if (y <= 0 || m < 1 || m > 12 || d < 1 || d > 31) return 0;
+    return y * 10000 + m * 100 + d;
+}
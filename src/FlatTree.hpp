@@ -0,0 +1,141 @@
+#ifndef FLATTREE_HPP
+#define FLATTREE_HPP
+
+/**
+ * @file FlatTree.hpp
+ * @brief Declara a classe FlatTree (árvore "congelada" em arrays contíguos).
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include "Directory.hpp"
+
+/**
+ * @class FlatTree
+ * @brief Cópia só de leitura da árvore em ordem DFS, guardada por colunas.
+ *
+ * Cada nó (diretoria ou ficheiro) ocupa um índice; a subárvore de uma
+ * diretoria i é o intervalo [i, subtreeEnd[i]). Dentro de cada diretoria os
+ * ficheiros vêm antes das subdiretorias, tal como em Directory::generateTree,
+ * por isso as consultas são varrimentos lineares sobre arrays contíguos.
+ */
+class FlatTree {
+public:
+    /** @brief Índice inválido (ex.: pai da raiz). */
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    /** @brief Tipo do nó. */
+    enum Kind : uint8_t { DirNode = 0, FileNode = 1 };
+
+    /** @brief Compacta a subárvore de root. */
+    explicit FlatTree(const Directory& root);
+
+    /** @brief Número da versão quando publicada num SnapshotStore (0 se não publicada). */
+    uint64_t version = 0;
+
+    /** @brief Número total de nós (diretorias + ficheiros). */
+    uint32_t size() const { return static_cast<uint32_t>(kind.size()); }
+
+    // Colunas paralelas, indexadas pelo índice DFS do nó.
+    std::vector<uint32_t> parent;     ///< Índice do pai (npos na raiz).
+    std::vector<uint32_t> firstChild; ///< Primeiro filho (npos se não tiver).
+    std::vector<uint32_t> subtreeEnd; ///< Fim (exclusive) da subárvore.
+    std::vector<uint32_t> nameId;     ///< Índice do nome em names.
+    std::vector<uint64_t> sizes;      ///< Tamanho em bytes (0 nas diretorias).
+    std::vector<int32_t> dates;       ///< Data como AAAAMMDD (0 se desconhecida / diretoria).
+    std::vector<uint32_t> dateTextId; ///< Texto original da data (ver dateText).
+    std::vector<uint16_t> depth;      ///< Profundidade (raiz = 0).
+    std::vector<uint8_t> kind;        ///< DirNode ou FileNode.
+
+    // Colunas só de ficheiros (mesma ordem DFS), contíguas para as reduções vetorizadas.
+    std::vector<uint64_t> fileSizes;  ///< Tamanho de cada ficheiro.
+    std::vector<int32_t> fileDates;   ///< Data AAAAMMDD de cada ficheiro.
+    std::vector<uint32_t> fileNodes;  ///< Índice do nó correspondente a cada ficheiro.
+    std::vector<uint32_t> fileStart;  ///< Ficheiros antes do nó i (size() + 1 posições).
+
+    /** @brief Nome associado a um handle. */
+    const std::string& name(uint32_t id) const { return names.items[id]; }
+    /** @brief Data tal como estava guardada no ficheiro (para exportar sem perder o formato). */
+    const std::string& dateText(uint32_t node) const { return dateTexts.items[dateTextId[node]]; }
+    /** @brief Número de textos de data distintos (os valores possíveis de dateTextId). */
+    uint32_t dateTextCount() const { return static_cast<uint32_t>(dateTexts.items.size()); }
+    /** @brief Texto de data com o handle id (ver dateTextId). */
+    const std::string& dateTextById(uint32_t id) const { return dateTexts.items[id]; }
+    /** @brief Número de nomes distintos (os valores possíveis de nameId). */
+    uint32_t nameCount() const { return static_cast<uint32_t>(names.items.size()); }
+    /** @brief Handle de um nome, ou npos se não existir nenhum nó com esse nome. */
+    uint32_t lookupName(std::string_view n) const;
+    /** @brief Índice do nó de uma diretoria da árvore original (npos se não pertencer). */
+    uint32_t indexOf(const Directory* dir) const;
+
+    /** @brief Soma dos tamanhos dos ficheiros na subárvore de i. */
+    uint64_t totalSize(uint32_t i = 0) const;
+    /** @brief Número de ficheiros na subárvore de i. */
+    uint32_t countFiles(uint32_t i = 0) const;
+    /** @brief Número de diretorias na subárvore de i (inclui i). */
+    uint32_t countDirectories(uint32_t i = 0) const;
+    /** @brief Ficheiro maior na subárvore de i (npos se não houver; empate: primeiro em largura). */
+    uint32_t largestFile(uint32_t i = 0) const;
+    /**
+     * @brief Os k maiores ficheiros entre as posições de ficheiro [de, ate), do maior para o menor.
+     * @details Em empate fica primeiro o anterior em ordem DFS. Usa um índice de máximos por
+     * intervalo, construído na primeira chamada: O(k log n) por consulta.
+     * @param out Recebe os índices dos nós (é limpo antes).
+     */
+    void largestFiles(uint32_t de, uint32_t ate, size_t k, std::vector<uint32_t>& out) const;
+    /** @brief Os k maiores ficheiros na subárvore de i (ver largestFiles). */
+    void largestFilesUnder(uint32_t i, size_t k, std::vector<uint32_t>& out) const;
+    /** @brief Tamanho recursivo de todas as diretorias (índice -> bytes), numa só passagem. */
+    std::vector<uint64_t> directorySizes() const;
+    /** @brief Número de elementos diretos de cada nó (subdiretorias + ficheiros). */
+    std::vector<uint32_t> elementCounts() const;
+    /**
+     * @brief Primeiro nó com o nome dado, na mesma ordem de uma BFS sobre a árvore.
+     * @param k DirNode ou FileNode.
+     */
+    uint32_t findFirst(std::string_view n, Kind k) const;
+    /** @brief Todos os nós com o nome dado, em ordem DFS. */
+    void findAll(std::string_view n, Kind k, std::vector<uint32_t>& out) const;
+    /** @brief Desenha a árvore no mesmo formato que Directory::generateTree. */
+    void generateTree(std::ostream& out) const;
+    /** @brief Escreve em out o caminho do nó i (buffer reutilizável). */
+    void renderPath(uint32_t i, std::string& out, char sep) const;
+
+    /** @brief Memória das colunas, dos textos e do índice de diretorias (bytes, estimativa). */
+    size_t memoryBytes() const;
+
+    /** @brief Converte "AAAA|MM|DD" ou uma data asctime para AAAAMMDD (0 se inválida). */
+    static int32_t parseDate(const std::string& date);
+
+private:
+    // Cada texto distinto é guardado uma vez; os nós guardam só o índice.
+    struct StringPool {
+        std::deque<std::string> items;
+        std::unordered_map<std::string_view, uint32_t> lookup;
+        uint32_t intern(const std::string& s);
+        size_t memoryBytes() const;
+    };
+
+    void appendPath(uint32_t i, std::string& out, char sep) const;
+    // Posição de ficheiro com o maior tamanho em [de, ate) (empate: a primeira).
+    uint32_t maiorEntre(uint32_t de, uint32_t ate) const;
+
+    StringPool names;
+    StringPool dateTexts;
+    std::unordered_map<const Directory*, uint32_t> dirIndex;
+
+    // Árvore de segmentos sobre fileSizes: as folhas (m..2m-1) são as posições e cada
+    // nó interno guarda a posição do maior dos dois filhos. Construída a pedido.
+    mutable std::once_flag maioresConstruido;
+    mutable std::vector<uint32_t> maiorArvore;
+    mutable std::atomic<size_t> maiorBytes{0};
+};
+
+#endif // FLATTREE_HPP
@@ -0,0 +1,307 @@
+#include "Kernels.hpp"
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace kernels {
+namespace {
+
+// ----------------------------------------
+// Versões escalares (referência e fallback)
+uint64_t sumScalar(const uint64_t* v, size_t n) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += v[i];
+    return total;
+}
+
+MaxResult maxIndexScalar(const uint64_t* v, size_t n) {
+    MaxResult r{0, SIZE_MAX};
+    for (size_t i = 0; i < n; ++i) {
+        if (r.index == SIZE_MAX || v[i] > r.value) { r.value = v[i]; r.index = i; }
+    }
+    return r;
+}
+
+// Conta, para cada limite, quantos valores ficam abaixo dele; as faixas saem por diferença.
+void finishHistogram(const uint64_t* below, size_t n, size_t nb, uint64_t* counts) {
+    counts[0] = below[0];
+    for (size_t k = 1; k < nb; ++k) counts[k] = below[k] - below[k - 1];
+    counts[nb] = n - below[nb - 1];
+}
+
+void histogramScalar(const uint64_t* v, size_t n, const uint64_t* bounds, size_t nb, uint64_t* counts) {
+    for (size_t k = 0; k <= nb; ++k) counts[k] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = 0;
+        while (k < nb && v[i] >= bounds[k]) ++k;
+        ++counts[k];
+    }
+}
+
+size_t rangeCountScalar(const int32_t* v, size_t n, int32_t lo, int32_t hi) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += (v[i] >= lo && v[i] <= hi);
+    return total;
+}
+
+#ifdef KERNELS_X86
+// Número máximo de limites tratados nos caminhos vetoriais do histograma.
+constexpr size_t kMaxVectorBounds = 16;
+
+// ----------------------------------------
+// AVX2 (4 x 64 bits / 8 x 32 bits por registo)
+__attribute__((target("avx2")))
+uint64_t sumAvx2(const uint64_t* v, size_t n) {
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_epi64(a0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)));
+        a1 = _mm256_add_epi64(a1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i + 4)));
+        a2 = _mm256_add_epi64(a2, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i + 8)));
+        a3 = _mm256_add_epi64(a3, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i + 12)));
+    }
+    a0 = _mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3));
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), a0);
+    uint64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) total += v[i];
+    return total;
+}
+
+// O AVX2 só compara inteiros de 64 bits com sinal: somamos 2^63 (xor do bit de sinal)
+// para que a ordem com sinal coincida com a ordem sem sinal.
+__attribute__((target("avx2")))
+MaxResult maxIndexAvx2(const uint64_t* v, size_t n) {
+    if (n < 8) return maxIndexScalar(v, n);
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i step = _mm256_set1_epi64x(4);
+    __m256i idx = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i best = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v)), bias);
+    __m256i bestIdx = idx;
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        idx = _mm256_add_epi64(idx, step);
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), bias);
+        __m256i gt = _mm256_cmpgt_epi64(x, best);
+        best = _mm256_blendv_epi8(best, x, gt);
+        bestIdx = _mm256_blendv_epi8(bestIdx, idx, gt);
+    }
+    alignas(32) uint64_t vals[4];
+    alignas(32) uint64_t idxs[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(vals), _mm256_xor_si256(best, bias));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idxs), bestIdx);
+    MaxResult r{vals[0], idxs[0]};
+    for (int l = 1; l < 4; ++l) {
+        if (vals[l] > r.value || (vals[l] == r.value && idxs[l] < r.index)) r = {vals[l], idxs[l]};
+    }
+    for (; i < n; ++i) {
+        if (v[i] > r.value) r = {v[i], i};
+    }
+    return r;
+}
+
+__attribute__((target("avx2")))
+void histogramAvx2(const uint64_t* v, size_t n, const uint64_t* bounds, size_t nb, uint64_t* counts) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    __m256i b[kMaxVectorBounds];
+    __m256i below[kMaxVectorBounds];
+    for (size_t k = 0; k < nb; ++k) {
+        b[k] = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(bounds[k])), bias);
+        below[k] = _mm256_setzero_si256();
+    }
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i)), bias);
+        // bounds[k] > v dá -1 por faixa; subtrair acumula +1.
+        for (size_t k = 0; k < nb; ++k) below[k] = _mm256_sub_epi64(below[k], _mm256_cmpgt_epi64(b[k], x));
+    }
+    uint64_t tot[kMaxVectorBounds];
+    for (size_t k = 0; k < nb; ++k) {
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), below[k]);
+        tot[k] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (size_t j = i; j < n; ++j) tot[k] += (v[j] < bounds[k]);
+    }
+    finishHistogram(tot, n, nb, counts);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t rangeCountAvx2(const int32_t* v, size_t n, int32_t lo, int32_t hi) {
+    const __m256i vlo = _mm256_set1_epi32(lo);
+    const __m256i vhi = _mm256_set1_epi32(hi);
+    size_t outside = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(x, vhi));
+        outside += static_cast<size_t>(__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(out))));
+    }
+    return (i - outside) + rangeCountScalar(v + i, n - i, lo, hi);
+}
+
+// ----------------------------------------
+// AVX-512 (8 x 64 bits / 16 x 32 bits por registo, comparações sem sinal nativas)
+__attribute__((target("avx512f")))
+uint64_t sumAvx512(const uint64_t* v, size_t n) {
+    __m512i a0 = _mm512_setzero_si512(), a1 = a0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm512_add_epi64(a0, _mm512_loadu_si512(v + i));
+        a1 = _mm512_add_epi64(a1, _mm512_loadu_si512(v + i + 8));
+    }
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, _mm512_add_epi64(a0, a1));
+    uint64_t total = 0;
+    for (int l = 0; l < 8; ++l) total += lanes[l];
+    for (; i < n; ++i) total += v[i];
+    return total;
+}
+
+__attribute__((target("avx512f")))
+MaxResult maxIndexAvx512(const uint64_t* v, size_t n) {
+    if (n < 16) return maxIndexScalar(v, n);
+    const __m512i step = _mm512_set1_epi64(8);
+    __m512i idx = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    __m512i best = _mm512_loadu_si512(v);
+    __m512i bestIdx = idx;
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        idx = _mm512_add_epi64(idx, step);
+        __m512i x = _mm512_loadu_si512(v + i);
+        __mmask8 gt = _mm512_cmpgt_epu64_mask(x, best);
+        best = _mm512_mask_mov_epi64(best, gt, x);
+        bestIdx = _mm512_mask_mov_epi64(bestIdx, gt, idx);
+    }
+    alignas(64) uint64_t vals[8];
+    alignas(64) uint64_t idxs[8];
+    _mm512_store_si512(vals, best);
+    _mm512_store_si512(idxs, bestIdx);
+    MaxResult r{vals[0], idxs[0]};
+    for (int l = 1; l < 8; ++l) {
+        if (vals[l] > r.value || (vals[l] == r.value && idxs[l] < r.index)) r = {vals[l], idxs[l]};
+    }
+    for (; i < n; ++i) {
+        if (v[i] > r.value) r = {v[i], i};
+    }
+    return r;
+}
+
+__attribute__((target("avx512f,popcnt")))
+void histogramAvx512(const uint64_t* v, size_t n, const uint64_t* bounds, size_t nb, uint64_t* counts) {
+    __m512i b[kMaxVectorBounds];
+    uint64_t tot[kMaxVectorBounds];
+    for (size_t k = 0; k < nb; ++k) {
+        b[k] = _mm512_set1_epi64(static_cast<long long>(bounds[k]));
+        tot[k] = 0;
+    }
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(v + i);
+        for (size_t k = 0; k < nb; ++k) tot[k] += static_cast<uint64_t>(__builtin_popcount(_mm512_cmplt_epu64_mask(x, b[k])));
+    }
+    for (size_t k = 0; k < nb; ++k) {
+        for (size_t j = i; j < n; ++j) tot[k] += (v[j] < bounds[k]);
+    }
+    finishHistogram(tot, n, nb, counts);
+}
+
+__attribute__((target("avx512f,popcnt")))
+size_t rangeCountAvx512(const int32_t* v, size_t n, int32_t lo, int32_t hi) {
+    const __m512i vlo = _mm512_set1_epi32(lo);
+    const __m512i vhi = _mm512_set1_epi32(hi);
+    size_t inside = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(v + i);
+        __mmask16 in = _mm512_cmpge_epi32_mask(x, vlo) & _mm512_cmple_epi32_mask(x, vhi);
+        inside += static_cast<size_t>(__builtin_popcount(in));
+    }
+    return inside + rangeCountScalar(v + i, n - i, lo, hi);
+}
+#endif // KERNELS_X86
+
+Isa& currentIsa() {
+    static Isa isa = detectIsa();
+    return isa;
+}
+
+} // namespace
+
+Isa detectIsa() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+#endif
+    return Isa::Scalar;
+}
+
+Isa activeIsa() {
+    return currentIsa();
+}
+
+bool setIsa(Isa isa) {
+    if (static_cast<int>(isa) > static_cast<int>(detectIsa())) return false;
+    currentIsa() = isa;
+    return true;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX512: return "avx512";
+        case Isa::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+uint64_t sum(const uint64_t* v, size_t n) {
+#ifdef KERNELS_X86
+    switch (currentIsa()) {
+        case Isa::AVX512: return sumAvx512(v, n);
+        case Isa::AVX2: return sumAvx2(v, n);
+        default: break;
+    }
+#endif
+    return sumScalar(v, n);
+}
+
+MaxResult maxIndex(const uint64_t* v, size_t n) {
+#ifdef KERNELS_X86
+    switch (currentIsa()) {
+        case Isa::AVX512: return maxIndexAvx512(v, n);
+        case Isa::AVX2: return maxIndexAvx2(v, n);
+        default: break;
+    }
+#endif
+    return maxIndexScalar(v, n);
+}
+
+void histogram(const uint64_t* v, size_t n, const uint64_t* bounds, size_t nb, uint64_t* counts) {
+    if (nb == 0) { counts[0] = n; return; }
+#ifdef KERNELS_X86
+    if (nb <= kMaxVectorBounds) {
+        switch (currentIsa()) {
+            case Isa::AVX512: histogramAvx512(v, n, bounds, nb, counts); return;
+            case Isa::AVX2: histogramAvx2(v, n, bounds, nb, counts); return;
+            default: break;
+        }
+    }
+#endif
+    histogramScalar(v, n, bounds, nb, counts);
+}
+
+size_t rangeCount(const int32_t* v, size_t n, int32_t lo, int32_t hi) {
+#ifdef KERNELS_X86
+    switch (currentIsa()) {
+        case Isa::AVX512: return rangeCountAvx512(v, n, lo, hi);
+        case Isa::AVX2: return rangeCountAvx2(v, n, lo, hi);
+        default: break;
+    }
+#endif
+    return rangeCountScalar(v, n, lo, hi);
+}
+
+} // namespace kernels
@@ -0,0 +1,53 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+/**
+ * @file Kernels.hpp
+ * @brief Reduções vetorizadas (AVX2 / AVX-512, com versão escalar) sobre colunas de tamanhos e datas.
+ *
+ * A implementação é escolhida em tempo de execução consoante o CPU. Em
+ * compiladores/arquiteturas sem suporte só existe a versão escalar.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kernels {
+
+/** @brief Conjunto de instruções usado pelas funções deste módulo. */
+enum class Isa { Scalar, AVX2, AVX512 };
+
+/** @brief Resultado de maxIndex. */
+struct MaxResult {
+    uint64_t value; ///< Maior valor (0 se n == 0).
+    size_t index;   ///< Índice da primeira ocorrência (SIZE_MAX se n == 0).
+};
+
+/** @brief Melhor conjunto de instruções suportado por este CPU. */
+Isa detectIsa();
+/** @brief Conjunto de instruções atualmente em uso. */
+Isa activeIsa();
+/**
+ * @brief Força um conjunto de instruções (ex.: para comparar no benchmark).
+ * @return false se o CPU não o suporta (nesse caso nada muda).
+ */
+bool setIsa(Isa isa);
+/** @brief Nome legível ("scalar", "avx2", "avx512"). */
+const char* isaName(Isa isa);
+
+/** @brief Soma de n valores. */
+uint64_t sum(const uint64_t* v, size_t n);
+/** @brief Maior valor e índice da sua primeira ocorrência. */
+MaxResult maxIndex(const uint64_t* v, size_t n);
+/**
+ * @brief Histograma por faixas.
+ * @param bounds nb limites crescentes; a faixa k conta os valores com bounds[k-1] <= v < bounds[k].
+ * @param counts Saída com nb + 1 posições (a primeira faixa é v < bounds[0], a última v >= bounds[nb-1]).
+ */
+void histogram(const uint64_t* v, size_t n, const uint64_t* bounds, size_t nb, uint64_t* counts);
+/** @brief Número de valores com lo <= v <= hi. */
+size_t rangeCount(const int32_t* v, size_t n, int32_t lo, int32_t hi);
+
+} // namespace kernels
+
+#endif // KERNELS_HPP
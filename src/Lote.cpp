@@ -0,0 +1,224 @@
+#include "Lote.hpp"
+#include "PathResolver.hpp"
+#include <algorithm>
+
+Lote::Alteracoes& Lote::de(Directory& dir) {
+    auto it = indice.find(&dir);
+    if (it != indice.end()) return porDiretoria[it->second];
+    indice.emplace(&dir, porDiretoria.size());
+    porDiretoria.emplace_back();
+    porDiretoria.back().dir = &dir;
+    return porDiretoria.back();
+}
+
+void Lote::adicionarFicheiro(Directory& dir, const std::string& nome, size_t tamanho, const std::string& data) {
+    de(dir).entramFicheiros.push_back(std::make_shared<File>(nome, tamanho, data));
+    ++operacoes;
+}
+
+void Lote::adicionarCopia(Directory& dir, const File& origem, const std::string& nome) {
+    de(dir).entramFicheiros.push_back(std::make_shared<File>(nome, origem.getDados()));
+    ++operacoes;
+}
+
+void Lote::adicionarDiretoria(Directory& pai, std::shared_ptr<Directory> d) {
+    if (!d) return;
+    de(pai).entramDiretorias.push_back(std::move(d));
+    ++operacoes;
+}
+
+void Lote::removerFicheiro(Directory& dir, const File* f) {
+    if (!f) return;
+    de(dir).saemFicheiros.push_back({f, nullptr, 0});
+    ++operacoes;
+}
+
+void Lote::removerDiretoria(Directory& pai, const Directory* d) {
+    if (!d) return;
+    de(pai).saemDiretorias.push_back({d, nullptr, 0});
+    ++operacoes;
+}
+
+void Lote::renomearFicheiro(Directory& dir, const File* f, const std::string& novo) {
+    if (!f) return;
+    de(dir).renomeacoes.emplace_back(f, novo);
+    ++operacoes;
+}
+
+void Lote::moverFicheiro(Directory& origem, const File* f, Directory& destino) {
+    if (!f) return;
+    // Reserva já o lugar no destino para as chegadas ficarem pela ordem dos pedidos.
+    auto& entram = de(destino).entramFicheiros;
+    entram.push_back(nullptr);
+    size_t lugar = entram.size() - 1;
+    de(origem).saemFicheiros.push_back({f, &destino, lugar});
+    ++operacoes;
+}
+
+void Lote::moverDiretoria(Directory& pai, const Directory* d, Directory& destino) {
+    if (!d) return;
+    auto& entram = de(destino).entramDiretorias;
+    entram.push_back(nullptr);
+    size_t lugar = entram.size() - 1;
+    de(pai).saemDiretorias.push_back({d, &destino, lugar});
+    ++operacoes;
+}
+
+// Os nós marcados saem (para o lugar reservado no destino, se for um movimento)
+// e os restantes ficam pela ordem original.
+template <typename T, typename Fn>
+size_t Lote::compactar(std::vector<std::shared_ptr<T>>& lista, std::vector<Saida<T>>& saem, Fn&& aoSair) {
+    std::sort(saem.begin(), saem.end(), [](const auto& a, const auto& b) { return a.no < b.no; });
+    size_t escrito = 0, retirados = 0;
+    for (size_t i = 0; i < lista.size(); ++i) {
+        const T* p = lista[i].get();
+        auto it = std::lower_bound(saem.begin(), saem.end(), p,
+            [](const auto& s, const T* q) { return s.no < q; });
+        if (it != saem.end() && it->no == p) {
+            aoSair(*it, std::move(lista[i]));
+            ++retirados;
+            continue;
+        }
+        if (escrito != i) lista[escrito] = std::move(lista[i]);
+        ++escrito;
+    }
+    lista.resize(escrito);
+    return retirados;
+}
+
+// Uma subárvore removida sai da árvore e é libertada (a menos que alguém a
+// mantenha), por isso as operações lá dentro não teriam efeito visível: são
+// descartadas antes de qualquer alteração, tal como os movimentos para lá.
+// Os intervalos de rótulos das removidas, ordenados, dizem em O(log n) se uma
+// diretoria está dentro de alguma.
+void Lote::descartarDentroDeRemovidas() {
+    struct Intervalo { uint32_t arvore; uint64_t inicio, fim; };
+    std::vector<Intervalo> removidas;
+    for (const auto& a : porDiretoria) {
+        for (const auto& s : a.saemDiretorias) {
+            if (!s.destino) removidas.push_back({ s.no->rotuloArvore, s.no->rotuloInicio, s.no->rotuloFim });
+        }
+    }
+    if (removidas.empty()) return;
+    std::sort(removidas.begin(), removidas.end(), [](const Intervalo& x, const Intervalo& y) {
+        return x.arvore != y.arvore ? x.arvore < y.arvore : x.inicio < y.inicio;
+    });
+    // Só ficam as mais exteriores (as outras também seriam descartadas).
+    size_t n = 0;
+    for (const auto& r : removidas) {
+        if (n > 0 && removidas[n - 1].arvore == r.arvore && r.fim <= removidas[n - 1].fim) continue;
+        removidas[n++] = r;
+    }
+    removidas.resize(n);
+    // Dentro da subárvore de uma removida, incluindo a própria.
+    auto dentro = [&](const Directory* d) {
+        auto it = std::upper_bound(removidas.begin(), removidas.end(), d, [](const Directory* x, const Intervalo& r) {
+            return x->rotuloArvore != r.arvore ? x->rotuloArvore < r.arvore : x->rotuloInicio < r.inicio;
+        });
+        if (it == removidas.begin()) return false;
+        --it;
+        return it->arvore == d->rotuloArvore && d->rotuloFim <= it->fim;
+    };
+    auto destinoDentro = [&](const auto& s) { return s.destino && dentro(s.destino); };
+    for (auto& a : porDiretoria) {
+        if (dentro(a.dir)) {
+            // Os lugares reservados em a para movimentos de fora ficam por preencher:
+            // esses movimentos também são descartados, a seguir.
+            a.saemFicheiros.clear();
+            a.saemDiretorias.clear();
+            a.renomeacoes.clear();
+            a.entramFicheiros.clear();
+            a.entramDiretorias.clear();
+            continue;
+        }
+        a.saemFicheiros.erase(std::remove_if(a.saemFicheiros.begin(), a.saemFicheiros.end(), destinoDentro),
+                              a.saemFicheiros.end());
+        a.saemDiretorias.erase(std::remove_if(a.saemDiretorias.begin(), a.saemDiretorias.end(), destinoDentro),
+                               a.saemDiretorias.end());
+    }
+}
+
+size_t Lote::aplicar(PathResolver* resolver) {
+    size_t aplicadas = 0;
+    bool mudouFicheiros = false, mudouEstrutura = false, renomeou = false;
+
+    descartarDentroDeRemovidas();
+
+    // 1) Saídas: uma compactação por diretoria.
+    for (auto& a : porDiretoria) {
+        // Remoções contam aqui; os movimentos contam quando chegam ao destino.
+        if (!a.saemFicheiros.empty()) {
+            mudouFicheiros |= compactar(a.dir->ficheirosParaEscrita(), a.saemFicheiros,
+                [&](const Saida<File>& s, std::shared_ptr<File>&& f) {
+                    if (s.destino) porDiretoria[indice[s.destino]].entramFicheiros[s.lugar] = std::move(f);
+                    else ++aplicadas;
+                }) > 0;
+        }
+
+        if (!a.saemDiretorias.empty() && resolver) {
+            // Os caminhos guardados deixam de ser válidos (antes de desligar o pai).
+            for (const auto& s : a.saemDiretorias) resolver->invalidateSubtree(s.no);
+        }
+        if (!a.saemDiretorias.empty()) a.dir->invalidateDigest();
+        if (!a.saemDiretorias.empty()) mudouEstrutura |= compactar(a.dir->subdirectories, a.saemDiretorias,
+            [&](const Saida<Directory>& s, std::shared_ptr<Directory>&& d) {
+                d->parent = nullptr;
+                if (s.destino) {
+                    // Os rótulos são refeitos quando chegar ao destino.
+                    porDiretoria[indice[s.destino]].entramDiretorias[s.lugar] = std::move(d);
+                } else {
+                    if (d.use_count() > 1) d->rotularComoRaiz();
+                    ++aplicadas;
+                }
+            }) > 0;
+    }
+
+    // 2) Renomeações: a entrada é substituída (os dados continuam partilhados).
+    for (auto& a : porDiretoria) {
+        if (a.renomeacoes.empty()) continue;
+        std::sort(a.renomeacoes.begin(), a.renomeacoes.end(),
+            [](const auto& x, const auto& y) { return x.first < y.first; });
+        for (auto& f : a.dir->ficheirosParaEscrita()) {
+            auto it = std::lower_bound(a.renomeacoes.begin(), a.renomeacoes.end(), f.get(),
+                [](const auto& r, const File* q) { return r.first < q; });
+            if (it == a.renomeacoes.end() || it->first != f.get()) continue;
+            f = std::make_shared<File>(it->second, f->getDados());
+            renomeou = true;
+            ++aplicadas;
+        }
+    }
+
+    // 3) Entradas: um bloco por diretoria (os lugares de movimentos falhados ficam vazios).
+    for (auto& a : porDiretoria) {
+        if (!a.entramFicheiros.empty()) {
+            auto& lista = a.dir->ficheirosParaEscrita();
+            lista.reserve(lista.size() + a.entramFicheiros.size());
+            for (auto& f : a.entramFicheiros) {
+                if (!f) continue;
+                lista.push_back(std::move(f));
+                mudouFicheiros = true;
+                ++aplicadas;
+            }
+        }
+        for (auto& d : a.entramDiretorias) {
+            if (!d) continue;
+            d->parent = a.dir;
+            a.dir->subdirectories.push_back(std::move(d));
+            a.dir->rotularFilho(*a.dir->subdirectories.back());
+            if (resolver) resolver->subtreeAttached(a.dir->subdirectories.back());
+            a.dir->invalidateDigest();
+            mudouEstrutura = true;
+            ++aplicadas;
+        }
+    }
+
+    // Um só incremento de cada versão para o lote inteiro.
+    if (mudouFicheiros) ++Directory::filesCounter;
+    if (mudouEstrutura) ++Directory::structureCounter;
+    if (renomeou) ++File::modificationCounter;
+
+    porDiretoria.clear();
+    indice.clear();
+    operacoes = 0;
+    return aplicadas;
+}
@@ -0,0 +1,104 @@
+#ifndef LOTE_HPP
+#define LOTE_HPP
+
+/**
+ * @file Lote.hpp
+ * @brief Declara a classe Lote (alterações à árvore aplicadas em bloco).
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Directory.hpp"
+
+class PathResolver;
+
+/**
+ * @class Lote
+ * @brief Acumula adições, remoções, renomeações e movimentos e aplica-os de uma só vez.
+ *
+ * Os nós são indicados por ponteiro (não por nome), por isso não há pesquisas
+ * repetidas nas listas. Em aplicar(), cada diretoria afetada é compactada numa
+ * única passagem (erase-remove) e recebe as adições num só bloco; os contadores
+ * de versão (e com eles as caches de caminhos e a árvore congelada) mudam uma
+ * vez por lote em vez de uma vez por operação.
+ *
+ * As operações são aplicadas pela ordem: remoções e saídas de movimentos,
+ * renomeações, e por fim adições e chegadas de movimentos (pela ordem em que
+ * foram pedidas). Uma lista de ficheiros partilhada (ver Directory::clone) é
+ * separada antes de ser alterada e os ficheiros renomeados são substituídos
+ * por entradas novas, por isso a outra cópia não muda.
+ */
+class Lote {
+public:
+    /** @brief Acrescenta um ficheiro novo a dir. */
+    void adicionarFicheiro(Directory& dir, const std::string& nome, size_t tamanho, const std::string& data);
+    /** @brief Acrescenta a dir uma cópia de origem com outro nome (partilha tamanho e data). */
+    void adicionarCopia(Directory& dir, const File& origem, const std::string& nome);
+    /** @brief Acrescenta a subdiretoria d (já construída) a pai. */
+    void adicionarDiretoria(Directory& pai, std::shared_ptr<Directory> d);
+    /** @brief Retira o ficheiro f da diretoria dir. */
+    void removerFicheiro(Directory& dir, const File* f);
+    /**
+     * @brief Retira a subdiretoria d (e a sua subárvore) de pai.
+     * @details As outras operações do lote dentro da subárvore de d (ou com destino
+     * nela) são descartadas em aplicar() e não contam como aplicadas.
+     */
+    void removerDiretoria(Directory& pai, const Directory* d);
+    /** @brief Muda o nome do ficheiro f da diretoria dir. */
+    void renomearFicheiro(Directory& dir, const File* f, const std::string& novo);
+    /** @brief Passa o ficheiro f de origem para destino (o mesmo objeto, sem cópia). */
+    void moverFicheiro(Directory& origem, const File* f, Directory& destino);
+    /** @brief Passa a subdiretoria d de pai para destino. */
+    void moverDiretoria(Directory& pai, const Directory* d, Directory& destino);
+
+    /** @brief Indica se não há operações pendentes. */
+    bool vazio() const { return operacoes == 0; }
+    /** @brief Número de operações pendentes. */
+    size_t tamanho() const { return operacoes; }
+
+    /**
+     * @brief Aplica as operações pendentes e esvazia o lote.
+     * @param resolver Se indicado, invalida os caminhos das subárvores removidas ou movidas
+     *        e indexa os nomes das que chegam.
+     * @return Número de operações efetivamente aplicadas.
+     */
+    size_t aplicar(PathResolver* resolver = nullptr);
+
+private:
+    // Saída de um nó de uma diretoria; se destino != nullptr o nó vai para o
+    // lugar reservado em destino (posição vaga na lista de adições).
+    template <typename T>
+    struct Saida {
+        const T* no;
+        Directory* destino;
+        size_t lugar;
+    };
+
+    // Alterações pendentes de uma diretoria.
+    struct Alteracoes {
+        Directory* dir = nullptr;
+        std::vector<Saida<File>> saemFicheiros;
+        std::vector<Saida<Directory>> saemDiretorias;
+        std::vector<std::shared_ptr<File>> entramFicheiros;
+        std::vector<std::shared_ptr<Directory>> entramDiretorias;
+        std::vector<std::pair<const File*, std::string>> renomeacoes;
+    };
+
+    Alteracoes& de(Directory& dir);
+    // Tira as operações dentro de subárvores removidas pelo próprio lote.
+    void descartarDentroDeRemovidas();
+
+    // Compacta lista numa só passagem; aoSair recebe cada nó retirado.
+    template <typename T, typename Fn>
+    static size_t compactar(std::vector<std::shared_ptr<T>>& lista, std::vector<Saida<T>>& saem, Fn&& aoSair);
+
+    // Ordem de inserção preservada: o índice evita depender da ordem do hash.
+    std::vector<Alteracoes> porDiretoria;
+    std::unordered_map<const Directory*, size_t> indice;
+    size_t operacoes = 0;
+};
+
+#endif // LOTE_HPP
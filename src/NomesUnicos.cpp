@@ -0,0 +1,29 @@
+#include "NomesUnicos.hpp"
+#include <cstdio>
+
+void NomesUnicos::reservar(const std::string& nome) {
+    usados.insert(nome);
+}
+
+bool NomesUnicos::usado(const std::string& nome) const {
+    return usados.count(nome) != 0;
+}
+
+std::string NomesUnicos::atribuir(const std::string& nome) {
+    if (usados.insert(nome).second) return nome;
+
+    // O nome determina base e extensão, por isso serve de chave para o próximo sufixo.
+    std::string base = nome;
+    std::string ext;
+    size_t pos = nome.find_last_of('.');
+    if (pos != std::string::npos) { base = nome.substr(0, pos); ext = nome.substr(pos); }
+
+    int& seq = proximo.try_emplace(nome, 1).first->second;
+    std::string destName;
+    for (;;) {
+        char buf[64]; snprintf(buf, sizeof(buf), "_%03d", seq);
+        destName = base + buf + ext;
+        seq++;
+        if (usados.insert(destName).second) return destName;
+    }
+}
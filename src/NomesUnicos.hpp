@@ -0,0 +1,42 @@
+#ifndef NOMESUNICOS_HPP
+#define NOMESUNICOS_HPP
+
+/**
+ * @file NomesUnicos.hpp
+ * @brief Declara a classe NomesUnicos (atribuição de nomes sem colisões).
+ */
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @class NomesUnicos
+ * @brief Atribui nomes únicos num destino, acrescentando sufixos _NNN quando necessário.
+ *
+ * Para "nome.ext" já usado tenta "nome_001.ext", "nome_002.ext", ... (o
+ * primeiro livre), como o CopyBatch sempre fez. Os nomes usados ficam num
+ * conjunto de hash e, para cada nome pedido, guarda-se o próximo número a
+ * tentar: como o conjunto só cresce, o primeiro sufixo livre nunca recua, por
+ * isso N cópias do mesmo nome custam tempo linear em vez de quadrático.
+ */
+class NomesUnicos {
+public:
+    /** @brief Marca um nome como já existente no destino. */
+    void reservar(const std::string& nome);
+    /** @brief Indica se o nome já está usado. */
+    bool usado(const std::string& nome) const;
+    /**
+     * @brief Devolve um nome livre derivado de nome e reserva-o.
+     * @return nome, se estiver livre; senão base_NNN.ext com o menor NNN livre.
+     */
+    std::string atribuir(const std::string& nome);
+    /** @brief Número de nomes reservados. */
+    size_t tamanho() const { return usados.size(); }
+
+private:
+    std::unordered_set<std::string> usados;
+    std::unordered_map<std::string, int> proximo; // nome pedido -> próximo sufixo a tentar
+};
+
+#endif // NOMESUNICOS_HPP
@@ -0,0 +1,130 @@
+#include "Ocupacao.hpp"
+#include <unordered_set>
+#include "Perfil.hpp"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+uint64_t Ocupacao::Relatorio::total() const {
+    return nosDiretorias + nosFicheiros + dadosFicheiros + nomes + datas + vetores + blocosControlo + indices;
+}
+
+double Ocupacao::Relatorio::bytesPorFicheiro() const {
+    return ficheiros ? static_cast<double>(total()) / static_cast<double>(ficheiros) : 0.0;
+}
+
+// DFS com pilha explícita (árvores fundas não esgotam a pilha de chamadas).
+// Só o que está partilhado (use_count > 1) passa pelos conjuntos de vistos,
+// por isso uma árvore sem cópias não paga um conjunto com um elemento por nó.
+Ocupacao::Relatorio Ocupacao::medir(const Directory& raiz) {
+    perfil::Medida medida("Ocupacao::medir");
+    Relatorio r;
+    std::unordered_set<const void*> listasVistas, ficheirosVistos, dadosVistos;
+    std::vector<const Directory*> pilha{ &raiz };
+    while (!pilha.empty()) {
+        const Directory* d = pilha.back();
+        pilha.pop_back();
+        perfil::nos();
+
+        r.diretorias++;
+        r.nosDiretorias += sizeof(Directory);
+        r.blocosControlo += kBlocoControlo;
+        r.nomes += bytesTexto(d->name);
+        r.folgaNomes += bytesTexto(d->name) ? d->name.capacity() - d->name.size() : 0;
+        r.vetores += bytesVetor(d->subdirectories);
+        r.folgaVetores += (d->subdirectories.capacity() - d->subdirectories.size()) * sizeof(std::shared_ptr<Directory>);
+        for (const auto& sub : d->subdirectories) pilha.push_back(sub.get());
+
+        if (!d->files) continue;
+        r.entradas += d->files->size();
+        if (d->files.use_count() > 1) {
+            r.listasPartilhadas++;
+            if (!listasVistas.insert(d->files.get()).second) continue;
+        }
+        const Directory::ListaFicheiros& lista = *d->files;
+        r.listas++;
+        r.vetores += sizeof(Directory::ListaFicheiros) + bytesVetor(lista);
+        r.blocosControlo += kBlocoControlo;
+        r.folgaVetores += (lista.capacity() - lista.size()) * sizeof(std::shared_ptr<File>);
+        perfil::nos(lista.size());
+
+        for (const auto& f : lista) {
+            if (f.use_count() > 1 && !ficheirosVistos.insert(f.get()).second) continue;
+            r.ficheiros++;
+            r.nosFicheiros += sizeof(File);
+            r.blocosControlo += kBlocoControlo;
+            r.nomes += bytesTexto(f->name);
+            r.folgaNomes += bytesTexto(f->name) ? f->name.capacity() - f->name.size() : 0;
+
+            const File::Dados* dados = f->dados.get();
+            if (!dados) continue;
+            if (f->dados.use_count() > 1 && !dadosVistos.insert(dados).second) continue;
+            r.dados++;
+            r.dadosFicheiros += sizeof(File::Dados);
+            r.blocosControlo += kBlocoControlo;
+            r.datas += bytesTexto(dados->date);
+        }
+    }
+    return r;
+}
+
+// Os textos partilhados (File numa lista partilhada) podem ser compactados no
+// lugar: o conteúdo fica igual, só a capacidade muda.
+Ocupacao::Compactacao Ocupacao::compactar(Directory& raiz) {
+    perfil::Medida medida("Ocupacao::compactar");
+    Compactacao c;
+    auto vetor = [&c](auto& v) {
+        uint64_t antes = bytesVetor(v);
+        v.shrink_to_fit();
+        uint64_t depois = bytesVetor(v);
+        if (depois < antes) { c.vetores++; c.bytes += antes - depois; }
+    };
+    auto texto = [&c](std::string& s) {
+        uint64_t antes = bytesTexto(s);
+        s.shrink_to_fit();
+        uint64_t depois = bytesTexto(s);
+        if (depois < antes) { c.nomes++; c.bytes += antes - depois; }
+    };
+
+    std::vector<Directory*> pilha{ &raiz };
+    while (!pilha.empty()) {
+        Directory* d = pilha.back();
+        pilha.pop_back();
+        perfil::nos();
+        texto(d->name);
+        vetor(d->subdirectories);
+        for (const auto& sub : d->subdirectories) pilha.push_back(sub.get());
+
+        if (!d->files) continue;
+        if (d->files->empty()) {
+            // getFiles() devolve uma lista vazia comum quando não há lista.
+            if (d->files.use_count() == 1) c.bytes += sizeof(Directory::ListaFicheiros) + kBlocoControlo + bytesVetor(*d->files);
+            d->files.reset();
+            c.listasVazias++;
+            continue;
+        }
+        vetor(*d->files);
+        perfil::nos(d->files->size());
+        for (const auto& f : *d->files) texto(f->name);
+    }
+    return c;
+}
+
+uint64_t Ocupacao::heapEmUso() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return static_cast<uint64_t>(mi.uordblks) + static_cast<uint64_t>(mi.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+bool Ocupacao::devolverAoSistema() {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef OCUPACAO_HPP
+#define OCUPACAO_HPP
+
+/**
+ * @file Ocupacao.hpp
+ * @brief Declara a classe Ocupacao (memória ocupada pelo modelo em memória e compactação).
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Directory.hpp"
+
+/**
+ * @class Ocupacao
+ * @brief Mede quanto ocupa uma árvore em memória, por categoria, e compacta-a.
+ *
+ * Os valores são os bytes pedidos ao alocador: o tamanho dos objetos, a
+ * capacidade reservada dos vetores e dos textos que não cabem no próprio
+ * std::string, e os blocos de controlo dos shared_ptr (todos os nós são criados
+ * com make_shared, por isso o bloco vem na mesma alocação que o objeto). O
+ * arredondamento do malloc fica de fora; heapEmUso() dá o total real do processo
+ * para comparação.
+ *
+ * Listas de ficheiros, ficheiros e dados partilhados (ver Directory::clone e
+ * File::Dados) são contados uma só vez.
+ */
+class Ocupacao {
+public:
+    /** @brief Memória de uma árvore, em bytes, e as contagens correspondentes. */
+    struct Relatorio {
+        uint64_t diretorias = 0;
+        uint64_t ficheiros = 0;          ///< Objetos File distintos.
+        uint64_t entradas = 0;           ///< Entradas nas listas (uma cópia partilhada conta em cada diretoria).
+        uint64_t listas = 0;             ///< Listas de ficheiros distintas.
+        uint64_t listasPartilhadas = 0;
+        uint64_t dados = 0;              ///< Blocos File::Dados distintos.
+
+        uint64_t nosDiretorias = 0;      ///< sizeof(Directory) por diretoria.
+        uint64_t nosFicheiros = 0;       ///< sizeof(File) por ficheiro.
+        uint64_t dadosFicheiros = 0;     ///< sizeof(File::Dados) por bloco de dados.
+        uint64_t nomes = 0;              ///< Nomes de diretorias e ficheiros fora do std::string.
+        uint64_t datas = 0;              ///< Datas fora do std::string.
+        uint64_t vetores = 0;            ///< Vetores de subdiretorias e listas de ficheiros (com a folga).
+        uint64_t blocosControlo = 0;     ///< Contadores dos shared_ptr.
+        uint64_t indices = 0;            ///< Caches e cópias congeladas (preenchido pelo SistemaFicheiros).
+
+        uint64_t folgaVetores = 0;       ///< Capacidade reservada e não usada dos vetores.
+        uint64_t folgaNomes = 0;         ///< Capacidade reservada e não usada dos nomes.
+
+        /** @brief Soma de todas as categorias (as folgas já estão incluídas). */
+        uint64_t total() const;
+        /** @brief Bytes do modelo por ficheiro (0 se não houver ficheiros). */
+        double bytesPorFicheiro() const;
+    };
+
+    /** @brief O que compactar() conseguiu libertar. */
+    struct Compactacao {
+        uint64_t vetores = 0;            ///< Vetores cuja capacidade foi reduzida.
+        uint64_t nomes = 0;              ///< Nomes cuja capacidade foi reduzida.
+        uint64_t listasVazias = 0;       ///< Listas de ficheiros vazias libertadas.
+        uint64_t bytes = 0;              ///< Total libertado.
+    };
+
+    /** @brief Mede a subárvore de raiz (sem os índices). */
+    static Relatorio medir(const Directory& raiz);
+    /**
+     * @brief Ajusta a capacidade dos vetores e dos nomes ao conteúdo (depois de remoções em massa).
+     * @details O conteúdo não muda, por isso as versões da árvore, as caches e a
+     *          cópia congelada continuam válidas.
+     */
+    static Compactacao compactar(Directory& raiz);
+
+    /** @brief Bytes em uso no heap de todo o processo (0 se o alocador não o indicar). */
+    static uint64_t heapEmUso();
+    /** @brief Devolve ao sistema operativo a memória livre do heap (se o alocador o permitir). */
+    static bool devolverAoSistema();
+
+    /** @brief Bytes de s fora do próprio objeto (0 se o texto cabe no std::string). */
+    static uint64_t bytesTexto(const std::string& s) {
+        static const size_t interno = std::string().capacity();
+        return s.capacity() > interno ? s.capacity() + 1 : 0;
+    }
+    /** @brief Bytes do buffer de um vetor (capacidade reservada). */
+    template <typename T>
+    static uint64_t bytesVetor(const std::vector<T>& v) {
+        return static_cast<uint64_t>(v.capacity()) * sizeof(T);
+    }
+    /**
+     * @brief Estimativa das estruturas de um unordered_map (baldes e nós).
+     * @details Cada nó guarda o par, o ponteiro para o seguinte e, no pior caso, o hash.
+     *          Os textos das chaves e dos valores não estão incluídos.
+     */
+    template <typename K, typename V, typename H, typename E, typename A>
+    static uint64_t bytesMapa(const std::unordered_map<K, V, H, E, A>& m) {
+        using Par = typename std::unordered_map<K, V, H, E, A>::value_type;
+        return static_cast<uint64_t>(m.bucket_count()) * sizeof(void*)
+             + static_cast<uint64_t>(m.size()) * (sizeof(Par) + sizeof(void*) + sizeof(size_t));
+    }
+
+    /** @brief Estimativa do bloco de controlo de um make_shared (contadores e ponteiro da vtable). */
+    static constexpr uint64_t kBlocoControlo = sizeof(void*) + 2 * sizeof(int);
+};
+
+#endif // OCUPACAO_HPP
@@ -0,0 +1,231 @@
+#include "PathResolver.hpp"
+#include <algorithm>
+#include <queue>
+#include "Ocupacao.hpp"
+
+PathResolver::PathResolver(size_t capacity)
+    : root(nullptr), capacity(capacity), nameIndexBase(0), nameIndexValid(false) {}
+
+void PathResolver::setRoot(const std::shared_ptr<Directory>& r) {
+    if (r == root) return;
+    clear();
+    root = r;
+}
+
+void PathResolver::clear() {
+    lru.clear();
+    cache.clear();
+    nameIndex.clear();
+    candidates.clear();
+    nameIndexValid = false;
+}
+
+void PathResolver::shrinkToFit() {
+    clear();
+    cache.rehash(0);
+    nameIndex.rehash(0);
+    candidates.shrink_to_fit();
+    keyBuf.shrink_to_fit();
+}
+
+// Nós da lista (entrada + dois ponteiros), as duas tabelas e os textos das chaves.
+size_t PathResolver::memoryBytes() const {
+    uint64_t b = Ocupacao::bytesMapa(cache) + Ocupacao::bytesMapa(nameIndex) + Ocupacao::bytesVetor(candidates)
+               + Ocupacao::bytesTexto(keyBuf);
+    b += lru.size() * (sizeof(CacheEntry) + 2 * sizeof(void*));
+    for (const auto& e : lru) b += 2 * Ocupacao::bytesTexto(e.key); // na entrada e na chave da tabela
+    for (const auto& p : nameIndex) b += Ocupacao::bytesTexto(p.first);
+    return static_cast<size_t>(b);
+}
+
+bool PathResolver::isPath(std::string_view path) {
+    return path.find_first_of("\\/") != std::string_view::npos;
+}
+
+// Normaliza o caminho para a chave da cache: segmentos unidos por '/'.
+// Reutiliza keyBuf para não alocar em cada pesquisa.
+void PathResolver::buildKey(std::string_view path) {
+    keyBuf.clear();
+    forEachSegment(path, [this](std::string_view seg) {
+        if (!keyBuf.empty()) keyBuf.push_back('/');
+        keyBuf.append(seg.data(), seg.size());
+        return true;
+    });
+}
+
+// Desce a partir da raiz segmento a segmento: O(profundidade x filhos).
+std::shared_ptr<Directory> PathResolver::walk(std::string_view path) const {
+    std::shared_ptr<Directory> cur = root;
+    forEachSegment(path, [&cur](std::string_view seg) {
+        cur = cur->findSubdirectory(seg);
+        return cur != nullptr;
+    });
+    return cur;
+}
+
+// Confirma, subindo pelos pais, que dir continua a estar no caminho key.
+bool PathResolver::matchesKey(const Directory* dir, std::string_view key) const {
+    std::string_view rest = key;
+    const Directory* cur = dir;
+    while (cur != root.get()) {
+        if (!cur || rest.empty()) return false;
+        size_t pos = rest.rfind('/');
+        std::string_view seg = (pos == std::string_view::npos) ? rest : rest.substr(pos + 1);
+        if (cur->getName() != seg) return false;
+        rest = (pos == std::string_view::npos) ? std::string_view() : rest.substr(0, pos);
+        cur = cur->getParent();
+    }
+    return rest.empty();
+}
+
+std::shared_ptr<Directory> PathResolver::resolve(std::string_view path) {
+    if (!root) return nullptr;
+
+    if (!isPath(path)) {
+        // Nome simples: índice nome -> primeira ocorrência em largura.
+        if (!nameIndexValid) rebuildNameIndex();
+        keyBuf.assign(path.data(), path.size());
+        auto it = nameIndex.find(keyBuf);
+        if (it == nameIndex.end()) return nullptr;
+        auto dir = firstInBfs(it->second, path);
+        if (it->second.first.expired() && it->second.more == UINT32_MAX) nameIndex.erase(it);
+        return dir;
+    }
+
+    buildKey(path);
+    auto it = cache.find(keyBuf);
+    if (it != cache.end()) {
+        auto entry = it->second;
+        auto dir = entry->dir.lock();
+        unsigned long long now = Directory::structureVersion();
+        // Se a árvore mudou desde que a entrada foi guardada, verifica-a subindo pelos pais.
+        if (dir && (entry->version == now || matchesKey(dir.get(), entry->key))) {
+            entry->version = now;
+            lru.splice(lru.begin(), lru, entry);
+            return dir;
+        }
+        lru.erase(entry);
+        cache.erase(it);
+    }
+
+    auto dir = walk(path);
+    if (!dir) return nullptr;
+
+    lru.push_front({keyBuf, dir, Directory::structureVersion()});
+    cache.emplace(keyBuf, lru.begin());
+    if (cache.size() > capacity) {
+        cache.erase(lru.back().key);
+        lru.pop_back();
+    }
+    return dir;
+}
+
+void PathResolver::invalidateSubtree(const Directory* dir) {
+    if (!dir) return;
+    // Remove as entradas cujo nó é dir ou um descendente de dir.
+    for (auto it = lru.begin(); it != lru.end();) {
+        auto d = it->dir.lock();
+        if (!d || d.get() == dir || d->isSubdirectoryOf(dir)) {
+            cache.erase(it->key);
+            it = lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // O índice de nomes não precisa de nada: os candidatos são validados em firstInBfs.
+}
+
+// BFS única que regista todas as diretorias por nome (já pela ordem de largura).
+void PathResolver::rebuildNameIndex() {
+    nameIndex.clear();
+    candidates.clear();
+    if (root) {
+        std::queue<std::shared_ptr<Directory>> q;
+        q.push(root);
+        while (!q.empty()) {
+            auto cur = q.front(); q.pop();
+            addCandidate(nameIndex[cur->getName()], cur);
+            for (const auto& sub : cur->getSubdirectories()) q.push(sub);
+        }
+    }
+    nameIndexBase = candidates.size();
+    nameIndexValid = true;
+}
+
+// Só a subárvore ligada é percorrida.
+void PathResolver::subtreeAttached(const std::shared_ptr<Directory>& dir) {
+    if (!nameIndexValid || !root || !dir) return;
+    if (dir != root && !dir->isSubdirectoryOf(root.get())) return;
+    indexSubtree(dir);
+    // As diretorias libertadas e as repetidas só saem quando o seu nome é procurado:
+    // com muitas entradas a mais desde a última BFS, recomeça-se.
+    if (candidates.size() > 2 * nameIndexBase + 1024) rebuildNameIndex();
+}
+
+void PathResolver::indexSubtree(const std::shared_ptr<Directory>& dir) {
+    std::vector<std::shared_ptr<Directory>> pilha{dir};
+    while (!pilha.empty()) {
+        auto cur = std::move(pilha.back());
+        pilha.pop_back();
+        addCandidate(nameIndex[cur->getName()], cur);
+        for (const auto& sub : cur->getSubdirectories()) pilha.push_back(sub);
+    }
+}
+
+void PathResolver::addCandidate(NameEntry& e, const std::shared_ptr<Directory>& dir) {
+    if (e.first.expired()) {
+        e.first = dir;
+        return;
+    }
+    candidates.push_back({dir, e.more});
+    e.more = static_cast<uint32_t>(candidates.size() - 1);
+}
+
+// Candidatos libertados ou repetidos saem da lista; os que foram desligados ou
+// mudaram de nome ficam (podem voltar) mas não contam. O resultado vale até a
+// estrutura mudar.
+std::shared_ptr<Directory> PathResolver::firstInBfs(NameEntry& e, std::string_view name) {
+    const unsigned long long now = Directory::structureVersion();
+    if (e.bestValid && e.version == now) return e.best.lock();
+    // Junta todos, ordena por objeto (as repetidas ficam seguidas) e compacta;
+    // os que ficam voltam a first e aos mesmos lugares da cadeia.
+    std::vector<uint32_t> lugares;
+    std::vector<std::weak_ptr<Directory>> dirs;
+    if (!e.first.expired()) dirs.push_back(std::move(e.first));
+    for (uint32_t k = e.more; k != UINT32_MAX; k = candidates[k].next) {
+        lugares.push_back(k);
+        if (!candidates[k].dir.expired()) dirs.push_back(std::move(candidates[k].dir));
+    }
+    std::sort(dirs.begin(), dirs.end(), std::owner_less<std::weak_ptr<Directory>>());
+    std::shared_ptr<Directory> best;
+    size_t bestDepth = 0;
+    size_t escrito = 0;
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        auto d = dirs[i].lock();
+        if (!d) continue;
+        if (escrito > 0 && dirs[escrito - 1].lock() == d) continue;
+        if (escrito != i) dirs[escrito] = std::move(dirs[i]);
+        ++escrito;
+        if (d->getName() != name || (d != root && !d->isSubdirectoryOf(root.get()))) continue;
+        size_t depth = 0;
+        for (const Directory* p = d.get(); p != root.get(); p = p->getParent()) ++depth;
+        if (!best || depth < bestDepth || (depth == bestDepth && d->labelBegin() < best->labelBegin())) {
+            best = std::move(d);
+            bestDepth = depth;
+        }
+    }
+    e.first.reset();
+    e.more = UINT32_MAX;
+    if (escrito > 0) e.first = std::move(dirs[0]);
+    for (size_t i = 1; i < escrito; ++i) {
+        uint32_t k = lugares[i - 1];
+        candidates[k] = {std::move(dirs[i]), e.more};
+        e.more = k;
+    }
+    // Os lugares que sobram ficam vazios até à próxima reconstrução.
+    for (size_t i = escrito > 0 ? escrito - 1 : 0; i < lugares.size(); ++i) candidates[lugares[i]].dir.reset();
+    e.best = best;
+    e.version = now;
+    e.bestValid = true;
+    return best;
+}
@@ -0,0 +1,127 @@
+#ifndef PATHRESOLVER_HPP
+#define PATHRESOLVER_HPP
+
+/**
+ * @file PathResolver.hpp
+ * @brief Declara a classe PathResolver (resolução de caminhos com cache).
+ */
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "Directory.hpp"
+
+/**
+ * @class PathResolver
+ * @brief Resolve caminhos ("a\\b/c") ou nomes simples ("c") para diretorias.
+ *
+ * Caminhos completos passam por uma cache LRU (caminho -> Directory) e os
+ * nomes simples por um índice nome -> diretorias com esse nome. O índice é
+ * construído com uma BFS e depois atualizado por diferença: as subárvores
+ * ligadas entretanto entram por subtreeAttached(), e as diretorias que saíram
+ * da árvore são descartadas ao validar os candidatos. A primeira
+ * em largura é a de menor profundidade e, entre essas, a de menor rótulo
+ * (a pré-ordem coincide com a BFS dentro do mesmo nível).
+ */
+class PathResolver {
+public:
+    /**
+     * @brief Constrói o resolvedor.
+     * @param capacity Número máximo de caminhos guardados na cache LRU.
+     */
+    explicit PathResolver(size_t capacity = 1024);
+
+    /** @brief Define a raiz usada na resolução (limpa as caches se mudar). */
+    void setRoot(const std::shared_ptr<Directory>& r);
+    /** @brief Esquece todas as entradas da cache e o índice de nomes. */
+    void clear();
+    /** @brief Como clear(), e liberta também os baldes das tabelas e o buffer das chaves. */
+    void shrinkToFit();
+    /** @brief Estimativa da memória da cache LRU e do índice de nomes (bytes). */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Resolve um caminho (com '\\' ou '/') ou um nome simples.
+     * @return A diretoria encontrada ou nullptr.
+     */
+    std::shared_ptr<Directory> resolve(std::string_view path);
+
+    /** @brief Invalida as entradas da cache que apontam para a subárvore de dir. */
+    void invalidateSubtree(const Directory* dir);
+    /**
+     * @brief Acrescenta ao índice de nomes a subárvore de dir, acabada de ligar (ou de mudar de nome).
+     * @details SistemaFicheiros e Lote::aplicar(resolver) já o chamam; quem ligar diretorias à
+     *          árvore por outro caminho tem de o chamar (ou chamar clear()).
+     */
+    void subtreeAttached(const std::shared_ptr<Directory>& dir);
+
+    /** @brief Indica se o texto contém algum separador ('\\' ou '/'). */
+    static bool isPath(std::string_view path);
+
+    /**
+     * @brief Percorre os segmentos não vazios de um caminho sem alocar memória.
+     * @param fn Chamada com cada segmento; se devolver false a iteração pára.
+     * @return false se a iteração foi interrompida por fn.
+     */
+    template <typename Fn>
+    static bool forEachSegment(std::string_view path, Fn&& fn) {
+        size_t start = 0;
+        while (start < path.size()) {
+            size_t end = path.find_first_of("\\/", start);
+            if (end == std::string_view::npos) end = path.size();
+            if (end > start && !fn(path.substr(start, end - start))) return false;
+            start = end + 1;
+        }
+        return true;
+    }
+
+private:
+    struct CacheEntry {
+        std::string key;
+        std::weak_ptr<Directory> dir;
+        unsigned long long version;
+    };
+
+    // Diretorias com um dado nome: a primeira aqui (a maioria dos nomes só tem uma)
+    // e as outras encadeadas em candidates a partir de more. best é a primeira em
+    // largura na versão version.
+    struct NameEntry {
+        std::weak_ptr<Directory> first;
+        uint32_t more = UINT32_MAX;
+        std::weak_ptr<Directory> best;
+        unsigned long long version = 0;
+        bool bestValid = false;
+    };
+    struct Candidate {
+        std::weak_ptr<Directory> dir;
+        uint32_t next;
+    };
+
+    std::shared_ptr<Directory> walk(std::string_view path) const;
+    bool matchesKey(const Directory* dir, std::string_view key) const;
+    void buildKey(std::string_view path);
+    void rebuildNameIndex();
+    void indexSubtree(const std::shared_ptr<Directory>& dir);
+    void addCandidate(NameEntry& e, const std::shared_ptr<Directory>& dir);
+    std::shared_ptr<Directory> firstInBfs(NameEntry& e, std::string_view name);
+
+    std::shared_ptr<Directory> root;
+    size_t capacity;
+
+    // Cache LRU: a lista guarda a ordem de uso (mais recente à frente).
+    std::list<CacheEntry> lru;
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache;
+    std::string keyBuf;
+
+    // Índice nome -> diretorias com esse nome (uma subárvore movida volta a entrar:
+    // as repetidas só saem ao validar os candidatos desse nome).
+    std::unordered_map<std::string, NameEntry> nameIndex;
+    std::vector<Candidate> candidates;
+    size_t nameIndexBase;              // candidates.size() depois da última reconstrução
+    bool nameIndexValid;
+};
+
+#endif // PATHRESOLVER_HPP
@@ -0,0 +1,295 @@
+#include "Perfil.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+namespace perfil {
+
+namespace {
+
+constexpr int kBaldes = 48;                // Balde b: duração em [2^(b-1), 2^b) ns.
+constexpr size_t kMaxEventos = 1u << 20;   // Por thread, para o traço não crescer sem limite.
+
+struct Acumulado {
+    uint64_t vezes = 0, totalNs = 0, maxNs = 0;
+    uint64_t nos = 0, bytes = 0, alocacoes = 0, chamadas = 0;
+    uint64_t baldes[kBaldes] = {};
+
+    void juntar(const Acumulado& o) {
+        vezes += o.vezes;
+        totalNs += o.totalNs;
+        maxNs = std::max(maxNs, o.maxNs);
+        nos += o.nos;
+        bytes += o.bytes;
+        alocacoes += o.alocacoes;
+        chamadas += o.chamadas;
+        for (int b = 0; b < kBaldes; ++b) baldes[b] += o.baldes[b];
+    }
+};
+
+struct Evento {
+    const char* nome;
+    int64_t inicioNs, duracaoNs;
+    uint64_t nos, bytes;
+    uint32_t tid;
+};
+
+using Pontos = std::unordered_map<const char*, Acumulado>;
+
+struct Registo;
+
+// Registos das threads vivas e o que sobrou das que já terminaram.
+// Nunca é destruído: threads podem terminar depois dos destrutores estáticos.
+struct Global {
+    std::mutex mtx;
+    std::vector<Registo*> vivos;
+    Pontos terminados;
+    std::vector<Evento> eventosTerminados;
+    uint32_t proximoTid = 1;
+};
+
+Global& global() {
+    static Global* g = new Global;
+    return *g;
+}
+
+std::atomic<bool> traco{false};
+
+// Acumulados de uma thread. O mutex só é disputado quando resumo() os lê.
+struct Registo {
+    std::mutex mtx;
+    Pontos pontos;
+    std::vector<Evento> eventos;
+    uint32_t tid = 0;
+
+    Registo() {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mtx);
+        tid = g.proximoTid++;
+        g.vivos.push_back(this);
+    }
+    ~Registo() {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mtx);
+        for (const auto& p : pontos) g.terminados[p.first].juntar(p.second);
+        g.eventosTerminados.insert(g.eventosTerminados.end(), eventos.begin(), eventos.end());
+        g.vivos.erase(std::remove(g.vivos.begin(), g.vivos.end(), this), g.vivos.end());
+    }
+};
+
+Registo& registo() {
+    thread_local Registo r;
+    return r;
+}
+
+int64_t agoraNs() {
+    static const auto origem = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origem).count();
+}
+
+int balde(uint64_t ns) {
+    int b = 0;
+    while (ns && b < kBaldes - 1) { ns >>= 1; ++b; }
+    return b;
+}
+
+// Percentil q estimado pelo ponto médio (geométrico) do balde onde cai.
+double percentilMs(const Acumulado& a, double q) {
+    uint64_t alvo = static_cast<uint64_t>(q * a.vezes + 0.5), visto = 0;
+    if (alvo == 0) alvo = 1;
+    for (int b = 0; b < kBaldes; ++b) {
+        visto += a.baldes[b];
+        if (visto >= alvo) {
+            double meio = b == 0 ? 0.0 : (b == 1 ? 1.0 : 1.4142135623730951 * static_cast<double>(1ull << (b - 1)));
+            return std::min(meio, static_cast<double>(a.maxNs)) / 1e6;
+        }
+    }
+    return a.maxNs / 1e6;
+}
+
+void escreverTexto(std::ostream& os, const char* s) {
+    os << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') os << '\\';
+        os << *s;
+    }
+    os << '"';
+}
+
+} // namespace
+
+void ligar(bool ativo) {
+    recolha.store(ativo, std::memory_order_relaxed);
+}
+
+bool contaAlocacoes() {
+#ifdef GESTOR_SEM_CONTAR_ALOCACOES
+    return false;
+#else
+    return true;
+#endif
+}
+
+void Medida::iniciar() {
+    nos0 = nosVisitados;
+    bytes0 = bytesAlocados;
+    alocacoes0 = alocacoes;
+    chamadas0 = chamadasSistema;
+    inicioNs = agoraNs();
+}
+
+void Medida::terminar() {
+    int64_t duracao = agoraNs() - inicioNs;
+    uint64_t ns = duracao > 0 ? static_cast<uint64_t>(duracao) : 0;
+    uint64_t dNos = nosVisitados - nos0, dBytes = bytesAlocados - bytes0;
+    uint64_t dAloc = alocacoes - alocacoes0, dChamadas = chamadasSistema - chamadas0;
+
+    Registo& r = registo();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    Acumulado& a = r.pontos[nome];
+    a.vezes++;
+    a.totalNs += ns;
+    a.maxNs = std::max(a.maxNs, ns);
+    a.nos += dNos;
+    a.bytes += dBytes;
+    a.alocacoes += dAloc;
+    a.chamadas += dChamadas;
+    a.baldes[balde(ns)]++;
+    if (traco.load(std::memory_order_relaxed) && r.eventos.size() < kMaxEventos)
+        r.eventos.push_back({nome, inicioNs, duracao, dNos, dBytes, r.tid});
+}
+
+std::vector<Linha> resumo() {
+    // Pontos com o mesmo texto (literais de unidades diferentes) juntam-se numa linha.
+    std::map<std::string, Acumulado> porNome;
+    {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mtx);
+        for (const auto& p : g.terminados) porNome[p.first].juntar(p.second);
+        for (Registo* r : g.vivos) {
+            std::lock_guard<std::mutex> lr(r->mtx);
+            for (const auto& p : r->pontos) porNome[p.first].juntar(p.second);
+        }
+    }
+    std::vector<Linha> linhas;
+    for (const auto& p : porNome) {
+        const Acumulado& a = p.second;
+        Linha l;
+        l.nome = p.first;
+        l.vezes = a.vezes;
+        l.totalMs = a.totalNs / 1e6;
+        l.mediaMs = a.vezes ? l.totalMs / a.vezes : 0.0;
+        l.p50Ms = percentilMs(a, 0.50);
+        l.p99Ms = percentilMs(a, 0.99);
+        l.maxMs = a.maxNs / 1e6;
+        l.nos = a.nos;
+        l.bytes = a.bytes;
+        l.alocacoes = a.alocacoes;
+        l.chamadasSistema = a.chamadas;
+        linhas.push_back(std::move(l));
+    }
+    std::sort(linhas.begin(), linhas.end(), [](const Linha& x, const Linha& y) { return x.totalMs > y.totalMs; });
+    return linhas;
+}
+
+void limpar() {
+    Global& g = global();
+    std::lock_guard<std::mutex> lock(g.mtx);
+    g.terminados.clear();
+    g.eventosTerminados.clear();
+    for (Registo* r : g.vivos) {
+        std::lock_guard<std::mutex> lr(r->mtx);
+        r->pontos.clear();
+        r->eventos.clear();
+    }
+}
+
+void iniciarTraco() {
+    traco.store(true, std::memory_order_relaxed);
+}
+
+bool tracoAtivo() {
+    return traco.load(std::memory_order_relaxed);
+}
+
+bool gravarTraco(const std::string& ficheiro, size_t* eventos) {
+    traco.store(false, std::memory_order_relaxed);
+    std::vector<Evento> todos;
+    {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mtx);
+        todos.swap(g.eventosTerminados);
+        for (Registo* r : g.vivos) {
+            std::lock_guard<std::mutex> lr(r->mtx);
+            todos.insert(todos.end(), r->eventos.begin(), r->eventos.end());
+            r->eventos.clear();
+        }
+    }
+    std::sort(todos.begin(), todos.end(), [](const Evento& a, const Evento& b) { return a.inicioNs < b.inicioNs; });
+    if (eventos) *eventos = todos.size();
+
+    // Formato "trace event" (eventos completos "X", tempos em microssegundos).
+    std::ofstream os(ficheiro);
+    if (!os.is_open()) return false;
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    char num[64];
+    for (size_t i = 0; i < todos.size(); ++i) {
+        const Evento& e = todos[i];
+        os << "{\"name\": ";
+        escreverTexto(os, e.nome);
+        std::snprintf(num, sizeof(num), "%.3f", e.inicioNs / 1e3);
+        os << ", \"cat\": \"gestor\", \"ph\": \"X\", \"ts\": " << num;
+        std::snprintf(num, sizeof(num), "%.3f", e.duracaoNs / 1e3);
+        os << ", \"dur\": " << num << ", \"pid\": 1, \"tid\": " << e.tid
+           << ", \"args\": {\"nos\": " << e.nos << ", \"bytes\": " << e.bytes << "}}"
+           << (i + 1 < todos.size() ? ",\n" : "\n");
+    }
+    os << "]}\n";
+    return static_cast<bool>(os);
+}
+
+} // namespace perfil
+
+// ----------------------------------------
+// Contagem de alocações: operator new global (malloc + dois incrementos na thread).
+#ifndef GESTOR_SEM_CONTAR_ALOCACOES
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t n) {
+    perfil::bytesAlocados += n;
+    ++perfil::alocacoes;
+    if (n == 0) n = 1;
+    for (;;) {
+        if (void* p = std::malloc(n)) return p;
+        std::new_handler h = std::get_new_handler();
+        if (!h) throw std::bad_alloc();
+        h();
+    }
+}
+
+void* operator new[](std::size_t n) {
+    return ::operator new(n);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    try { return ::operator new(n); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+    try { return ::operator new(n); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
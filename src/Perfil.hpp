@@ -0,0 +1,102 @@
+#ifndef PERFIL_HPP
+#define PERFIL_HPP
+
+/**
+ * @file Perfil.hpp
+ * @brief Declara a instrumentação de comandos e operações (tempo, nós, alocações, chamadas ao sistema).
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace perfil
+ * @brief Latência e custo de cada ponto medido (comando da shell ou método do SistemaFicheiros).
+ *
+ * Cada thread guarda os seus próprios acumulados e um histograma de tempos em
+ * baldes log2 de nanossegundos; resumo() junta-os. Com a recolha desligada,
+ * uma Medida custa uma leitura atómica e os contadores de nós e de alocações
+ * só um incremento numa variável da thread.
+ *
+ * Os valores são inclusivos: um comando conta também o que os métodos que
+ * chama gastaram. As alocações são contadas pelo operator new global definido
+ * em Perfil.cpp (compilar com -DGESTOR_SEM_CONTAR_ALOCACOES para o retirar).
+ */
+namespace perfil {
+
+// Contadores da thread atual (sempre ativos; as medidas usam as diferenças).
+inline thread_local uint64_t nosVisitados = 0;
+inline thread_local uint64_t bytesAlocados = 0;
+inline thread_local uint64_t alocacoes = 0;
+inline thread_local uint64_t chamadasSistema = 0;
+
+/** @brief Recolha ligada (ver ligar()). */
+inline std::atomic<bool> recolha{false};
+
+/** @brief Liga ou desliga a recolha (as medidas já iniciadas terminam normalmente). */
+void ligar(bool ativo);
+inline bool ligado() { return recolha.load(std::memory_order_relaxed); }
+/** @brief Indica se as alocações estão a ser contadas (operator new instrumentado). */
+bool contaAlocacoes();
+
+/** @brief Regista n nós (diretorias ou ficheiros) visitados pela thread atual. */
+inline void nos(uint64_t n = 1) { nosVisitados += n; }
+/** @brief Regista n chamadas ao sistema feitas pela thread atual. */
+inline void chamadas(uint64_t n = 1) { chamadasSistema += n; }
+
+/**
+ * @class Medida
+ * @brief Mede o bloco onde é criada (RAII) e acumula-o no ponto com esse nome.
+ * @details nome tem de ter duração estática (um literal): é usado como chave.
+ */
+class Medida {
+public:
+    explicit Medida(const char* nome) : nome(ligado() ? nome : nullptr) { if (this->nome) iniciar(); }
+    ~Medida() { if (nome) terminar(); }
+    Medida(const Medida&) = delete;
+    Medida& operator=(const Medida&) = delete;
+
+private:
+    void iniciar();
+    void terminar();
+
+    const char* nome;
+    int64_t inicioNs = 0;
+    uint64_t nos0 = 0, bytes0 = 0, alocacoes0 = 0, chamadas0 = 0;
+};
+
+/** @brief Acumulado de um ponto em todas as threads. */
+struct Linha {
+    std::string nome;
+    uint64_t vezes = 0;
+    double totalMs = 0, mediaMs = 0, p50Ms = 0, p99Ms = 0, maxMs = 0;
+    uint64_t nos = 0;
+    uint64_t bytes = 0;
+    uint64_t alocacoes = 0;
+    uint64_t chamadasSistema = 0;
+};
+
+/**
+ * @brief Junta os acumulados de todas as threads (incluindo as que já terminaram).
+ * @details Ordenado por tempo total, do maior para o menor. p50/p99 são estimados pelo histograma.
+ */
+std::vector<Linha> resumo();
+/** @brief Apaga os acumulados e os eventos do traço. */
+void limpar();
+
+/** @brief Começa a guardar um evento por medida (para o traço). */
+void iniciarTraco();
+/** @brief Indica se o traço está a ser gravado. */
+bool tracoAtivo();
+/**
+ * @brief Grava os eventos guardados em JSON (Chrome trace / Perfetto) e pára o traço.
+ * @param eventos Se indicado, recebe o número de eventos escritos.
+ * @return false se o ficheiro não pôde ser escrito.
+ */
+bool gravarTraco(const std::string& ficheiro, size_t* eventos = nullptr);
+
+} // namespace perfil
+
+#endif // PERFIL_HPP
@@ -0,0 +1,128 @@
+#include "Protocolo.hpp"
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace protocolo {
+
+static void escreverU32(std::string& buf, uint32_t v) {
+    char b[4] = { static_cast<char>(v & 0xff), static_cast<char>((v >> 8) & 0xff),
+                  static_cast<char>((v >> 16) & 0xff), static_cast<char>((v >> 24) & 0xff) };
+    buf.append(b, 4);
+}
+
+static uint32_t lerU32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(u[0]) | (static_cast<uint32_t>(u[1]) << 8) |
+           (static_cast<uint32_t>(u[2]) << 16) | (static_cast<uint32_t>(u[3]) << 24);
+}
+
+void escreverPedido(std::string& buf, std::string_view comando) {
+    escreverU32(buf, static_cast<uint32_t>(comando.size()));
+    buf.append(comando.data(), comando.size());
+}
+
+void escreverResposta(std::string& buf, Estado estado, std::string_view texto) {
+    escreverU32(buf, static_cast<uint32_t>(texto.size() + 1));
+    buf.push_back(static_cast<char>(estado));
+    buf.append(texto.data(), texto.size());
+}
+
+int lerFrame(const char* data, size_t n, std::string_view& payload, size_t& consumido) {
+    if (n < 4) return 0;
+    uint32_t len = lerU32(data);
+    if (len > kMaxFrame) return -1;
+    if (n - 4 < len) return 0;
+    payload = std::string_view(data + 4, len);
+    consumido = 4 + static_cast<size_t>(len);
+    return 1;
+}
+
+// ----------------------------------------
+// Cliente
+Cliente::~Cliente() {
+    fechar();
+}
+
+void Cliente::enfileirar(std::string_view comando) {
+    escreverPedido(envio, comando);
+}
+
+bool Cliente::pedir(std::string_view comando, Resposta& r) {
+    enfileirar(comando);
+    return enviarPendentes() && receber(r);
+}
+
+#ifdef __linux__
+bool Cliente::ligar(const std::string& caminho) {
+    fechar();
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (caminho.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, caminho.c_str(), caminho.size() + 1);
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        fechar();
+        return false;
+    }
+    return true;
+}
+
+bool Cliente::enviarPendentes() {
+    size_t enviado = 0;
+    while (enviado < envio.size()) {
+        ssize_t k = ::send(fd, envio.data() + enviado, envio.size() - enviado, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        enviado += static_cast<size_t>(k);
+    }
+    envio.clear();
+    return true;
+}
+
+bool Cliente::receber(Resposta& r) {
+    for (;;) {
+        std::string_view payload;
+        size_t consumido = 0;
+        int st = lerFrame(rececao.data() + inicio, rececao.size() - inicio, payload, consumido);
+        if (st < 0) return false;
+        if (st > 0 && !payload.empty()) {
+            r.estado = static_cast<Estado>(static_cast<uint8_t>(payload[0]));
+            r.texto.assign(payload.data() + 1, payload.size() - 1);
+            inicio += consumido;
+            // Compacta o buffer quando já não há nada por consumir (caso comum).
+            if (inicio == rececao.size()) { rececao.clear(); inicio = 0; }
+            return true;
+        }
+        if (st > 0) return false; // resposta sem byte de estado
+        char buf[64 * 1024];
+        ssize_t k = ::recv(fd, buf, sizeof(buf), 0);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        if (inicio > 0) { rececao.erase(0, inicio); inicio = 0; }
+        rececao.append(buf, static_cast<size_t>(k));
+    }
+}
+
+void Cliente::fechar() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    envio.clear();
+    rececao.clear();
+    inicio = 0;
+}
+#else
+// Sockets Unix só estão disponíveis (e testados) em Linux.
+bool Cliente::ligar(const std::string&) { return false; }
+bool Cliente::enviarPendentes() { return false; }
+bool Cliente::receber(Resposta&) { return false; }
+void Cliente::fechar() {}
+#endif
+
+} // namespace protocolo
@@ -0,0 +1,83 @@
+#ifndef PROTOCOLO_HPP
+#define PROTOCOLO_HPP
+
+/**
+ * @file Protocolo.hpp
+ * @brief Protocolo binário do daemon (frames com prefixo de comprimento) e cliente bloqueante.
+ *
+ * Pedido:   [u32 comprimento][linha de comando]
+ * Resposta: [u32 comprimento][u8 estado][texto produzido pelo comando]
+ *
+ * O comprimento é little-endian e conta só os bytes que vêm a seguir. Um
+ * cliente pode enviar vários pedidos seguidos sem esperar (pipelining); as
+ * respostas chegam pela mesma ordem.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace protocolo {
+
+/** @brief Estado devolvido em cada resposta. */
+enum Estado : uint8_t {
+    Ok = 0,       ///< Comando executado.
+    Invalido = 1, ///< Comando desconhecido.
+    Fim = 2       ///< Sessão terminada (exit ou shutdown); o servidor fecha a ligação.
+};
+
+/** @brief Maior frame aceite; acima disto a ligação é considerada corrompida. */
+constexpr uint32_t kMaxFrame = 64u * 1024 * 1024;
+
+/** @brief Acrescenta a buf um frame de pedido. */
+void escreverPedido(std::string& buf, std::string_view comando);
+/** @brief Acrescenta a buf um frame de resposta. */
+void escreverResposta(std::string& buf, Estado estado, std::string_view texto);
+/**
+ * @brief Extrai um frame completo do início de [data, data + n).
+ * @param consumido Bytes ocupados pelo frame (cabeçalho incluído).
+ * @return 1 se extraiu um frame, 0 se ainda faltam bytes, -1 se o comprimento é inválido.
+ */
+int lerFrame(const char* data, size_t n, std::string_view& payload, size_t& consumido);
+
+/**
+ * @class Cliente
+ * @brief Ligação bloqueante a um daemon (usada pelo cliente da linha de comandos e pelo gerador de carga).
+ */
+class Cliente {
+public:
+    /** @brief Resposta a um pedido. */
+    struct Resposta {
+        Estado estado = Ok;
+        std::string texto;
+    };
+
+    Cliente() = default;
+    ~Cliente();
+    Cliente(const Cliente&) = delete;
+    Cliente& operator=(const Cliente&) = delete;
+
+    /** @brief Liga ao socket Unix indicado. */
+    bool ligar(const std::string& caminho);
+    /** @brief Junta um pedido ao buffer de envio (só é enviado em enviarPendentes). */
+    void enfileirar(std::string_view comando);
+    /** @brief Envia todos os pedidos enfileirados. */
+    bool enviarPendentes();
+    /** @brief Espera pela próxima resposta. */
+    bool receber(Resposta& r);
+    /** @brief Envia um pedido e espera pela resposta. */
+    bool pedir(std::string_view comando, Resposta& r);
+    /** @brief Fecha a ligação. */
+    void fechar();
+
+private:
+    int fd = -1;
+    std::string envio;
+    std::string rececao;
+    size_t inicio = 0; // primeiro byte ainda não consumido em rececao
+};
+
+} // namespace protocolo
+
+#endif // PROTOCOLO_HPP
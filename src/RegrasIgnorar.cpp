@@ -0,0 +1,206 @@
+#include "RegrasIgnorar.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+bool temCuringas(std::string_view p) {
+    return p.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+// [abc], [a-z], [!a] ou [^a] em p[i] (p[i] == '['). Devolve a posição a seguir
+// ao ']' e em casou se c pertence à classe; npos se a classe não fecha.
+size_t classe(std::string_view p, size_t i, char c, bool& casou) {
+    size_t k = i + 1;
+    bool negada = k < p.size() && (p[k] == '!' || p[k] == '^');
+    if (negada) ++k;
+    bool dentro = false;
+    for (bool primeiro = true; k < p.size() && (primeiro || p[k] != ']'); primeiro = false) {
+        char a = p[k];
+        if (a == '\\' && k + 1 < p.size()) a = p[++k];
+        if (k + 2 < p.size() && p[k + 1] == '-' && p[k + 2] != ']') {
+            char b = p[k + 2];
+            if (b == '\\' && k + 3 < p.size()) b = p[++k + 2];
+            dentro = dentro || (c >= a && c <= b);
+            k += 3;
+        } else {
+            dentro = dentro || c == a;
+            ++k;
+        }
+    }
+    if (k >= p.size()) return std::string_view::npos;
+    casou = c != '/' && dentro != negada;
+    return k + 1;
+}
+
+// Casamento de um padrão .gitignore: * e ? não passam por '/', ** passa.
+bool casar(std::string_view p, std::string_view t) {
+    size_t i = 0, j = 0;
+    while (i < p.size()) {
+        char c = p[i];
+        if (c == '*') {
+            if (i + 1 < p.size() && p[i + 1] == '*') {
+                size_t k = i + 2;
+                if (k < p.size() && p[k] == '/') {
+                    // "**/": zero ou mais diretorias inteiras.
+                    std::string_view resto = p.substr(k + 1);
+                    if (casar(resto, t.substr(j))) return true;
+                    for (size_t m = j; m < t.size(); ++m)
+                        if (t[m] == '/' && casar(resto, t.substr(m + 1))) return true;
+                    return false;
+                }
+                for (size_t m = t.size() + 1; m-- > j;)
+                    if (casar(p.substr(k), t.substr(m))) return true;
+                return false;
+            }
+            for (size_t m = j;; ++m) {
+                if (casar(p.substr(i + 1), t.substr(m))) return true;
+                if (m >= t.size() || t[m] == '/') return false;
+            }
+        }
+        if (j >= t.size()) return false;
+        if (c == '?') {
+            if (t[j] == '/') return false;
+        } else if (c == '[') {
+            bool casou = false;
+            size_t fim = classe(p, i, t[j], casou);
+            if (fim != std::string_view::npos) {
+                if (!casou) return false;
+                i = fim;
+                ++j;
+                continue;
+            }
+            if (t[j] != '[') return false; // '[' sem ']' é literal
+        } else {
+            if (c == '\\' && i + 1 < p.size()) c = p[++i];
+            if (c != t[j]) return false;
+        }
+        ++i;
+        ++j;
+    }
+    return j == t.size();
+}
+
+} // namespace
+
+bool RegrasIgnorar::casa(std::string_view padrao, std::string_view texto) {
+    return casar(padrao, texto);
+}
+
+bool RegrasIgnorar::temCuringas(std::string_view padrao) {
+    return ::temCuringas(padrao);
+}
+
+RegrasIgnorar::RegrasIgnorar(const RegrasIgnorar& outra) : ficheiros(outra.ficheiros) {
+    for (const auto& l : outra.linhas) acrescentarLinha(l);
+}
+
+RegrasIgnorar& RegrasIgnorar::operator=(const RegrasIgnorar& outra) {
+    if (this != &outra) *this = RegrasIgnorar(outra);
+    return *this;
+}
+
+const RegrasIgnorar& RegrasIgnorar::predefinidas() {
+    static const RegrasIgnorar regras = [] {
+        RegrasIgnorar r;
+        r.acrescentar(".git/\n.vscode/\nbin/\nobj/\nbuild/\n*.exe\n.gitignore\n.DS_Store\n");
+        return r;
+    }();
+    return regras;
+}
+
+void RegrasIgnorar::acrescentar(std::string_view texto) {
+    size_t a = 0;
+    while (a < texto.size()) {
+        size_t b = texto.find('\n', a);
+        if (b == std::string_view::npos) b = texto.size();
+        acrescentarLinha(texto.substr(a, b - a));
+        a = b + 1;
+    }
+}
+
+bool RegrasIgnorar::acrescentarFicheiro(const std::string& ficheiro) {
+    std::ifstream ifs(ficheiro);
+    if (!ifs.is_open()) return false;
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    acrescentar(ss.str());
+    ficheiros.push_back(ficheiro);
+    return true;
+}
+
+void RegrasIgnorar::inserir(Tabela& tabela, std::string_view chave, Regra r) {
+    auto it = tabela.find(chave);
+    if (it == tabela.end()) {
+        chaves.emplace_back(chave);
+        it = tabela.emplace(chaves.back(), std::vector<Regra>()).first;
+    }
+    it->second.push_back(r);
+}
+
+void RegrasIgnorar::acrescentarLinha(std::string_view linha) {
+    std::string_view original = linha;
+    if (!linha.empty() && linha.back() == '\r') linha.remove_suffix(1);
+    if (linha.empty() || linha[0] == '#') return;
+    // Espaços no fim só contam se escapados.
+    while (!linha.empty() && linha.back() == ' ' && !(linha.size() >= 2 && linha[linha.size() - 2] == '\\'))
+        linha.remove_suffix(1);
+    if (linha.empty()) return;
+
+    Regra r{ total, false, false };
+    if (linha[0] == '!') { r.negada = true; linha.remove_prefix(1); }
+    else if (linha.size() >= 2 && linha[0] == '\\' && (linha[1] == '!' || linha[1] == '#')) linha.remove_prefix(1);
+    if (!linha.empty() && linha.back() == '/') { r.soDiretorias = true; linha.remove_suffix(1); }
+    // Uma barra no início ou no meio ancora a regra à pasta do Load.
+    bool ancorada = linha.find('/') != std::string_view::npos;
+    if (!linha.empty() && linha[0] == '/') linha.remove_prefix(1);
+    // "**/nome" é o mesmo que "nome" sem âncora.
+    if (linha.size() > 3 && linha.substr(0, 3) == "**/" && linha.find('/', 3) == std::string_view::npos) {
+        linha.remove_prefix(3);
+        ancorada = false;
+    }
+    if (linha.empty()) return;
+
+    if (!temCuringas(linha)) {
+        inserir(ancorada ? caminhos : nomes, linha, r);
+    } else if (!ancorada && linha.size() > 2 && linha.substr(0, 2) == "*." &&
+               !temCuringas(linha.substr(2)) && linha.find('.', 2) == std::string_view::npos) {
+        inserir(extensoes, linha.substr(2), r);
+    } else {
+        char inicio = temCuringas(linha.substr(0, 1)) ? '\0' : linha[0];
+        padroes.push_back({ r, ancorada, inicio, std::string(linha) });
+    }
+    linhas.emplace_back(original);
+    ++total;
+}
+
+bool RegrasIgnorar::ignorar(std::string_view caminho, bool diretoria) const {
+    size_t barra = caminho.rfind('/');
+    std::string_view nome = barra == std::string_view::npos ? caminho : caminho.substr(barra + 1);
+
+    // Última regra (maior índice) que casa; as listas estão por ordem crescente.
+    const Regra* melhor = nullptr;
+    auto considerar = [&](const Tabela& tabela, std::string_view chave) {
+        auto it = tabela.find(chave);
+        if (it == tabela.end()) return;
+        for (auto r = it->second.rbegin(); r != it->second.rend(); ++r) {
+            if (r->soDiretorias && !diretoria) continue;
+            if (!melhor || r->indice > melhor->indice) melhor = &*r;
+            break;
+        }
+    };
+    if (!nomes.empty()) considerar(nomes, nome);
+    if (!caminhos.empty()) considerar(caminhos, caminho);
+    if (!extensoes.empty()) {
+        size_t ponto = nome.rfind('.');
+        if (ponto != std::string_view::npos) considerar(extensoes, nome.substr(ponto + 1));
+    }
+    for (auto g = padroes.rbegin(); g != padroes.rend(); ++g) {
+        if (melhor && g->regra.indice < melhor->indice) break;
+        if (g->regra.soDiretorias && !diretoria) continue;
+        std::string_view alvo = g->ancorada ? caminho : nome;
+        if (g->inicio && (alvo.empty() || alvo[0] != g->inicio)) continue;
+        if (casar(g->padrao, alvo)) { melhor = &g->regra; break; }
+    }
+    return melhor && !melhor->negada;
+}
@@ -0,0 +1,94 @@
+#ifndef REGRASIGNORAR_HPP
+#define REGRASIGNORAR_HPP
+
+/**
+ * @file RegrasIgnorar.hpp
+ * @brief Declara a classe RegrasIgnorar (regras no formato .gitignore, compiladas para o Load).
+ */
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class RegrasIgnorar
+ * @brief Conjunto de regras no formato .gitignore, compilado quando as regras são acrescentadas.
+ *
+ * Suporta comentários, negações (!), regras só para diretorias (barra final),
+ * regras ancoradas (com barra no início ou no meio, relativas à pasta do Load)
+ * e os padrões *, ?, [...] e **. Como no git, ganha a última regra que casa.
+ *
+ * Cada regra vai para a estrutura mais barata que a resolve: nomes literais,
+ * extensões ("*.ext") e caminhos ancorados literais ficam em tabelas de
+ * dispersão; só os restantes padrões são casados um a um, da última regra para
+ * a primeira, parando assim que a regra seguinte já não pode ganhar. Uma
+ * entrada custa por isso três procuras e, no máximo, os globs posteriores à
+ * melhor regra literal, seja qual for o número de regras literais.
+ */
+class RegrasIgnorar {
+public:
+    RegrasIgnorar() = default;
+    /** @brief A cópia volta a compilar as regras (as tabelas apontam para chaves do original). */
+    RegrasIgnorar(const RegrasIgnorar& outra);
+    RegrasIgnorar& operator=(const RegrasIgnorar& outra);
+    RegrasIgnorar(RegrasIgnorar&&) = default;
+    RegrasIgnorar& operator=(RegrasIgnorar&&) = default;
+
+    /** @brief Regras usadas quando nada é configurado (as pastas e ficheiros que o Load sempre ignorou). */
+    static const RegrasIgnorar& predefinidas();
+
+    /** @brief Acrescenta as regras de um texto, uma por linha. */
+    void acrescentar(std::string_view texto);
+    /** @brief Acrescenta as regras de um ficheiro. @return false se não pôde ser lido. */
+    bool acrescentarFicheiro(const std::string& ficheiro);
+
+    /**
+     * @brief Indica se uma entrada deve ser ignorada.
+     * @param caminho Caminho relativo à pasta do Load, com '/' como separador.
+     * @param diretoria true se a entrada é uma diretoria.
+     */
+    bool ignorar(std::string_view caminho, bool diretoria) const;
+
+    /** @brief Número de regras (sem linhas vazias nem comentários). */
+    size_t tamanho() const { return total; }
+    /** @brief Regras casadas uma a uma (as que não ficaram em tabelas). */
+    size_t globs() const { return padroes.size(); }
+    /** @brief Ficheiros de onde vieram regras, pela ordem. */
+    const std::vector<std::string>& origens() const { return ficheiros; }
+
+    /** @brief Casa um padrão com *, ?, [...] e ** (as mesmas regras das linhas do .gitignore). */
+    static bool casa(std::string_view padrao, std::string_view texto);
+    /** @brief Indica se o padrão tem curingas (senão só casa com o próprio texto). */
+    static bool temCuringas(std::string_view padrao);
+
+private:
+    struct Regra {
+        uint32_t indice;
+        bool negada;
+        bool soDiretorias;
+    };
+    struct Glob {
+        Regra regra;
+        bool ancorada; // casa com o caminho; senão só com o nome
+        char inicio;   // primeiro carácter, se não for curinga (filtro antes de casar)
+        std::string padrao;
+    };
+    using Tabela = std::unordered_map<std::string_view, std::vector<Regra>>;
+
+    void acrescentarLinha(std::string_view linha);
+    void inserir(Tabela& tabela, std::string_view chave, Regra r);
+
+    Tabela nomes;      // nome literal, a qualquer profundidade
+    Tabela extensoes;  // "*.ext": a extensão
+    Tabela caminhos;   // caminho literal ancorado
+    std::deque<std::string> chaves; // dono das chaves das tabelas (referências estáveis)
+    std::vector<Glob> padroes;
+    std::vector<std::string> ficheiros;
+    std::vector<std::string> linhas; // regras pela ordem, para as cópias
+    uint32_t total = 0;
+};
+
+#endif // REGRASIGNORAR_HPP
@@ -0,0 +1,1284 @@
+#include "Shell.hpp"
+#include <iostream>
+#include <queue>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+#include "Consulta.hpp"
+#include "Exportador.hpp"
+#include "Kernels.hpp"
+#include "Perfil.hpp"
+
+static std::string convertAsctimeToYMD(const std::string& asctimeStr) {
+    // Formato típico: "Wed Jun 30 21:49:08 1993"
+    std::istringstream iss(asctimeStr);
+    std::tm tm = {};
+    iss.str(asctimeStr);
+    iss.clear();
+    iss >> std::get_time(&tm, "%a %b %d %H:%M:%S %Y");
+    if (iss.fail()) {
+        return asctimeStr;
+    }
+    int year = tm.tm_year + 1900;
+    int mon = tm.tm_mon + 1;
+    int day = tm.tm_mday;
+    return std::to_string(year) + "|" + std::to_string(mon) + "|" + std::to_string(day);
+}
+
+// Linha do relatório do load com o que as regras deixaram de fora (vazia se nada).
+static std::string resumoIgnorados(const SistemaFicheiros::Varrimento& c) {
+    if (c.diretoriasIgnoradas == 0 && c.ficheirosIgnorados == 0) return std::string();
+    return "Ignorados (" + std::to_string(c.regras) + " regras): " + std::to_string(c.diretoriasIgnoradas) +
+           " diretorias (nao percorridas), " + std::to_string(c.ficheirosIgnorados) + " ficheiros (" +
+           std::to_string(c.bytesIgnorados) + " bytes)\n";
+}
+
+static std::string resumoLigacoes(const SistemaFicheiros::Varrimento& c) {
+    if (c.ligacoesRepetidas == 0) return std::string();
+    return "Ligacoes fisicas: " + std::to_string(c.ligacoesRepetidas) + " ficheiros partilham o inode de outro (" +
+           std::to_string(c.bytesRepetidos) + " bytes contados uma so vez nos bytes unicos)\n";
+}
+
+static std::string resumoCache(const SistemaFicheiros::Varrimento& c) {
+    if (c.diretoriasReutilizadas == 0) return std::string();
+    return "Cache: " + std::to_string(c.diretoriasReutilizadas) + " de " + std::to_string(c.listagens) +
+           " diretorias sem alteracoes (nao foram relidas)\n";
+}
+
+Shell::Shell(std::istream& in, std::ostream& out, Opcoes opcoes)
+    : in(in), out(out), opcoes(opcoes),
+      proprio(std::make_unique<SistemaFicheiros>()), sf(*proprio), partilhado(false),
+      root(std::make_shared<Directory>("/")), currentDir(root.get()) {
+    // Arranque: árvore vazia com raiz "/", ou o estado anterior se existir.
+    sf.SetRoot(root);
+    if (opcoes.autoLoad && opcoes.interativo) {
+        // O prompt aparece assim que a raiz é lida; o resto chega em segundo plano.
+        carregamento = std::make_unique<CarregamentoXml>(kFicheiroEstado);
+        if (auto lida = carregamento->esperarRaiz()) {
+            root = lida;
+            currentDir = root.get();
+            if (carregamento->terminado()) concluirCarregamento();
+            else out << "A carregar " << kFicheiroEstado << " em segundo plano..." << std::endl;
+        } else {
+            carregamento.reset();
+        }
+    } else if (opcoes.autoLoad && sf.Ler_XML(kFicheiroEstado)) {
+        root = sf.GetRoot();
+        currentDir = root.get();
+    }
+}
+
+Shell::Shell(SistemaFicheiros& comum, std::istream& in, std::ostream& out, Opcoes opcoes)
+    : in(in), out(out), opcoes(opcoes),
+      sf(comum), partilhado(true),
+      root(comum.GetRoot()), currentDir(root ? root.get() : nullptr) {
+    if (!root) {
+        root = std::make_shared<Directory>("/");
+        currentDir = root.get();
+        sf.SetRoot(root);
+    }
+    lembrarPosicao();
+}
+
+Shell::~Shell() {
+    // O destrutor do executor cancela o que falta e espera pelas threads.
+    tarefas.reset();
+}
+
+// Construída uma única vez; o ciclo de comandos só faz uma procura por linha.
+const std::unordered_map<std::string_view, Shell::Handler>& Shell::comandos() {
+    static const std::unordered_map<std::string_view, Handler> tabela = {
+        { "help", &Shell::cmdHelp },
+        { "mkdir", &Shell::cmdMkdir },
+        { "load", &Shell::cmdLoad },
+        { "touch", &Shell::cmdTouch },
+        { "cd", &Shell::cmdCd },
+        { "ls", &Shell::cmdLs },
+        { "rm", &Shell::cmdRm },
+        { "rmdir", &Shell::cmdRmdir },
+        { "size", &Shell::cmdSize },
+        { "maior", &Shell::cmdMaior },
+        { "directoriamaiselementos", &Shell::cmdDirectoriaMaisElementos },
+        { "directoriamenoselementos", &Shell::cmdDirectoriaMenosElementos },
+        { "ficheiromaior", &Shell::cmdFicheiroMaior },
+        { "directoriamaiespaco", &Shell::cmdDirectoriaMaisEspaco },
+        { "contarficheiros", &Shell::cmdContarFicheiros },
+        { "contardirectorios", &Shell::cmdContarDirectorios },
+        { "memoria", &Shell::cmdMemoria },
+        { "meminfo", &Shell::cmdMemInfo },
+        { "shrink", &Shell::cmdShrink },
+        { "diff", &Shell::cmdDiff },
+        { "ignore", &Shell::cmdIgnore },
+        { "estimate", &Shell::cmdEstimate },
+        { "dirmais", &Shell::cmdDirMais },
+        { "dirmenos", &Shell::cmdDirMenos },
+        { "maisespaco", &Shell::cmdMaisEspaco },
+        { "removerall", &Shell::cmdRemoverAll },
+        { "exportarxml", &Shell::cmdExportarXml },
+        { "lerxml", &Shell::cmdLerXml },
+        { "tree", &Shell::cmdTree },
+        { "finddirs", &Shell::cmdFindDirs },
+        { "copybatch", &Shell::cmdCopyBatch },
+        { "findfiles", &Shell::cmdFindFiles },
+        { "renamefiles", &Shell::cmdRenameFiles },
+        { "dupfiles", &Shell::cmdDupFiles },
+        { "search", &Shell::cmdSearch },
+        { "movefile", &Shell::cmdMoveFile },
+        { "movedir", &Shell::cmdMoveDir },
+        { "cpdir", &Shell::cmdCpDir },
+        { "espelho", &Shell::cmdEspelho },
+        { "profile", &Shell::cmdProfile },
+        { "sep", &Shell::cmdSep },
+        { "freeze", &Shell::cmdFreeze },
+        { "unfreeze", &Shell::cmdUnfreeze },
+        { "stats", &Shell::cmdStats },
+        { "datecount", &Shell::cmdDateCount },
+        { "snapexport", &Shell::cmdSnapExport },
+        { "export", &Shell::cmdExport },
+        { "query", &Shell::cmdQuery },
+        { "snapinfo", &Shell::cmdSnapInfo },
+        { "bg", &Shell::cmdBg },
+        { "jobs", &Shell::cmdJobs },
+        { "cancel", &Shell::cmdCancel },
+        { "wait", &Shell::cmdWait },
+        { "getdate", &Shell::cmdGetDate },
+    };
+    return tabela;
+}
+
+size_t Shell::run() {
+    if (opcoes.interativo) {
+        out << "Bem-vindo ao Gestor de Diretorias!" << std::endl;
+        printCommands();
+    }
+
+    std::string cmd;
+    while (true) {
+        // O prompt só faz sentido (e só é despejado) em modo interativo.
+        if (opcoes.interativo) {
+            if (carregamento && carregamento->terminado()) concluirCarregamento();
+            out << "\n";
+            if (carregamento) out << "[" << carregamento->percentagem() << "%] ";
+            out << currentDir->getName() << "> " << std::flush;
+        }
+        if (!(in >> cmd)) break;
+        // Comentários em scripts: ignora o resto da linha.
+        if (cmd[0] == '#') { std::getline(in, cmd); continue; }
+        if (!executar(cmd)) break;
+    }
+    out.flush();
+    return invalidos;
+}
+
+// Comandos que correm sobre a parte da árvore já carregada; os handlers
+// esperam pela subárvore de que precisam (esperarSubarvore, esperarCarregamento).
+static bool usaArvoreParcial(std::string_view cmd) {
+    static const std::unordered_set<std::string_view> parciais = {
+        "help", "cd", "ls", "size", "mkdir", "touch", "rm", "rmdir", "jobs",
+    };
+    return parciais.count(cmd) > 0;
+}
+
+bool Shell::executar(std::string_view cmd) {
+    if (partilhado) sincronizar();
+    if (tarefas) recolherTarefas();
+    if (cmd == "exit") {
+        if (carregamento) concluirCarregamento();
+        if (tarefas && tarefas->ativas() > 0) {
+            out << "A cancelar " << tarefas->ativas() << " tarefa(s) em segundo plano.\n";
+            tarefas->cancelarTodas();
+        }
+        // Antes de sair, guardamos o estado para poder retomar depois.
+        if (opcoes.autoSave) {
+            sf.SetRoot(root);
+            sf.Escrever_XML(kFicheiroEstado);
+            out << "Sistema guardado em " << kFicheiroEstado << ". A sair...\n";
+        } else {
+            out << "A sair (sem guardar)...\n";
+        }
+        return false;
+    }
+    auto it = comandos().find(cmd);
+    if (it == comandos().end()) {
+        ++invalidos;
+        out << "Comando invalido. Digite 'help' para ver os comandos disponíveis.\n";
+        return true;
+    }
+    if (carregamento) {
+        if (!carregamento->terminado() && usaArvoreParcial(cmd)) pausa = carregamento->bloquear();
+        else concluirCarregamento();
+    }
+    {
+        // Com o perfil ligado, cada comando é um ponto medido (os nomes da tabela são literais).
+        perfil::Medida medida(it->first.data());
+        (this->*(it->second))();
+    }
+    if (pausa.owns_lock()) pausa.unlock();
+    // Com o espelho ligado, as cópias e movimentos deixam um relatório do que (não) foi feito no disco.
+    std::string disco = sf.GetEspelho().retirarRelatorio();
+    if (!disco.empty()) out << disco;
+    if (partilhado) lembrarPosicao();
+    return true;
+}
+
+void Shell::sincronizar() {
+    std::shared_ptr<Directory> atual = sf.GetRoot();
+    if (atual && atual != root) {
+        // Outra sessão carregou uma árvore nova: recomeça na raiz.
+        root = atual;
+        currentDir = root.get();
+        caminho.clear();
+    } else if (Directory::structureVersion() != versaoVista) {
+        // A estrutura mudou: desce pelos nomes e fica no antepassado mais fundo que ainda existe.
+        Directory* d = root.get();
+        for (const auto& nome : caminho) {
+            auto sub = d->findSubdirectory(nome);
+            if (!sub) break;
+            d = sub.get();
+        }
+        currentDir = d;
+    }
+}
+
+Executor& Shell::executor() {
+    if (!tarefas) tarefas = std::make_unique<Executor>(2);
+    return *tarefas;
+}
+
+std::shared_ptr<SnapshotStore::Pin> Shell::fixarVersao() {
+    sf.SetRoot(root);
+    // Só volta a congelar se a versão publicada já não corresponder à árvore.
+    if (!sf.frozenView()) sf.Congelar();
+    return std::make_shared<SnapshotStore::Pin>(sf.Snapshot());
+}
+
+void Shell::concluirCarregamento() {
+    if (!carregamento->terminado()) {
+        out << "A aguardar o fim do carregamento de " << kFicheiroEstado
+            << " (" << carregamento->percentagem() << "%)..." << std::endl;
+    }
+    std::shared_ptr<Directory> lida = carregamento->concluir();
+    carregamento.reset();
+    if (lida) {
+        // A diretoria atual já pertence a esta árvore.
+        root = lida;
+        sf.clearSystem();
+        sf.SetRoot(root);
+        out << "Sistema carregado de " << kFicheiroEstado << std::endl;
+    } else {
+        // Ficheiro truncado ou inválido: recomeça como sem estado anterior.
+        root = std::make_shared<Directory>("/");
+        currentDir = root.get();
+        sf.clearSystem();
+        sf.SetRoot(root);
+        out << "Nao foi possivel carregar " << kFicheiroEstado << "; a comecar com a arvore vazia." << std::endl;
+    }
+}
+
+void Shell::esperarCarregamento(const std::function<bool()>& pronto) {
+    if (!pausa.owns_lock() || pronto()) return;
+    out << "A aguardar o carregamento (" << carregamento->percentagem() << "%)..." << std::endl;
+    carregamento->esperar(pausa, pronto);
+}
+
+void Shell::esperarSubarvore(const Directory* d) {
+    if (pausa.owns_lock()) esperarCarregamento([this, d] { return carregamento->completa(d); });
+}
+
+void Shell::recolherTarefas() {
+    for (const auto& t : tarefas->recolher()) {
+        out << "[" << t->id << "] " << Tarefa::nomeEstado(t->estado()) << ": " << t->descricao
+            << " (" << std::fixed << std::setprecision(2) << t->segundos() << " s)\n";
+        out.unsetf(std::ios::floatfield);
+        if (!t->mensagem.empty()) {
+            out << t->mensagem;
+            if (t->mensagem.back() != '\n') out << "\n";
+        }
+    }
+}
+
+std::string Shell::restoDaLinha() {
+    std::string arg;
+    std::getline(in, arg);
+    size_t a = arg.find_first_not_of(" \t\r");
+    if (a == std::string::npos) return std::string();
+    size_t b = arg.find_last_not_of(" \t\r");
+    return arg.substr(a, b - a + 1);
+}
+
+void Shell::lembrarPosicao() {
+    versaoVista = Directory::structureVersion();
+    caminho.clear();
+    for (Directory* d = currentDir; d && d->getParent(); d = d->getParent()) caminho.push_back(d->getName());
+    std::reverse(caminho.begin(), caminho.end());
+}
+
+void Shell::printCommands() const {
+    out << "\nComandos disponíveis:\n";
+    out << "1. mkdir <nome> - Criar diretoria\n";
+    out << "2. touch <nome> <tamanho> - Criar ficheiro\n";
+    out << "3. cd <nome> - Mudar para diretoria\n";
+    out << "4. cd .. - Voltar à diretoria pai\n";
+    out << "5. ls - Listar conteúdo da diretoria atual\n";
+    out << "6. rm <nome> - Remover ficheiro\n";
+    out << "7. rmdir <nome> - Remover diretoria\n";
+    out << "8. size - Mostrar tamanho total da diretoria atual\n";
+    out << "9. maior - Mostrar o ficheiro que ocupa mais espaço (caminho)\n";
+    out << "10. dirmais - Mostrar diretoria com mais elementos (a partir da diretoria atual)\n";    
+    out << "11. dirmenos - Mostrar diretoria com menos elementos (a partir da diretoria atual)\n";  
+    out << "12. maisespaco - Mostrar diretoria que ocupa mais espaço (a partir da raiz do sistema)\n";
+    out << "13. search <nome> <0|1> - Procurar ficheiro (0) ou directoria (1) e devolver caminho completo\n";
+    out << "14. removerall <DIR|FILE> - Remover todas as diretorias ou todos os ficheiros\n";       
+    out << "15. exportarxml <ficheiro> - Exportar o sistema em memoria para XML (default: sistema.xml)\n";
+    out << "16. tree [<ficheiro>] - Listar arvore (ou gravar em ficheiro)\n";
+    out << "17. finddirs <nome> - Encontrar todas as diretorias com esse nome\n";
+    out << "18. findfiles <nome> - Encontrar todos os ficheiros com esse nome\n";
+    out << "19. renamefiles <old> <new> - Renomear ficheiros com nome <old> para <new>\n";
+    out << "20. dupfiles - Listar ficheiros duplicados (mesmo nome)\n";
+    out << "21. copybatch <padrao> <DirOrigem> <DirDestino> - Copiar ficheiros cujo nome contenha <padrao> da arvore de origem para a raiz do destino\n";
+    out << "22. sep <caractere> - Definir o separador usado nos caminhos mostrados\n";
+    out << "23. freeze - Congelar a arvore (consultas so de leitura sobre arrays contiguos)\n";
+    out << "24. unfreeze - Descartar a copia congelada\n";
+    out << "25. stats - Estatisticas (total, maior, histograma de tamanhos)\n";
+    out << "26. datecount <de> <ate> - Contar ficheiros com data no intervalo (AAAAMMDD ou AAAA|MM|DD)\n";
+    out << "27. snapexport <ficheiro> - Exportar XML em segundo plano a partir de uma versao fixada da arvore\n";
+    out << "28. snapinfo - Mostrar a versao publicada e as versoes ainda retidas por leitores\n";
+    out << "29. bg <load|exportarxml|dupfiles|copybatch> <argumentos> - Executar em segundo plano\n";
+    out << "30. jobs - Listar tarefas em segundo plano e o seu progresso\n";
+    out << "31. cancel <id> - Cancelar uma tarefa em segundo plano\n";
+    out << "32. wait - Esperar que todas as tarefas em segundo plano terminem\n";
+    out << "33. cpdir <DirOrigem> <DirDestino> - Copiar uma diretoria (ficheiros partilhados ate serem alterados)\n";
+    out << "34. espelho [desligado|simular|aplicar] - Repetir no disco copybatch, cpdir, movefile e movedir\n";
+    out << "35. profile [on|off|reset|trace <on|ficheiro.json>] - Tempo, nos visitados, alocacoes e chamadas ao sistema por comando\n";
+    out << "36. meminfo - Memoria ocupada pela arvore (nos, nomes, vetores, shared_ptr, indices) e bytes por ficheiro\n";
+    out << "37. shrink - Compactar vetores e nomes (por exemplo depois de removerall) e libertar caches\n";
+    out << "38. diff <A.xml|.> <B.xml|.> - Diferencas entre duas versoes gravadas (. = arvore atual)\n";
+    out << "39. ignore [<ficheiro>|reset] - Regras .gitignore usadas pelo load (mostrar, acrescentar de um ficheiro, repor)\n";
+    out << "40. estimate <pasta> [segundos] - Estimar ficheiros, bytes e maiores diretorias de uma pasta por amostragem, sem load (repetir estreita os intervalos)\n";
+    out << "41. export <csv|jsonl|col> <ficheiro> - Exportar uma linha por no (caminho, pai, nome, extensao, tamanho, mtime) em segundo plano\n";
+    out << "42. query <condicoes> [| count|sum|top N] - Procurar ficheiros por name, ext, size, date, age, depth e under (ex.: query ext = log and size > 10M | top 5)\n";
+    out << "help - Mostrar comandos\n";
+    out << "exit - Sair (guarda automaticamente em sistema_saved.xml)\n";
+}
+
+// ----------------------------------------
+// Handlers
+void Shell::cmdHelp() {
+    printCommands();
+}
+
+void Shell::cmdMkdir() {
+    // Cria uma subdiretoria diretamente na diretoria atual.
+    std::string name;
+    in >> name;
+    esperarSubarvore(currentDir);
+    sf.CriarDirectoria(*currentDir, name);
+    out << "Diretoria criada: " << name << "\n";
+}
+
+void Shell::cmdLoad() {
+    // Varre uma pasta real do disco e constrói a árvore em memória.
+    std::string path;
+    if (!(in >> path)) { out << "Uso: load <path>\n"; return; }
+    SistemaFicheiros::Varrimento contas;
+    CacheVarrimento cache;
+    if (opcoes.autoLoad) cache.ler(kFicheiroCache);
+    bool ok = sf.Load(path, &contas, &cache);
+    if (ok) {
+        if (opcoes.autoSave) cache.escrever(kFicheiroCache);
+        root = sf.GetRoot();
+        currentDir = root.get();
+        out << "Diretoria carregada em memoria: " << path << "\n";
+        out << resumoIgnorados(contas) << resumoLigacoes(contas) << resumoCache(contas);
+    } else {
+        out << "Falha ao carregar a diretoria: " << path << "\n";
+    }
+}
+
+void Shell::cmdTouch() {
+    // Cria um ficheiro simples na diretoria atual com o tamanho indicado.
+    std::string name;
+    size_t size;
+    in >> name >> size;
+    esperarSubarvore(currentDir);
+    currentDir->addFile(name, size);
+    out << "Ficheiro criado: " << name << "\n";
+}
+
+void Shell::cmdCd() {
+    // Navegação: entra numa subdiretoria ou volta para o pai com `..`.
+    std::string name;
+    in >> name;
+    if (name == "..") {
+        if (currentDir->getParent() != nullptr) {
+            currentDir = currentDir->getParent();
+        }
+    }
+    else {
+        auto dir = currentDir->findSubdirectory(name);
+        // Ainda a carregar: espera que a subdiretoria apareça (ou que a atual fique completa).
+        if (!dir && pausa.owns_lock()) esperarCarregamento([&] {
+            dir = currentDir->findSubdirectory(name);
+            return dir != nullptr || carregamento->completa(currentDir);
+        });
+        if (dir) {
+            currentDir = dir.get();
+        }
+        else {
+            out << "Diretoria nao encontrada: " << name << "\n";
+        }
+    }
+}
+
+void Shell::cmdLs() {
+    // Mostra subdiretorias e ficheiros da diretoria atual.
+    currentDir->listContents(out);
+    if (pausa.owns_lock() && !carregamento->completa(currentDir))
+        out << "(ainda a carregar: " << carregamento->percentagem() << "%)\n";
+}
+
+void Shell::cmdRm() {
+    // Remove um ficheiro pelo nome na diretoria atual.
+    std::string name;
+    in >> name;
+    esperarSubarvore(currentDir);
+    currentDir->removeFile(name);
+    out << "Ficheiro removido: " << name << "\n";
+}
+
+void Shell::cmdRmdir() {
+    // Remove uma subdiretoria.
+    std::string name;
+    in >> name;
+    esperarSubarvore(currentDir);
+    currentDir->removeSubdirectory(name);
+    out << "Diretoria removida: " << name << "\n";
+}
+
+void Shell::cmdSize() {
+    // Soma recursivamente o tamanho de todos os ficheiros sob a diretoria atual.
+    esperarSubarvore(currentDir);
+    sf.SetRoot(root);
+    out << "Tamanho total: " << sf.TamanhoTotal(currentDir) << " bytes\n";
+}
+
+void Shell::cmdMaior() {
+    // Procura o ficheiro maior e imprime o caminho completo.
+    NodeRef best = currentDir->findLargestFileRef();
+    if (!best.file) {
+        out << "Nenhum ficheiro encontrado nesta diretoria ou subdiretorias.\n";
+    } else {
+        out << "Ficheiro maior: " << sf.RenderPath(best, currentDir)
+                  << " (" << best.file->getSize() << " bytes)\n";
+    }
+}
+
+void Shell::cmdDirectoriaMaisElementos() {
+    // Calcula a diretoria (em toda a árvore) com mais elementos (dirs+ficheiros).
+    sf.SetRoot(root);
+    auto res = sf.DirectoriaMaisElementos();
+    if (!res.has_value()) out << "Nenhuma diretoria encontrada.\n";
+    else out << res.value() << "\n";
+}
+
+void Shell::cmdDirectoriaMenosElementos() {
+    // Calcula a diretoria (em toda a árvore) com menos elementos.
+    sf.SetRoot(root);
+    auto res = sf.DirectoriaMenosElementos();
+    if (!res.has_value()) out << "Nenhuma diretoria encontrada.\n";
+    else out << res.value() << "\n";
+}
+
+void Shell::cmdFicheiroMaior() {
+    // Versão via `SistemaFicheiros` que devolve também o tamanho formatado.
+    sf.SetRoot(root);
+    auto res = sf.FicheiroMaior();
+    if (!res.has_value()) out << "Nenhum ficheiro encontrado.\n";
+    else out << res.value() << "\n";
+}
+
+void Shell::cmdDirectoriaMaisEspaco() {
+    // Diretoria que ocupa mais espaço (soma recursiva dos ficheiros).
+    sf.SetRoot(root);
+    auto res = sf.DirectoriaMaisEspaco();
+    if (!res.has_value()) out << "Nenhuma diretoria encontrada.\n";
+    else out << res.value() << "\n";
+}
+
+void Shell::cmdContarFicheiros() {
+    // Quantos ficheiros existem no sistema, no total.
+    sf.SetRoot(root);
+    out << sf.ContarFicheiros() << "\n";
+}
+
+void Shell::cmdContarDirectorios() {
+    // Quantas diretorias existem (conta inclui a raiz).
+    sf.SetRoot(root);
+    out << sf.ContarDirectorios() << "\n";
+}
+
+void Shell::cmdMemoria() {
+    // Memória total ocupada (soma dos tamanhos dos ficheiros).
+    sf.SetRoot(root);
+    out << sf.Memoria() << "\n";
+}
+
+void Shell::cmdMemInfo() {
+    // Memória RAM do próprio modelo (o comando memoria soma os tamanhos dos ficheiros).
+    sf.SetRoot(root);
+    Ocupacao::Relatorio r = sf.InfoMemoria();
+    uint64_t total = r.total();
+    auto pct = [total](uint64_t b) { return total ? 100.0 * static_cast<double>(b) / static_cast<double>(total) : 0.0; };
+    out << "Diretorias: " << r.diretorias << ", ficheiros: " << r.ficheiros << " (" << r.entradas
+        << " entradas em " << r.listas << " listas, " << r.listasPartilhadas << " partilhadas)\n";
+    out << std::fixed << std::setprecision(1);
+    auto linha = [&](const char* nome, uint64_t b) {
+        out << "  " << std::left << std::setw(32) << nome << std::right << std::setw(14) << b << " bytes"
+            << std::setw(7) << pct(b) << "%\n";
+    };
+    linha("nos Directory", r.nosDiretorias);
+    linha("nos File", r.nosFicheiros);
+    linha("dados (tamanho e data)", r.dadosFicheiros);
+    linha("nomes", r.nomes);
+    linha("datas", r.datas);
+    linha("vetores de filhos", r.vetores);
+    linha("blocos de controlo (shared_ptr)", r.blocosControlo);
+    linha("indices e caches", r.indices);
+    linha("total", total);
+    out << "Bytes por ficheiro: " << r.bytesPorFicheiro() << "\n";
+    out << "Folga: " << r.folgaVetores << " bytes nos vetores, " << r.folgaNomes << " bytes nos nomes ("
+        << pct(r.folgaVetores + r.folgaNomes) << "% do total; 'shrink' liberta-a)\n";
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+    if (uint64_t heap = Ocupacao::heapEmUso()) out << "Heap em uso (todo o processo): " << heap << " bytes\n";
+}
+
+void Shell::cmdShrink() {
+    // Os vetores não encolhem com as remoções; aqui a capacidade volta a ser a do conteúdo.
+    sf.SetRoot(root);
+    Ocupacao::Compactacao c = sf.Compactar();
+    out << "Compactado: " << c.bytes << " bytes libertados (" << c.vetores << " vetores, " << c.nomes
+        << " nomes, " << c.listasVazias << " listas vazias)\n";
+    if (uint64_t heap = Ocupacao::heapEmUso()) out << "Heap em uso (todo o processo): " << heap << " bytes\n";
+}
+
+void Shell::cmdDiff() {
+    // As subárvores com o mesmo resumo Merkle dos dois lados não são visitadas.
+    std::string a, b;
+    if (!(in >> a >> b)) { out << "Uso: diff <A.xml|.> <B.xml|.>\n"; return; }
+    sf.SetRoot(root);
+    Diferencas::Resultado res;
+    std::string erro;
+    if (!sf.Comparar(a, b, res, erro)) { out << "Nao foi possivel ler: " << erro << "\n"; return; }
+    if (res.alteracoes.empty()) { out << "Sem diferencas.\n"; return; }
+    for (const auto& alt : res.alteracoes) {
+        const char* fim = alt.diretoria ? "/" : "";
+        switch (alt.tipo) {
+            case Diferencas::Alteracao::Adicionado: out << "+ "; break;
+            case Diferencas::Alteracao::Removido: out << "- "; break;
+            case Diferencas::Alteracao::Redimensionado: out << "~ "; break;
+            case Diferencas::Alteracao::DataAlterada: out << "d "; break;
+            case Diferencas::Alteracao::Movido: out << "> "; break;
+        }
+        out << alt.caminho << fim;
+        if (alt.tipo == Diferencas::Alteracao::Movido) out << " -> " << alt.destino << fim;
+        if (alt.tipo == Diferencas::Alteracao::Redimensionado) out << " (" << alt.antes << " -> " << alt.depois << " bytes)";
+        else if (alt.diretoria) out << " (" << alt.ficheiros << " ficheiros, " << alt.depois << " bytes)";
+        else out << " (" << alt.depois << " bytes)";
+        out << "\n";
+    }
+    out << res.alteracoes.size() << " alteracoes; " << res.diretoriasComparadas << " diretorias comparadas, "
+        << res.subarvoresIguais << " subarvores iguais saltadas\n";
+}
+
+void Shell::cmdIgnore() {
+    // Sem argumento mostra as regras; o .gitignore da pasta carregada é sempre aplicado depois delas.
+    std::string arg = restoDaLinha();
+    RegrasIgnorar& regras = sf.GetRegrasIgnorar();
+    if (arg == "reset") {
+        regras = RegrasIgnorar::predefinidas();
+        out << "Regras repostas: " << regras.tamanho() << " regras predefinidas\n";
+        return;
+    }
+    if (!arg.empty()) {
+        size_t antes = regras.tamanho();
+        if (!regras.acrescentarFicheiro(arg)) { out << "Nao foi possivel ler: " << arg << "\n"; return; }
+        out << (regras.tamanho() - antes) << " regras acrescentadas de " << arg << "\n";
+        return;
+    }
+    out << regras.tamanho() << " regras (" << regras.globs() << " com curingas, as restantes em tabelas)\n";
+    out << "Origem: predefinidas";
+    for (const auto& f : regras.origens()) out << ", " << f;
+    out << "\n";
+}
+
+// "valor ± margem" arredondados; "±?" enquanto a variância não é conhecida.
+static std::string textoIntervalo(const Estimativa::Intervalo& i) {
+    std::string t = std::to_string(std::llround(i.valor));
+    if (!i.conhecida) return t + " +-?";
+    return t + " +-" + std::to_string(std::llround(i.margem));
+}
+
+void Shell::cmdEstimate() {
+    std::string pasta;
+    if (!(in >> pasta)) { out << "Uso: estimate <pasta> [segundos]\n"; return; }
+    std::string arg = restoDaLinha();
+    double segundos = 2.0;
+    if (!arg.empty()) {
+        try { segundos = std::stod(arg); } catch (...) { out << "Uso: estimate <pasta> [segundos]\n"; return; }
+    }
+    if (!estimativa || estimativa->pasta() != pasta) {
+        estimativa = std::make_unique<Estimativa>(pasta, sf.GetRegrasIgnorar());
+        if (!estimativa->valida()) { estimativa.reset(); out << "Nao foi possivel ler a pasta: " << pasta << "\n"; return; }
+    }
+    estimativa->amostrar(std::chrono::milliseconds(static_cast<long long>(segundos * 1000)));
+    Estimativa::Resultado r = estimativa->resultado(5);
+    out << "Estimativa de " << pasta << (r.exato ? " (exata)" : " (intervalos de 95%)") << ": "
+        << r.sondagens << " sondagens, " << r.diretoriasLidas << " diretorias lidas\n";
+    out << "  ficheiros:  " << textoIntervalo(r.ficheiros) << "\n";
+    out << "  bytes:      " << textoIntervalo(r.bytes) << "\n";
+    out << "  diretorias: " << textoIntervalo(r.diretorias) << "\n";
+    if (!r.maiores.empty()) out << "  maiores diretorias:\n";
+    for (const auto& d : r.maiores) {
+        out << "    " << d.nome << ": " << textoIntervalo(d.bytes) << " bytes, "
+            << textoIntervalo(d.ficheiros) << " ficheiros (" << d.sondagens << " sondagens)\n";
+    }
+}
+
+void Shell::cmdDirMais() {
+    // Versão local (partindo da diretoria atual) para diretoria com mais elementos.
+    Directory* bestDir = currentDir;
+    int bestCount = currentDir->getElementCount();
+    std::queue<Directory*> q;
+    q.push(currentDir);
+
+    while (!q.empty()) {
+        Directory* d = q.front(); q.pop();
+        int cnt = d->getElementCount();
+        if (cnt > bestCount) {
+            bestCount = cnt;
+            bestDir = d;
+        }
+        for (const auto& sub : d->getSubdirectories()) {
+            q.push(sub.get());
+        }
+    }
+
+    out << "Diretoria com mais elementos: "
+              << bestDir->getName() << " (" << bestCount << " elementos)\n";
+}
+
+void Shell::cmdDirMenos() {
+    // Versão local (partindo da diretoria atual) para diretoria com menos elementos.
+    Directory* minDir = currentDir;
+    int minCount = currentDir->getElementCount();
+    std::queue<Directory*> q;
+    q.push(currentDir);
+
+    while (!q.empty()) {
+        Directory* d = q.front(); q.pop();
+        int cnt = d->getElementCount();
+        if (cnt < minCount) {
+            minCount = cnt;
+            minDir = d;
+        }
+        for (const auto& sub : d->getSubdirectories()) {
+            q.push(sub.get());
+        }
+    }
+
+    out << "Diretoria com menos elementos: "
+              << minDir->getName() << " (" << minCount << " elementos)\n";
+}
+
+void Shell::cmdMaisEspaco() {
+    // Entre as subdiretorias diretas da atual, qual ocupa mais espaço.
+    const auto& subs = currentDir->getSubdirectories();
+    if (subs.empty()) {
+        out << "Nao existem subdiretorias na diretoria atual.\n";
+    } else {
+        size_t bestSize = 0;
+        Directory* bestDir = nullptr;
+        for (const auto& s : subs) {
+            size_t sz = s->getTotalSize();
+            if (!bestDir || sz > bestSize) {
+                bestDir = s.get();
+                bestSize = sz;
+            }
+        }
+        if (bestDir) {
+            out << "Diretoria que ocupa mais espaco: " << bestDir->getName()
+                      << " (" << bestSize << " bytes)\n";
+        }
+    }
+}
+
+void Shell::cmdRemoverAll() {
+    // Remove todos os ficheiros ou todas as diretorias com o nome indicado, na árvore toda.
+    std::string tipo;
+    if (!(in >> tipo)) {
+        out << "Uso: removerall <DIR|FILE>\n";
+        return;
+    }
+
+    std::transform(tipo.begin(), tipo.end(), tipo.begin(),
+        [](unsigned char c) { return std::toupper(c); });
+
+    if (tipo != "DIR" && tipo != "FILE") {
+        out << "Tipo invalido. Use DIR ou FILE." << "\n";
+        return;
+    }
+    bool removed = sf.RemoverTodos(tipo);
+    // A diretoria atual pode ter sido removida.
+    if (tipo == "DIR") currentDir = root.get();
+
+    if (removed) out << "Remocao concluida.\n";
+    else out << "Nenhuma ocorrencia encontrada para remover.\n";
+}
+
+void Shell::cmdExportarXml() {
+    // Exporta a árvore para um XML simples (útil para persistência/consulta).
+    std::string path;
+    if (!(in >> path)) {
+        path = "sistema.xml";
+    }
+    sf.SetRoot(root);
+    sf.Escrever_XML(path);
+    out << "Sistema exportado para: " << path << "\n";
+}
+
+void Shell::cmdLerXml() {
+    // Lê a árvore a partir de um XML gerado previamente.
+    std::string path;
+    if (!(in >> path)) {
+        out << "Uso: lerxml <ficheiro>\n";
+        return;
+    }
+
+    bool sucesso = sf.Ler_XML(path);
+    if (sucesso) {
+        root = sf.GetRoot();
+        currentDir = root.get();
+        out << "Sistema carregado com sucesso a partir de: " << path << "\n";
+        out << "Resumo: " << sf.ContarDirectorios() << " diretorias, "
+                  << sf.ContarFicheiros() << " ficheiros, " << sf.Memoria() << " bytes" << "\n";
+    }
+    else {
+        out << "Falha ao carregar o sistema a partir de: " << path << "\n";
+    }
+}
+
+void Shell::cmdTree() {
+    // Desenha a árvore em texto; se indicar ficheiro, grava em vez de imprimir.
+    std::string arg;
+    // optional filename
+    if (std::getline(in, arg)) {
+        // trim
+        auto trim = [](std::string &s){ size_t a=0; while(a<s.size() && isspace((unsigned char)s[a])) a++; size_t b=s.size(); while(b>a && isspace((unsigned char)s[b-1])) b--; s = s.substr(a,b-a); };
+        trim(arg);
+    }
+    sf.SetRoot(root);
+    if (arg.empty()) sf.Tree(nullptr, out);
+    else sf.Tree(&arg, out);
+}
+
+void Shell::cmdFindDirs() {
+    // Procura diretorias com o nome dado e lista os caminhos.
+    std::string name;
+    if (!(in >> name)) { out << "Uso: finddirs <nome>\n"; return; }
+    sf.SetRoot(root);
+    std::list<std::string> results;
+    sf.PesquisarAllDirectorias(results, name);
+    if (results.empty()) out << "Nenhuma diretoria encontrada com o nome: " << name << "\n";
+    else { out << "Diretorias encontradas:\n"; for (auto &p: results) out << "  " << p << "\n"; }
+}
+
+void Shell::cmdCopyBatch() {
+    // Copia para a raiz do destino os ficheiros cujo nome contém o padrão.
+    std::string padrao, dirOrig, dirDest;
+    if (!(in >> padrao >> dirOrig >> dirDest)) { out << "Uso: copybatch <padrao> <DirOrigem> <DirDestino>\n"; return; }
+    sf.SetRoot(root);
+    bool ok = sf.CopyBatch(padrao, dirOrig, dirDest);
+    if (ok) out << "CopyBatch concluido (ficheiros copiados para a raiz de " << dirDest << ").\n";
+    else out << "CopyBatch falhou (origem/destino nao encontrado ou nenhum ficheiro corresponde ao padrao).\n";
+}
+
+void Shell::cmdFindFiles() {
+    // Procura ficheiros com o nome dado e lista os caminhos.
+    std::string name;
+    if (!(in >> name)) { out << "Uso: findfiles <nome>\n"; return; }
+    sf.SetRoot(root);
+    std::list<std::string> results;
+    sf.PesquisarAllFicheiros(results, name);
+    if (results.empty()) out << "Nenhum ficheiro encontrado com o nome: " << name << "\n";
+    else { out << "Ficheiros encontrados:\n"; for (auto &p: results) out << "  " << p << "\n"; }
+}
+
+void Shell::cmdRenameFiles() {
+    // Renomeia todos os ficheiros com o nome antigo para o novo.
+    std::string oldName, newName;
+    if (!(in >> oldName >> newName)) { out << "Uso: renamefiles <old> <new>\n"; return; }
+    sf.SetRoot(root);
+    sf.RenomearFicheiros(oldName, newName);
+    out << "Renomeacao concluida: " << oldName << " -> " << newName << " (onde aplicavel)\n";
+}
+
+void Shell::cmdDupFiles() {
+    // Sinaliza ficheiros duplicados (mesmo nome) e lista onde estão.
+    sf.SetRoot(root);
+    auto duplicates = sf.GetFicheirosDuplicados();
+    if (duplicates.empty()) out << "Nao foram encontrados ficheiros duplicados.\n";
+    else { out << "Ficheiros duplicados encontrados:\n"; for (auto &d: duplicates) out << "  " << d << "\n"; }
+}
+
+void Shell::cmdSearch() {
+    // Pesquisa global por diretoria (1) ou ficheiro (0) e devolve o caminho completo.
+    std::string nome;
+    int tipo;
+    if (!(in >> nome >> tipo)) {
+        out << "Uso: search <nome> <0|1>\n";
+        return;
+    }
+
+    sf.SetRoot(root);
+    auto res = sf.Search(nome, tipo);
+    if (!res.has_value()) {
+        out << "Nao encontrado: " << nome << "\n";
+    } else {
+        out << "Encontrado: " << res.value() << "\n";
+    }
+}
+
+void Shell::cmdMoveFile() {
+    std::string nome, dir;
+    if (!(in >> nome >> dir)) {
+        out << "Uso: movefile <nome> <dir>\n";
+        return;
+    }
+
+    sf.SetRoot(root);
+    bool ok = sf.MoveFicheiro(nome, dir);
+    if (ok) out << "Ficheiro movido: " << nome << " -> " << dir << "\n";
+    else out << "Falha ao mover ficheiro (nao encontrado, destino inexistente, duplicado ou ja na pasta destino)\n";
+}
+
+void Shell::cmdMoveDir() {
+    std::string oldName, newName;
+    if (!(in >> oldName >> newName)) {
+        out << "Uso: movedir <DirOld> <DirNew>\n";
+        return;
+    }
+
+    sf.SetRoot(root);
+    bool ok = sf.MoverDirectoria(oldName, newName);
+    if (ok) out << "Directoria movida: " << oldName << " -> " << newName << "\n";
+    else out << "Falha ao mover directoria (nao encontrada, destino inexistente, ou destino dentro de origem)\n";
+}
+
+void Shell::cmdCpDir() {
+    std::string origem, destino;
+    if (!(in >> origem >> destino)) {
+        out << "Uso: cpdir <DirOrigem> <DirDestino>\n";
+        return;
+    }
+
+    sf.SetRoot(root);
+    bool ok = sf.CopiarDirectoria(origem, destino);
+    if (ok) out << "Directoria copiada: " << origem << " -> " << destino << "\n";
+    else out << "Falha ao copiar directoria (origem ou destino nao encontrado, ou o nome ja existe no destino)\n";
+}
+
+void Shell::cmdSep() {
+    // Separador usado ao mostrar caminhos (por exemplo '/' ou '\\').
+    std::string s;
+    if (!(in >> s) || s.size() != 1) { out << "Uso: sep <caractere>\n"; return; }
+    sf.SetSeparador(s[0]);
+    out << "Separador definido: " << s << "\n";
+}
+
+void Shell::cmdEspelho() {
+    // Repetir no disco as cópias e movimentos (simular só mostra o plano).
+    Espelho& e = sf.GetEspelho();
+    // Argumento opcional: só o que estiver na mesma linha.
+    std::string modo = restoDaLinha();
+    if (!modo.empty()) {
+        if (modo == "desligado") e.setModo(Espelho::Modo::Desligado);
+        else if (modo == "simular") e.setModo(Espelho::Modo::Simular);
+        else if (modo == "aplicar") e.setModo(Espelho::Modo::Aplicar);
+        else { out << "Uso: espelho [desligado|simular|aplicar]\n"; return; }
+    }
+    sf.SetRoot(root);
+    out << "Espelho no disco: " << Espelho::nomeModo(e.modo()) << "\n";
+    std::string origem = sf.GetOrigemDisco();
+    if (e.modo() != Espelho::Modo::Desligado) {
+        if (origem.empty()) out << "Aviso: a arvore atual nao foi carregada do disco; nada sera espelhado.\n";
+        else out << "Pasta de origem: " << origem << "\n";
+    }
+}
+
+void Shell::cmdProfile() {
+    // Sem argumentos mostra os pontos medidos; "trace on" guarda também um evento por medida.
+    std::istringstream args(restoDaLinha());
+    std::string acao, alvo;
+    args >> acao >> alvo;
+    if (acao == "on" || acao == "off") {
+        perfil::ligar(acao == "on");
+        out << "Perfil " << (acao == "on" ? "ligado" : "desligado") << ".\n";
+        return;
+    }
+    if (acao == "reset") {
+        perfil::limpar();
+        out << "Perfil limpo.\n";
+        return;
+    }
+    if (acao == "trace" && alvo == "on") {
+        perfil::ligar(true);
+        perfil::iniciarTraco();
+        out << "A gravar o traco; 'profile trace <ficheiro.json>' escreve-o.\n";
+        return;
+    }
+    if (acao == "trace" && !alvo.empty()) {
+        size_t n = 0;
+        if (perfil::gravarTraco(alvo, &n)) out << n << " eventos escritos em " << alvo << " (abrir em ui.perfetto.dev ou chrome://tracing)\n";
+        else out << "Nao foi possivel escrever " << alvo << "\n";
+        return;
+    }
+    if (!acao.empty()) {
+        out << "Uso: profile [on|off|reset|trace <on|ficheiro.json>]\n";
+        return;
+    }
+
+    out << "Perfil " << (perfil::ligado() ? "ligado" : "desligado")
+        << (perfil::tracoAtivo() ? ", a gravar o traco" : "")
+        << (perfil::contaAlocacoes() ? "" : " (alocacoes nao contadas nesta compilacao)") << "\n";
+    auto linhas = perfil::resumo();
+    if (linhas.empty()) {
+        out << "Sem medicoes (use 'profile on').\n";
+        return;
+    }
+    out << std::left << std::setw(36) << "ponto" << std::right << std::setw(8) << "vezes"
+        << std::setw(11) << "total ms" << std::setw(10) << "media ms" << std::setw(10) << "p50 ms"
+        << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(12) << "nos"
+        << std::setw(12) << "KB alocados" << std::setw(10) << "alocacoes" << std::setw(9) << "syscalls" << "\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& l : linhas) {
+        out << std::left << std::setw(36) << l.nome << std::right << std::setw(8) << l.vezes
+            << std::setw(11) << l.totalMs << std::setw(10) << l.mediaMs << std::setw(10) << l.p50Ms
+            << std::setw(10) << l.p99Ms << std::setw(10) << l.maxMs << std::setw(12) << l.nos
+            << std::setw(12) << l.bytes / 1024 << std::setw(10) << l.alocacoes << std::setw(9) << l.chamadasSistema << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+void Shell::cmdFreeze() {
+    // Compacta a árvore; as consultas seguintes usam-na até haver alterações.
+    sf.SetRoot(root);
+    size_t n = sf.Congelar();
+    out << "Arvore congelada: " << n << " nos\n";
+}
+
+void Shell::cmdUnfreeze() {
+    sf.Descongelar();
+    out << "Copia congelada descartada.\n";
+}
+
+void Shell::cmdStats() {
+    // Estatísticas globais; com a árvore congelada são reduções vetorizadas.
+    sf.SetRoot(root);
+    static const std::vector<uint64_t> limites = { 1024ull, 1024ull * 1024, 100ull * 1024 * 1024, 1024ull * 1024 * 1024 };
+    static const char* faixas[] = { "< 1 KB", "1 KB - 1 MB", "1 MB - 100 MB", "100 MB - 1 GB", ">= 1 GB" };
+    out << "Modo: " << (sf.frozenView() ? "congelada" : "ponteiros")
+              << " (" << kernels::isaName(kernels::activeIsa()) << ")\n";
+    out << "Ficheiros: " << sf.ContarFicheiros() << "\n";
+    out << "Tamanho total: " << sf.TamanhoTotal(root.get()) << " bytes\n";
+    auto inodes = sf.ContarBytesUnicos(root.get());
+    if (inodes.ligacoesRepetidas > 0) {
+        out << "Bytes unicos: " << inodes.unicos << " (" << inodes.ligacoesRepetidas
+            << " ligacoes fisicas repetidas, " << (inodes.aparentes - inodes.unicos) << " bytes)\n";
+    } else {
+        out << "Bytes unicos: " << inodes.unicos << "\n";
+    }
+    auto maior = sf.FicheiroMaior();
+    if (maior.has_value()) out << "Maior: " << maior.value() << "\n";
+    auto hist = sf.HistogramaTamanhos(limites);
+    for (size_t k = 0; k < hist.size(); ++k) {
+        out << "  " << faixas[k] << ": " << hist[k] << "\n";
+    }
+}
+
+void Shell::cmdDateCount() {
+    std::string de, ate;
+    // Aceita AAAAMMDD (8 algarismos) ou AAAA|MM|DD; 0 se o texto todo não for uma data.
+    auto toYmd = [](const std::string& s) -> int32_t {
+        int y = 0, m = 0, d = 0;
+        const char* p = s.data();
+        const char* fim = p + s.size();
+        if (s.find('|') == std::string::npos) {
+            int v = 0;
+            auto r = std::from_chars(p, fim, v);
+            if (s.size() != 8 || r.ec != std::errc() || r.ptr != fim) return 0;
+            y = v / 10000; m = v / 100 % 100; d = v % 100;
+        } else {
+            int* partes[3] = { &y, &m, &d };
+            for (int k = 0; k < 3; ++k) {
+                auto r = std::from_chars(p, fim, *partes[k]);
+                if (r.ec != std::errc()) return 0;
+                p = r.ptr;
+                if (k < 2 && (p == fim || *p++ != '|')) return 0;
+            }
+            if (p != fim) return 0;
+        }
+        if (y <= 0 || m < 1 || m > 12 || d < 1 || d > 31) return 0;
+        return y * 10000 + m * 100 + d;
+    };
+    int32_t a = 0, b = 0;
+    if (!(in >> de >> ate) || !(a = toYmd(de)) || !(b = toYmd(ate))) {
+        out << "Uso: datecount <de> <ate> (AAAAMMDD ou AAAA|MM|DD)\n";
+        return;
+    }
+    sf.SetRoot(root);
+    out << sf.ContarPorData(a, b) << " ficheiros entre " << de << " e " << ate << "\n";
+}
+
+void Shell::cmdSnapExport() {
+    std::string path;
+    if (!(in >> path)) { out << "Uso: snapexport <ficheiro>\n"; return; }
+    // Publica a árvore atual e fixa essa versão antes de entregar a tarefa ao executor.
+    auto pin = fixarVersao();
+    auto t = executor().submeter("snapexport " + path, [pin, path](Tarefa& t) {
+        if (!SistemaFicheiros::EscreverXml(**pin, path, &t.progresso) && !t.progresso.cancelado())
+            throw std::runtime_error("nao foi possivel escrever " + path);
+        t.mensagem = "Versao " + std::to_string(pin->version()) + " exportada para: " + path;
+    });
+    out << "[" << t->id << "] A exportar a versao " << pin->version() << " para " << path << " em segundo plano.\n";
+}
+
+void Shell::cmdExport() {
+    std::string nome, path;
+    Exportador::Formato formato;
+    if (!(in >> nome >> path) || !Exportador::formato(nome, formato)) {
+        out << "Uso: export <csv|jsonl|col> <ficheiro>\n";
+        return;
+    }
+    // Como snapexport: a tarefa escreve a versão fixada agora, mesmo que a árvore mude entretanto.
+    auto pin = fixarVersao();
+    char sep = sf.GetSeparador();
+    auto t = executor().submeter("export " + nome + " " + path, [pin, formato, path, sep](Tarefa& t) {
+        const FlatTree& ft = **pin;
+        if (!Exportador().escrever(ft, formato, path, sep, &t.progresso)) {
+            if (!t.progresso.cancelado()) throw std::runtime_error("nao foi possivel escrever " + path);
+            return;
+        }
+        t.mensagem = std::to_string(ft.size()) + " linhas exportadas para: " + path;
+    });
+    out << "[" << t->id << "] A exportar a versao " << pin->version() << " para " << path << " em segundo plano.\n";
+}
+
+void Shell::cmdQuery() {
+    std::string texto = restoDaLinha();
+    if (texto.empty()) {
+        out << "Uso: query <condicoes> [| count|sum|top N]\n";
+        return;
+    }
+    Consulta consulta;
+    std::string erro;
+    if (!consulta.compilar(texto, erro)) {
+        out << "Consulta invalida: " << erro << "\n";
+        return;
+    }
+    // Corre sobre a versão fixada agora (as colunas da FlatTree); "under ." é a diretoria atual.
+    auto pin = fixarVersao();
+    const FlatTree& ft = **pin;
+    auto resolver = [&](std::string_view p) {
+        std::shared_ptr<Directory> d = (p == ".") ? nullptr : sf.resolvePath(p);
+        const Directory* dir = (p == ".") ? currentDir : d.get();
+        return dir ? ft.indexOf(dir) : FlatTree::npos;
+    };
+    const char sep = sf.GetSeparador();
+    std::string caminho;
+    auto mostrar = [&](const uint32_t* nos, size_t n) {
+        for (size_t k = 0; k < n; ++k) {
+            ft.renderPath(nos[k], caminho, sep);
+            out << "  " << caminho << " (" << ft.sizes[nos[k]] << " bytes)\n";
+        }
+    };
+    Consulta::Resultado r;
+    if (!consulta.executar(ft, resolver, mostrar, r, erro)) {
+        out << erro << "\n";
+        return;
+    }
+    switch (consulta.agregacao()) {
+    case Consulta::Agregacao::Contar:
+        out << r.ficheiros << " ficheiros\n";
+        break;
+    case Consulta::Agregacao::Maiores:
+        mostrar(r.maiores.data(), r.maiores.size());
+        out << r.maiores.size() << " maiores de " << r.ficheiros << " ficheiros (" << r.bytes << " bytes)\n";
+        break;
+    default:
+        out << r.ficheiros << " ficheiros, " << r.bytes << " bytes\n";
+        break;
+    }
+    out << "Plano: " << r.plano << "\n";
+}
+
+void Shell::cmdSnapInfo() {
+    out << "Versao publicada: " << sf.VersaoPublicada()
+              << (sf.frozenView() ? " (atual)" : " (desatualizada)") << "\n";
+    out << "Versoes retidas por leitores: " << sf.VersoesRetidas() << "\n";
+    out << "Tarefas em segundo plano ativas: " << (tarefas ? tarefas->ativas() : 0) << "\n";
+}
+
+void Shell::cmdGetDate() {
+    std::string fname;
+    if (!(in >> fname)) {
+        out << "Uso: getdate <nome_ficheiro>\n";
+        return;
+    }
+
+    sf.SetRoot(root);
+    auto pdate = sf.DataFicheiro(fname);
+    if (!pdate.has_value()) {
+        out << "Ficheiro nao encontrado: " << fname << "\n";
+    } else {
+        std::string stored = pdate.value();
+        std::string ymd = convertAsctimeToYMD(stored);
+        out << "Data de " << fname << ": " << ymd << "\n";
+    }
+}
+
+void Shell::cmdBg() {
+    std::string op;
+    if (!(in >> op)) { out << "Uso: bg <load|exportarxml|dupfiles|copybatch> <argumentos>\n"; return; }
+    std::shared_ptr<Tarefa> t;
+    if (op == "load") {
+        std::string path;
+        if (!(in >> path)) { out << "Uso: bg load <path>\n"; return; }
+        // A árvore nova é construída à parte e só substitui a atual quando a tarefa é recolhida.
+        auto regras = std::make_shared<RegrasIgnorar>(sf.GetRegrasIgnorar());
+        bool lerCache = opcoes.autoLoad, escreverCache = opcoes.autoSave;
+        t = executor().submeter("load " + path, [this, path, regras, lerCache, escreverCache](Tarefa& t) {
+            SistemaFicheiros::Varrimento contas;
+            CacheVarrimento cache;
+            if (lerCache) cache.ler(kFicheiroCache);
+            auto novo = SistemaFicheiros::CarregarArvore(path, &t.progresso, regras.get(), &contas, &cache);
+            if (!novo) {
+                if (!t.progresso.cancelado()) throw std::runtime_error("Falha ao carregar a diretoria: " + path);
+                return;
+            }
+            if (escreverCache) cache.escrever(kFicheiroCache);
+            t.mensagem = "Diretoria carregada em memoria: " + path + "\n" + resumoIgnorados(contas) +
+                         resumoLigacoes(contas) + resumoCache(contas);
+            t.aplicar = [this, novo, path]() {
+                sf.SetRoot(novo);
+                sf.SetOrigemDisco(novo.get(), path);
+                root = novo;
+                currentDir = root.get();
+            };
+        });
+    }
+    else if (op == "exportarxml") {
+        std::string path;
+        if (!(in >> path)) path = "sistema.xml";
+        auto pin = fixarVersao();
+        t = executor().submeter("exportarxml " + path, [pin, path](Tarefa& t) {
+            if (!SistemaFicheiros::EscreverXml(**pin, path, &t.progresso) && !t.progresso.cancelado())
+                throw std::runtime_error("nao foi possivel escrever " + path);
+            t.mensagem = "Sistema exportado para: " + path;
+        });
+    }
+    else if (op == "dupfiles") {
+        auto pin = fixarVersao();
+        char sep = sf.GetSeparador();
+        t = executor().submeter("dupfiles", [pin, sep](Tarefa& t) {
+            auto duplicates = SistemaFicheiros::Duplicados(**pin, sep, &t.progresso);
+            if (t.progresso.cancelado()) return;
+            std::string msg;
+            if (duplicates.empty()) msg = "Nao foram encontrados ficheiros duplicados.\n";
+            else {
+                msg = "Ficheiros duplicados encontrados:\n";
+                for (auto &d : duplicates) msg += "  " + d + "\n";
+            }
+            t.mensagem = std::move(msg);
+        });
+    }
+    else if (op == "copybatch") {
+        std::string padrao, dirOrig, dirDest;
+        if (!(in >> padrao >> dirOrig >> dirDest)) { out << "Uso: bg copybatch <padrao> <DirOrigem> <DirDestino>\n"; return; }
+        sf.SetRoot(root);
+        auto src = sf.resolvePath(dirOrig);
+        auto dst = sf.resolvePath(dirDest);
+        if (!src || !dst) { out << "CopyBatch falhou (origem/destino nao encontrado ou nenhum ficheiro corresponde ao padrao).\n"; return; }
+        auto pin = fixarVersao();
+        uint32_t iSrc = (*pin)->indexOf(src.get());
+        uint32_t iDst = (*pin)->indexOf(dst.get());
+        // O plano é feito sobre a versão fixada; só é aplicado se a árvore não mudou entretanto.
+        unsigned long long versao = Directory::contentVersion() + File::modificationVersion();
+        std::weak_ptr<Directory> destino = dst;
+        t = executor().submeter("copybatch " + padrao + " " + dirOrig + " " + dirDest,
+            [this, pin, iSrc, iDst, padrao, dirDest, versao, destino](Tarefa& t) {
+                auto plano = std::make_shared<std::vector<SistemaFicheiros::CopiaPlaneada>>(
+                    SistemaFicheiros::PlanearCopyBatch(**pin, iSrc, iDst, padrao, &t.progresso));
+                if (t.progresso.cancelado()) return;
+                if (plano->empty()) throw std::runtime_error("CopyBatch falhou (nenhum ficheiro corresponde ao padrao).");
+                Tarefa* tp = &t;
+                t.aplicar = [this, tp, plano, dirDest, versao, destino]() {
+                    auto dst = destino.lock();
+                    if (!dst || versao != Directory::contentVersion() + File::modificationVersion()) {
+                        tp->mensagem = "CopyBatch descartado: a arvore mudou enquanto a copia era planeada.";
+                        return;
+                    }
+                    SistemaFicheiros::AplicarCopia(*dst, *plano);
+                    tp->mensagem = "CopyBatch concluido (" + std::to_string(plano->size())
+                                 + " ficheiros copiados para a raiz de " + dirDest + ").";
+                };
+            });
+    }
+    else {
+        out << "Operacao nao suportada em segundo plano: " << op << "\n";
+        return;
+    }
+    out << "[" << t->id << "] " << t->descricao << " em segundo plano.\n";
+}
+
+void Shell::cmdJobs() {
+    if (carregamento) {
+        out << "[-] em curso  carregar " << kFicheiroEstado << "  " << carregamento->percentagem() << "%, "
+            << carregamento->progresso().entradas.load() << " linhas, "
+            << carregamento->progresso().bytes.load() << " bytes\n";
+    }
+    if (!tarefas || tarefas->listar().empty()) {
+        if (!carregamento) out << "Nenhuma tarefa em segundo plano.\n";
+        return;
+    }
+    for (const auto& t : tarefas->listar()) {
+        out << "[" << t->id << "] " << Tarefa::nomeEstado(t->estado()) << "  " << t->descricao
+            << "  " << t->progresso.entradas.load() << " entradas, "
+            << t->progresso.bytes.load() << " bytes, "
+            << std::fixed << std::setprecision(1) << t->segundos() << " s\n";
+        out.unsetf(std::ios::floatfield);
+    }
+}
+
+void Shell::cmdCancel() {
+    int id;
+    if (!(in >> id)) { out << "Uso: cancel <id>\n"; return; }
+    if (tarefas && tarefas->cancelar(id)) out << "Cancelamento pedido para a tarefa " << id << ".\n";
+    else out << "Tarefa nao encontrada ou ja terminada: " << id << "\n";
+}
+
+void Shell::cmdWait() {
+    if (!tarefas) return;
+    tarefas->esperar();
+    recolherTarefas();
+}
@@ -0,0 +1,190 @@
+#ifndef SHELL_HPP
+#define SHELL_HPP
+
+/**
+ * @file Shell.hpp
+ * @brief Declara a classe Shell (interpretador de comandos do gestor).
+ */
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "CarregamentoXml.hpp"
+#include "Directory.hpp"
+#include "Estimativa.hpp"
+#include "SistemaFicheiros.hpp"
+#include "Tarefas.hpp"
+
+/**
+ * @class Shell
+ * @brief Lê comandos de um istream, executa-os sobre a árvore e escreve o resultado num ostream.
+ *
+ * Cada comando é uma função membro registada numa tabela construída uma vez;
+ * o ciclo só lê o nome, procura-o na tabela e chama o handler, que lê os seus
+ * próprios argumentos. O mesmo código serve o modo interativo e o modo batch.
+ */
+class Shell {
+public:
+    /** @brief Opções de arranque. */
+    struct Opcoes {
+        bool interativo = true; ///< Mostra boas-vindas, lista de comandos e prompt.
+        bool autoLoad = true;   ///< Carrega sistema_saved.xml ao arrancar (no modo interativo, em segundo plano).
+        bool autoSave = true;   ///< Grava sistema_saved.xml no comando exit.
+    };
+
+    /** @brief Ficheiro usado para retomar o estado entre sessões. */
+    static constexpr const char* kFicheiroEstado = "sistema_saved.xml";
+    /** @brief Listagens do último Load, junto do estado (lidas com autoLoad, escritas com autoSave). */
+    static constexpr const char* kFicheiroCache = "sistema_cache.bin";
+
+    Shell(std::istream& in, std::ostream& out, Opcoes opcoes);
+    /**
+     * @brief Sessão sobre uma árvore partilhada com outras sessões (ex.: clientes do daemon).
+     * @details Antes de cada comando a diretoria atual é revalidada, porque outra
+     *          sessão pode tê-la removido ou ter carregado uma árvore nova.
+     */
+    Shell(SistemaFicheiros& comum, std::istream& in, std::ostream& out, Opcoes opcoes);
+    /** @brief Cancela as tarefas em segundo plano que ainda estejam a correr. */
+    ~Shell();
+    Shell(const Shell&) = delete;
+    Shell& operator=(const Shell&) = delete;
+
+    /**
+     * @brief Executa comandos até exit ou ao fim da entrada.
+     * @return Número de comandos desconhecidos encontrados até agora.
+     */
+    size_t run();
+    /**
+     * @brief Executa um comando cujo nome já foi lido (os argumentos vêm de in).
+     * @return false se o comando pede para terminar (exit).
+     */
+    bool executar(std::string_view cmd);
+    /** @brief Escreve a lista de comandos. */
+    void printCommands() const;
+
+    /** @brief Sistema de ficheiros gerido por esta shell. */
+    SistemaFicheiros& sistema() { return sf; }
+    /** @brief Número de comandos desconhecidos encontrados até agora. */
+    size_t comandosInvalidos() const { return invalidos; }
+
+private:
+    using Handler = void (Shell::*)();
+
+    /** @brief Tabela nome -> handler, construída na primeira utilização. */
+    static const std::unordered_map<std::string_view, Handler>& comandos();
+
+    /** @brief Numa árvore partilhada, repõe a diretoria atual a partir do caminho guardado. */
+    void sincronizar();
+    /** @brief Guarda o caminho da diretoria atual (por nomes) e a versão da estrutura. */
+    void lembrarPosicao();
+    /** @brief Executor das tarefas em segundo plano (criado no primeiro bg). */
+    Executor& executor();
+    /** @brief Aplica o resultado das tarefas terminadas e mostra o seu resumo. */
+    void recolherTarefas();
+    /** @brief Lê o resto da linha atual (sem espaços nas pontas), para argumentos opcionais. */
+    std::string restoDaLinha();
+    /** @brief Publica a árvore atual e fixa essa versão (para ler numa tarefa). */
+    std::shared_ptr<SnapshotStore::Pin> fixarVersao();
+    /** @brief Espera pelo fim do carregamento inicial e passa a usar a árvore lida. */
+    void concluirCarregamento();
+    /**
+     * @brief Durante o carregamento inicial, espera (sem o bloquear) que pronto() se cumpra.
+     * @details Só tem efeito num comando que corre sobre a árvore parcial.
+     */
+    void esperarCarregamento(const std::function<bool()>& pronto);
+    /** @brief Durante o carregamento inicial, espera que a subárvore de d esteja toda lida. */
+    void esperarSubarvore(const Directory* d);
+
+    // Handlers (um por comando; os argumentos são lidos de in).
+    void cmdHelp();
+    void cmdMkdir();
+    void cmdLoad();
+    void cmdTouch();
+    void cmdCd();
+    void cmdLs();
+    void cmdRm();
+    void cmdRmdir();
+    void cmdSize();
+    void cmdMaior();
+    void cmdDirectoriaMaisElementos();
+    void cmdDirectoriaMenosElementos();
+    void cmdFicheiroMaior();
+    void cmdDirectoriaMaisEspaco();
+    void cmdContarFicheiros();
+    void cmdContarDirectorios();
+    void cmdMemoria();
+    void cmdMemInfo();
+    void cmdShrink();
+    void cmdDiff();
+    void cmdIgnore();
+    void cmdEstimate();
+    void cmdDirMais();
+    void cmdDirMenos();
+    void cmdMaisEspaco();
+    void cmdRemoverAll();
+    void cmdExportarXml();
+    void cmdLerXml();
+    void cmdTree();
+    void cmdFindDirs();
+    void cmdCopyBatch();
+    void cmdFindFiles();
+    void cmdRenameFiles();
+    void cmdDupFiles();
+    void cmdSearch();
+    void cmdMoveFile();
+    void cmdMoveDir();
+    void cmdCpDir();
+    void cmdEspelho();
+    void cmdProfile();
+    void cmdSep();
+    void cmdFreeze();
+    void cmdUnfreeze();
+    void cmdStats();
+    void cmdDateCount();
+    void cmdSnapExport();
+    void cmdExport();
+    void cmdQuery();
+    void cmdSnapInfo();
+    void cmdBg();
+    void cmdJobs();
+    void cmdCancel();
+    void cmdWait();
+    void cmdGetDate();
+
+    std::istream& in;
+    std::ostream& out;
+    Opcoes opcoes;
+
+    // Sistema próprio (modo normal) ou de outra entidade (sessões partilhadas).
+    std::unique_ptr<SistemaFicheiros> proprio;
+    SistemaFicheiros& sf;
+    bool partilhado;
+    std::shared_ptr<Directory> root;
+    Directory* currentDir;
+    size_t invalidos = 0;
+    // Só em sessões partilhadas: posição da diretoria atual por nomes.
+    std::vector<std::string> caminho;
+    unsigned long long versaoVista = 0;
+
+    // Tarefas em segundo plano: leem uma versão fixada ou constroem uma árvore nova,
+    // por isso os comandos seguintes podem continuar a usar (e alterar) a árvore.
+    // Declarado depois de sf: é destruído (e as versões fixadas libertadas) antes dele.
+    std::unique_ptr<Executor> tarefas;
+    // Última estimativa por amostragem: repetir estimate na mesma pasta acumula sondagens.
+    std::unique_ptr<Estimativa> estimativa;
+
+    // Carregamento inicial em segundo plano (modo interativo). Enquanto decorre,
+    // os comandos de navegação correm sobre a parte já lida com o carregamento
+    // parado (pausa); os restantes esperam pelo fim. Declarado por último: a
+    // thread de leitura pára antes de a árvore ser destruída.
+    std::unique_ptr<CarregamentoXml> carregamento;
+    std::unique_lock<std::mutex> pausa;
+};
+
+#endif // SHELL_HPP
@@ -9,105 +9,117 @@
 #include <map>
 #include <cstdio>
 #include <cctype>
+#include <ctime>
 #include <optional>
-#include <stack>
 #include <vector>
 #include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include "CacheVarrimento.hpp"
+#include "CarregamentoXml.hpp"
+#include "EscritorXml.hpp"
+#include "Kernels.hpp"
+#include "Lote.hpp"
+#include "NomesUnicos.hpp"
+#include "Perfil.hpp"
 
 namespace fs = std::filesystem;
 
-SistemaFicheiros::SistemaFicheiros() : root(nullptr) {}
+namespace {
+
+// Mesmo formato de asctime ("Wed Jun 30 21:49:08 1993"), mas reentrante.
+std::string dataDoDisco(std::time_t t) {
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
+    static const char* dias[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char* meses[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    char dateBuf[64];
+    std::snprintf(dateBuf, sizeof(dateBuf), "%.3s %.3s%3d %.2d:%.2d:%.2d %d",
+                  dias[local.tm_wday], meses[local.tm_mon], local.tm_mday,
+                  local.tm_hour, local.tm_min, local.tm_sec, 1900 + local.tm_year);
+    return dateBuf;
+}
+
+// Identidade de um ficheiro no disco: (dispositivo, inode).
+struct Inode {
+    uint64_t dispositivo, inode;
+    bool operator==(const Inode& o) const { return dispositivo == o.dispositivo && inode == o.inode; }
+};
+struct HashInode {
+    size_t operator()(const Inode& i) const {
+        return std::hash<uint64_t>()(i.inode ^ (i.dispositivo * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+} // namespace
+
+SistemaFicheiros::SistemaFicheiros()
+    : root(nullptr), separator(static_cast<char>(fs::path::preferred_separator)),
+      frozenRoot(nullptr), frozenDirVersion(0), frozenFileVersion(0), raizDisco(nullptr),
+      regrasIgnorar(RegrasIgnorar::predefinidas()) {}
 // Libertamos referências à raiz para permitir nova carga ou encerramento limpo.
 SistemaFicheiros::~SistemaFicheiros() { clearSystem(); }
 
 void SistemaFicheiros::clearSystem() {
     root = nullptr;
+    raizDisco = nullptr;
+    caminhoDisco.clear();
+    resolver.setRoot(nullptr);
+    Descongelar();
 }
 
-// Constrói a árvore em memória a partir de uma pasta real do disco.
-bool SistemaFicheiros::Load(const std::string& pathStr) {
-    try {
-        fs::path basePath(pathStr);
-        if (!fs::exists(basePath)) return false;
+// ----------------------------------------
+// Árvore congelada
+size_t SistemaFicheiros::Congelar() {
+    perfil::Medida medida("SistemaFicheiros::Congelar");
+    if (!root) { Descongelar(); return 0; }
+    auto ft = std::make_unique<FlatTree>(*root);
+    size_t n = ft->size();
+    frozenRoot = root.get();
+    frozenDirVersion = Directory::contentVersion();
+    frozenFileVersion = File::modificationVersion();
+    // A versão anterior só é libertada quando os leitores que a fixaram terminarem.
+    snapshots.publish(std::move(ft));
+    return n;
+}
 
-        clearSystem();
-        root = std::make_shared<Directory>(basePath.filename().string());
-
-        // Alguns diretórios/ficheiros são ignorados para reduzir ruído.
-        static const std::vector<std::string> ignoreDirs = { ".git", ".vscode", "bin", "obj", "build" };
-        static const std::vector<std::string> ignoreFiles = { ".gitignore", ".DS_Store" };
-
-        for (auto it = fs::recursive_directory_iterator(basePath, fs::directory_options::skip_permission_denied);
-             it != fs::recursive_directory_iterator(); ++it)
-        {
-            const auto& entry = *it;
-            fs::path entryPath = entry.path();
-            std::string filename = entryPath.filename().string();
-
-            if (entry.is_directory() &&
-                std::find(ignoreDirs.begin(), ignoreDirs.end(), filename) != ignoreDirs.end())
-            {
-                it.disable_recursion_pending();
-                continue;
-            }
+void SistemaFicheiros::Descongelar() {
+    if (snapshots.current()) snapshots.publish(nullptr);
+    frozenRoot = nullptr;
+}
 
-            if (!entry.is_directory()) {
-                std::string ext = entryPath.extension().string();
-                if (ext == ".exe" ||
-                    std::find(ignoreFiles.begin(), ignoreFiles.end(), filename) != ignoreFiles.end())
-                {
-                    continue;
-                }
-            }
+// Qualquer alteração à árvore (ou troca de raiz) torna a cópia obsoleta.
+const FlatTree* SistemaFicheiros::frozenView() const {
+    const FlatTree* ft = snapshots.current();
+    if (!ft || !root || frozenRoot != root.get()) return nullptr;
+    if (frozenDirVersion != Directory::contentVersion() || frozenFileVersion != File::modificationVersion()) return nullptr;
+    return ft;
+}
 
-            fs::path rel = entryPath.lexically_relative(basePath);
-            if (rel.empty()) continue;
-
-            if (entry.is_directory()) {
-                auto dir = root;
-                for (const auto& part : rel) {
-                    std::string segment = part.string();
-                    auto subdir = dir->findSubdirectory(segment);
-                    if (!subdir) {
-                        dir->addSubdirectory(segment);
-                        subdir = dir->findSubdirectory(segment);
-                    }
-                    dir = subdir;
-                }
-            } else {
-                std::error_code ec;
-                auto fileSize = fs::file_size(entryPath, ec);
-                if (ec) continue;
-
-                auto dir = root;
-                fs::path parent = rel.parent_path();
-                if (!parent.empty()) {
-                    for (const auto& part : parent) {
-                        std::string segment = part.string();
-                        auto subdir = dir->findSubdirectory(segment);
-                        if (!subdir) {
-                            dir->addSubdirectory(segment);
-                            subdir = dir->findSubdirectory(segment);
-                        }
-                        dir = subdir;
-                    }
-                }
+SnapshotStore::Pin SistemaFicheiros::Snapshot() const { return snapshots.pin(); }
 
-                // Data do ficheiro
-                auto ftime = fs::last_write_time(entryPath, ec);
-                auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                    ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
-                );
-                std::time_t cftime = std::chrono::system_clock::to_time_t(sctp);
-                std::string dateStr = std::asctime(std::localtime(&cftime));
-                dateStr.erase(std::remove(dateStr.begin(), dateStr.end(), '\n'), dateStr.end());
-
-                dir->addFile(entryPath.filename().string(), fileSize);
-                auto fptr = dir->findFile(entryPath.filename().string());
-                if (fptr) fptr->setDate(dateStr);
-            }
-        }
+uint64_t SistemaFicheiros::VersaoPublicada() const { return snapshots.currentVersion(); }
+
+size_t SistemaFicheiros::VersoesRetidas() {
+    snapshots.reclaim();
+    return snapshots.retiredCount();
+}
 
+// Constrói a árvore em memória a partir de uma pasta real do disco.
+bool SistemaFicheiros::Load(const std::string& pathStr, Varrimento* contas, CacheVarrimento* cache) {
+    perfil::Medida medida("SistemaFicheiros::Load");
+    try {
+        auto novo = CarregarArvore(pathStr, nullptr, &regrasIgnorar, contas, cache);
+        if (!novo) return false;
+        clearSystem();
+        root = novo;
+        resolver.setRoot(root);
+        SetOrigemDisco(root.get(), pathStr);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Erro ao carregar sistema de ficheiros: " << e.what() << "\n";
@@ -118,142 +130,454 @@ bool SistemaFicheiros::Load(const std::string& pathStr) {
     }
 }
 
+// Constrói uma árvore nova sem tocar no estado do sistema (pode correr noutra thread).
+// Percorre uma diretoria de cada vez: a listagem vem da cache se a diretoria
+// não mudou, senão do disco; as regras de ignorar aplicam-se depois.
+std::shared_ptr<Directory> SistemaFicheiros::CarregarArvore(const std::string& pathStr, Progresso* prog,
+                                                            const RegrasIgnorar* regras, Varrimento* contas,
+                                                            CacheVarrimento* cache) {
+    perfil::Medida medida("SistemaFicheiros::CarregarArvore");
+    fs::path basePath(pathStr);
+    std::error_code ecBase;
+    if (!fs::is_directory(basePath, ecBase)) return nullptr;
+
+    auto root = std::make_shared<Directory>(basePath.filename().string());
+
+    // Algumas entradas são ignoradas para reduzir ruído: as regras configuradas
+    // e, depois delas (ganham em caso de conflito), as do .gitignore da pasta.
+    if (!regras) regras = &RegrasIgnorar::predefinidas();
+    RegrasIgnorar daPasta;
+    fs::path gitignore = basePath / ".gitignore";
+    std::error_code ecIgnore;
+    if (fs::is_regular_file(gitignore, ecIgnore)) {
+        daPasta = *regras;
+        daPasta.acrescentarFicheiro(gitignore.string());
+        regras = &daPasta;
+    }
+    Varrimento contagem;
+    if (!contas) contas = &contagem;
+    *contas = Varrimento();
+    contas->regras = regras->tamanho();
+    if (cache) cache->comecar(pathStr);
+    // Só os ficheiros com mais de uma ligação entram no mapa.
+    std::unordered_map<Inode, std::shared_ptr<const File::Dados>, HashInode> porInode;
+
+    struct Pendente {
+        Directory* dir;
+        std::string relativo; // com '/', "" para a raiz
+        fs::path caminho;
+    };
+    std::vector<Pendente> pilha;
+    pilha.push_back({ root.get(), std::string(), basePath });
+    std::vector<Pendente> filhas;
+    CacheVarrimento::Listagem semCache;
+    while (!pilha.empty()) {
+        Pendente atual = std::move(pilha.back());
+        pilha.pop_back();
+        const CacheVarrimento::Listagem* l = nullptr;
+        if (cache) {
+            bool reutilizada = false;
+            l = cache->listar(atual.relativo, atual.caminho.string(), reutilizada);
+            if (reutilizada) contas->diretoriasReutilizadas++;
+        } else {
+            semCache = CacheVarrimento::lerDiretoria(atual.caminho.string());
+            l = &semCache;
+        }
+        if (!l) continue;
+        contas->listagens++;
+
+        filhas.clear();
+        for (const auto& e : l->entradas) {
+            if (prog) {
+                if (prog->cancelado()) return nullptr;
+                prog->entradas.fetch_add(1, std::memory_order_relaxed);
+            }
+            perfil::nos();
+            const bool eDiretoria = e.tipo == CacheVarrimento::Diretoria || e.tipo == CacheVarrimento::LigacaoDiretoria;
+            std::string relativo = atual.relativo.empty() ? e.nome : atual.relativo + "/" + e.nome;
+
+            if (regras->ignorar(relativo, eDiretoria)) {
+                if (eDiretoria) {
+                    // Podada antes de ser aberta: nada lá dentro é lido nem contado.
+                    contas->diretoriasIgnoradas++;
+                } else {
+                    contas->ficheirosIgnorados++;
+                    if (e.tipo == CacheVarrimento::Ficheiro) contas->bytesIgnorados += e.tamanho;
+                }
+                continue;
+            }
+
+            if (eDiretoria) {
+                contas->diretorias++;
+                auto sub = std::make_shared<Directory>(e.nome, atual.dir);
+                atual.dir->addSubdirectoryPtr(sub);
+                // As ligações simbólicas para diretorias ficam como diretorias vazias.
+                if (e.tipo == CacheVarrimento::Diretoria)
+                    filhas.push_back({ sub.get(), std::move(relativo), atual.caminho / e.nome });
+                continue;
+            }
+            if (e.tipo != CacheVarrimento::Ficheiro) continue;
+            contas->ficheiros++;
+            if (prog) prog->bytes.fetch_add(e.tamanho, std::memory_order_relaxed);
+
+            // Ligações físicas ao mesmo inode partilham os dados do primeiro caminho lido.
+            std::shared_ptr<const File::Dados> dados;
+            std::shared_ptr<const File::Dados>* visto = nullptr;
+            if (e.ligacoes > 1) {
+                visto = &porInode[Inode{ e.dispositivo, e.inode }];
+                if (*visto) {
+                    contas->ligacoesRepetidas++;
+                    contas->bytesRepetidos += e.tamanho;
+                    dados = *visto;
+                }
+            }
+            if (!dados) {
+                dados = std::make_shared<const File::Dados>(File::Dados{ static_cast<size_t>(e.tamanho),
+                    dataDoDisco(static_cast<std::time_t>(e.mtime)), e.dispositivo, e.inode, e.ligacoes });
+                if (visto) *visto = dados;
+            }
+            atual.dir->addFilePtr(std::make_shared<File>(e.nome, std::move(dados)));
+        }
+        // Em profundidade, pela ordem da listagem (como o recursive_directory_iterator).
+        for (auto it = filhas.rbegin(); it != filhas.rend(); ++it) pilha.push_back(std::move(*it));
+    }
+
+    return root;
+}
+
 int SistemaFicheiros::ContarFicheiros() const {
+    perfil::Medida medida("SistemaFicheiros::ContarFicheiros");
+    if (const FlatTree* ft = frozenView()) return static_cast<int>(ft->countFiles());
     return root ? root->getTotalFiles() : 0;
 }
 
 int SistemaFicheiros::ContarDirectorios() const {
+    perfil::Medida medida("SistemaFicheiros::ContarDirectorios");
+    if (const FlatTree* ft = frozenView()) return static_cast<int>(ft->countDirectories());
     return root ? root->getTotalDirectories() : 0;
 }
 
 int SistemaFicheiros::Memoria() const {
+    perfil::Medida medida("SistemaFicheiros::Memoria");
+    if (const FlatTree* ft = frozenView()) return static_cast<int>(ft->totalSize());
     return root ? static_cast<int>(root->getTotalSize()) : 0;
 }
 
+uint64_t SistemaFicheiros::TamanhoTotal(const Directory* dir) const {
+    perfil::Medida medida("SistemaFicheiros::TamanhoTotal");
+    if (!dir) return 0;
+    if (const FlatTree* ft = frozenView()) {
+        uint32_t i = ft->indexOf(dir);
+        if (i != FlatTree::npos) return ft->totalSize(i);
+    }
+    return dir->getTotalSize();
+}
+
+// A cópia congelada não guarda inodes: percorre sempre a árvore de ponteiros.
+SistemaFicheiros::BytesInodes SistemaFicheiros::ContarBytesUnicos(const Directory* dir) const {
+    perfil::Medida medida("SistemaFicheiros::ContarBytesUnicos");
+    BytesInodes b;
+    if (!dir) return b;
+    // Só os inodes que podem repetir-se (mais de uma ligação ou dados partilhados) passam pelo conjunto.
+    std::unordered_set<Inode, HashInode> vistos;
+    std::queue<const Directory*> q; q.push(dir);
+    while (!q.empty()) {
+        const Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
+        for (const auto &f : cur->getFiles()) {
+            const auto& d = f->getDados();
+            b.aparentes += d->size;
+            if (!f->temInode()) {
+                b.semInode++;
+                b.unicos += d->size;
+            } else if ((d->ligacoes <= 1 && d.use_count() == 1) || vistos.insert(Inode{ d->dispositivo, d->inode }).second) {
+                b.unicos += d->size;
+            } else {
+                b.ligacoesRepetidas++;
+            }
+        }
+        for (const auto &s : cur->getSubdirectories()) q.push(s.get());
+    }
+    return b;
+}
+
+// Sobre a cópia congelada as estatísticas são reduções vetorizadas nas colunas de
+// ficheiros; sem ela, percorremos a árvore de ponteiros.
+std::vector<uint64_t> SistemaFicheiros::HistogramaTamanhos(const std::vector<uint64_t>& limites) const {
+    perfil::Medida medida("SistemaFicheiros::HistogramaTamanhos");
+    std::vector<uint64_t> counts(limites.size() + 1, 0);
+    if (!root) return counts;
+    if (const FlatTree* ft = frozenView()) {
+        kernels::histogram(ft->fileSizes.data(), ft->fileSizes.size(), limites.data(), limites.size(), counts.data());
+        return counts;
+    }
+    std::queue<const Directory*> q; q.push(root.get());
+    while (!q.empty()) {
+        const Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
+        for (const auto& f : cur->getFiles()) {
+            size_t k = std::upper_bound(limites.begin(), limites.end(), f->getSize()) - limites.begin();
+            ++counts[k];
+        }
+        for (const auto& s : cur->getSubdirectories()) q.push(s.get());
+    }
+    return counts;
+}
+
+size_t SistemaFicheiros::ContarPorData(int32_t de, int32_t ate) const {
+    perfil::Medida medida("SistemaFicheiros::ContarPorData");
+    if (!root) return 0;
+    if (const FlatTree* ft = frozenView()) {
+        return kernels::rangeCount(ft->fileDates.data(), ft->fileDates.size(), de, ate);
+    }
+    size_t total = 0;
+    std::queue<const Directory*> q; q.push(root.get());
+    while (!q.empty()) {
+        const Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
+        for (const auto& f : cur->getFiles()) {
+            int32_t d = FlatTree::parseDate(f->getDate());
+            if (d >= de && d <= ate) ++total;
+        }
+        for (const auto& s : cur->getSubdirectories()) q.push(s.get());
+    }
+    return total;
+}
+
+Ocupacao::Relatorio SistemaFicheiros::InfoMemoria() const {
+    perfil::Medida medida("SistemaFicheiros::InfoMemoria");
+    Ocupacao::Relatorio r;
+    if (root) r = Ocupacao::medir(*root);
+    r.indices = resolver.memoryBytes() + snapshots.memoryBytes() + Ocupacao::bytesTexto(pathBuf);
+    return r;
+}
+
+// O conteúdo da árvore não muda: a cópia congelada atual continua válida e
+// só as versões antigas (sem leitores) e as caches reconstruíveis são libertadas.
+Ocupacao::Compactacao SistemaFicheiros::Compactar() {
+    perfil::Medida medida("SistemaFicheiros::Compactar");
+    Ocupacao::Compactacao c;
+    if (root) c = Ocupacao::compactar(*root);
+    size_t antes = resolver.memoryBytes() + snapshots.memoryBytes() + Ocupacao::bytesTexto(pathBuf);
+    resolver.shrinkToFit();
+    snapshots.reclaim();
+    pathBuf.shrink_to_fit();
+    size_t depois = resolver.memoryBytes() + snapshots.memoryBytes() + Ocupacao::bytesTexto(pathBuf);
+    if (depois < antes) c.bytes += antes - depois;
+    Ocupacao::devolverAoSistema();
+    return c;
+}
+
+// Escolhe, entre as diretorias da cópia congelada, a melhor segundo better(a, b);
+// em empate fica a primeira em largura, tal como nas versões com BFS.
+template <typename Better>
+static uint32_t bestFlatDirectory(const FlatTree& ft, Better better) {
+    uint32_t best = 0;
+    for (uint32_t j = 1; j < ft.size(); ++j) {
+        if (ft.kind[j] != FlatTree::DirNode) continue;
+        if (better(j, best) || (!better(best, j) && ft.depth[j] < ft.depth[best])) best = j;
+    }
+    return best;
+}
+
 // Percorre em largura e escolhe a diretoria com mais elementos (dirs+ficheiros).
 std::optional<std::string> SistemaFicheiros::DirectoriaMaisElementos() const {
+    perfil::Medida medida("SistemaFicheiros::DirectoriaMaisElementos");
     if (!root) return std::nullopt;
+    if (const FlatTree* ft = frozenView()) {
+        auto cnt = ft->elementCounts();
+        uint32_t best = bestFlatDirectory(*ft, [&](uint32_t a, uint32_t b) { return cnt[a] > cnt[b]; });
+        ft->renderPath(best, pathBuf, separator);
+        return pathBuf;
+    }
 
-    std::shared_ptr<Directory> maxDir = root;
+    const Directory* maxDir = root.get();
     int maxElements = root->getElementCount();
-    std::queue<std::shared_ptr<Directory>> queue;
-    queue.push(root);
+    std::queue<const Directory*> queue;
+    queue.push(root.get());
 
     while (!queue.empty()) {
-        auto current = queue.front(); queue.pop();
+        const Directory* current = queue.front(); queue.pop();
+        perfil::nos();
         int currentElements = current->getElementCount();
         if (currentElements > maxElements) {
             maxElements = currentElements;
             maxDir = current;
         }
         for (const auto& subdir : current->getSubdirectories()) {
-            queue.push(subdir);
+            queue.push(subdir.get());
         }
     }
-    return getAbsolutePath(maxDir.get());
+    return getAbsolutePath(maxDir);
 }
 
 // Percorre em largura e escolhe a diretoria com menos elementos.
 std::optional<std::string> SistemaFicheiros::DirectoriaMenosElementos() const {
+    perfil::Medida medida("SistemaFicheiros::DirectoriaMenosElementos");
     if (!root) return std::nullopt;
+    if (const FlatTree* ft = frozenView()) {
+        auto cnt = ft->elementCounts();
+        uint32_t best = bestFlatDirectory(*ft, [&](uint32_t a, uint32_t b) { return cnt[a] < cnt[b]; });
+        ft->renderPath(best, pathBuf, separator);
+        return pathBuf;
+    }
 
-    std::shared_ptr<Directory> minDir = root;
+    const Directory* minDir = root.get();
     int minElements = root->getElementCount();
-    std::queue<std::shared_ptr<Directory>> queue;
-    queue.push(root);
+    std::queue<const Directory*> queue;
+    queue.push(root.get());
 
     while (!queue.empty()) {
-        auto current = queue.front(); queue.pop();
+        const Directory* current = queue.front(); queue.pop();
+        perfil::nos();
         int currentElements = current->getElementCount();
         if (currentElements < minElements) {
             minElements = currentElements;
             minDir = current;
         }
         for (const auto& subdir : current->getSubdirectories()) {
-            queue.push(subdir);
+            queue.push(subdir.get());
         }
     }
-    return getAbsolutePath(minDir.get());
+    return getAbsolutePath(minDir);
 }
 
 // Encontra a diretoria que acumula mais espaço total (tamanho recursivo).
 std::optional<std::string> SistemaFicheiros::DirectoriaMaisEspaco() const {
+    perfil::Medida medida("SistemaFicheiros::DirectoriaMaisEspaco");
     if (!root) return std::nullopt;
+    if (const FlatTree* ft = frozenView()) {
+        // Uma só passagem calcula o tamanho de todas as subárvores.
+        auto acc = ft->directorySizes();
+        uint32_t best = bestFlatDirectory(*ft, [&](uint32_t a, uint32_t b) { return acc[a] > acc[b]; });
+        ft->renderPath(best, pathBuf, separator);
+        return pathBuf + " (" + std::to_string(acc[best]) + " bytes)";
+    }
 
-    std::shared_ptr<Directory> bestDir = root;
+    const Directory* bestDir = root.get();
     size_t bestSize = root->getTotalSize();
-    std::queue<std::shared_ptr<Directory>> q;
-    q.push(root);
+    std::queue<const Directory*> q;
+    q.push(root.get());
 
     while (!q.empty()) {
-        auto current = q.front(); q.pop();
+        const Directory* current = q.front(); q.pop();
         size_t curSize = current->getTotalSize();
         if (curSize > bestSize) {
             bestSize = curSize;
             bestDir = current;
         }
         for (const auto& subdir : current->getSubdirectories()) {
-            q.push(subdir);
+            q.push(subdir.get());
         }
     }
-    return getAbsolutePath(bestDir.get()) + " (" + std::to_string(bestSize) + " bytes)";
+    return getAbsolutePath(bestDir) + " (" + std::to_string(bestSize) + " bytes)";
 }
 
 // Constrói o caminho absoluto (da raiz até ao nó) a partir dos ponteiros parent.
-std::string SistemaFicheiros::getAbsolutePath(Directory* dir) const {
+std::string SistemaFicheiros::getAbsolutePath(const Directory* dir) const {
     if (!dir) return std::string();
-    std::vector<std::string> parts;
-    Directory* cur = dir;
-    while (cur) {
-        parts.push_back(cur->getName());
-        cur = cur->getParent();
-    }
-    fs::path p;
-    for (auto it = parts.rbegin(); it != parts.rend(); ++it) p /= *it;
-    return p.string();
+    return RenderPath({dir, nullptr});
 }
 
 // Procura o ficheiro maior em toda a árvore e devolve caminho + tamanho.
 std::optional<std::string> SistemaFicheiros::FicheiroMaior() const {
+    perfil::Medida medida("SistemaFicheiros::FicheiroMaior");
     if (!root) return std::nullopt;
+    if (const FlatTree* ft = frozenView()) {
+        uint32_t best = ft->largestFile();
+        if (best == FlatTree::npos) return std::nullopt;
+        ft->renderPath(best, pathBuf, separator);
+        return pathBuf + " (" + std::to_string(ft->sizes[best]) + " bytes)";
+    }
 
-    std::string maxPath;
-    size_t maxSize = 0;
-    bool found = false;
-
-    std::queue<std::pair<std::shared_ptr<Directory>, fs::path>> queue;
-    queue.push({root, fs::path(root->getName())});
+    // Só guardamos referências durante a pesquisa; o caminho é construído no fim.
+    NodeRef best;
+    std::queue<const Directory*> queue;
+    queue.push(root.get());
 
     while (!queue.empty()) {
-        auto [current, currentPath] = queue.front(); queue.pop();
+        const Directory* current = queue.front(); queue.pop();
+        perfil::nos(1 + current->getFiles().size());
         for (const auto& file : current->getFiles()) {
-            size_t sz = file->getSize();
-            fs::path p = currentPath / file->getName();
-            if (!found || sz > maxSize) {
-                found = true;
-                maxSize = sz;
-                maxPath = p.string();
+            if (!best.file || file->getSize() > best.file->getSize()) {
+                best = {current, file.get()};
             }
         }
         for (const auto& subdir : current->getSubdirectories()) {
-            queue.push({subdir, currentPath / subdir->getName()});
+            queue.push(subdir.get());
         }
     }
 
-    if (!found) return std::nullopt;
-    return maxPath + " (" + std::to_string(maxSize) + " bytes)";
+    if (!best.file) return std::nullopt;
+    return RenderPath(best) + " (" + std::to_string(best.file->getSize()) + " bytes)";
 }
 
 // ----------------------------------------
 // GetRoot e SetRoot
 void SistemaFicheiros::SetRoot(std::shared_ptr<Directory> r) {
     root = r;
+    resolver.setRoot(root);
+}
+
+void SistemaFicheiros::SetOrigemDisco(const Directory* raiz, const std::string &caminho) {
+    raizDisco = raiz;
+    std::error_code ec;
+    fs::path abs = fs::absolute(caminho, ec);
+    caminhoDisco = ec ? caminho : abs.lexically_normal().string();
+    // lexically_normal mantém a barra final de "pasta/": retira-a (exceto na raiz do disco).
+    while (caminhoDisco.size() > 1 && (caminhoDisco.back() == '/' || caminhoDisco.back() == '\\'))
+        caminhoDisco.pop_back();
+}
+
+std::string SistemaFicheiros::GetOrigemDisco() const {
+    return (root && root.get() == raizDisco) ? caminhoDisco : std::string();
+}
+
+bool SistemaFicheiros::espelhoAtivo() const {
+    return espelho.modo() != Espelho::Modo::Desligado && root && root.get() == raizDisco;
+}
+
+// Caminho de um elemento dentro de uma pasta do disco.
+static std::string naPasta(const std::string& pasta, const std::string& nome) {
+    return (fs::path(pasta) / nome).string();
+}
+
+// Em modo simular só se regista o plano: nem o disco nem a árvore mudam.
+bool SistemaFicheiros::soSimular(std::vector<Espelho::Operacao> &plano) {
+    if (!espelhoAtivo() || espelho.modo() != Espelho::Modo::Simular) return false;
+    espelho.processar(std::move(plano));
+    return true;
+}
+
+std::string SistemaFicheiros::caminhoNoDisco(const Directory* dir) const {
+    std::string rel;
+    Directory::renderPath({dir, nullptr}, rel, static_cast<char>(fs::path::preferred_separator), root.get());
+    return rel.empty() ? caminhoDisco : (fs::path(caminhoDisco) / rel).string();
 }
 
 std::shared_ptr<Directory> SistemaFicheiros::GetRoot() const {
     return root;
 }
 
+std::shared_ptr<Directory> SistemaFicheiros::resolvePath(std::string_view path) const {
+    if (!root) return nullptr;
+    return resolver.resolve(path);
+}
+
+void SistemaFicheiros::SetSeparador(char sep) {
+    separator = sep;
+}
+
+char SistemaFicheiros::GetSeparador() const {
+    return separator;
+}
+
+// Materializa o caminho no buffer reutilizável; só a cópia devolvida aloca.
+std::string SistemaFicheiros::RenderPath(const NodeRef& ref, const Directory* base) const {
+    Directory::renderPath(ref, pathBuf, separator, base);
+    return pathBuf;
+}
+
 // ----------------------------------------
 // Métodos auxiliares para listar todos os diretórios/ficheiros de forma recursiva.
 void SistemaFicheiros::getAllDirectories(std::shared_ptr<Directory> dir,
@@ -275,39 +599,62 @@ void SistemaFicheiros::getAllFiles(std::shared_ptr<Directory> dir, std::list<std
     }
 }
 
+// ----------------------------------------
+// Criar diretórios
+void SistemaFicheiros::CriarDirectoria(Directory &pai, const std::string &nome) {
+    pai.addSubdirectory(nome);
+    resolver.subtreeAttached(pai.getSubdirectories().back());
+}
+
 // ----------------------------------------
 // Remover ficheiros ou diretórios
 bool SistemaFicheiros::RemoverAll(const std::string &s, const std::string &tipo) {
+    perfil::Medida medida("SistemaFicheiros::RemoverAll");
     if (!root) return false;
-    bool removed = false;
-
-    std::function<void(std::shared_ptr<Directory>)> dfs = [&](std::shared_ptr<Directory> dir) {
-        if (!dir) return;
-
-        if (tipo != "DIR") {
-            while (dir->findFile(s)) {
-                dir->removeFile(s);
-                removed = true;
-            }
+    // Junta as remoções num lote: cada diretoria é compactada uma só vez.
+    Lote lote;
+    bool dirs = (tipo == "DIR");
+
+    std::function<void(Directory&)> dfs = [&](Directory& dir) {
+        perfil::nos(1 + dir.getFiles().size());
+        if (!dirs) {
+            for (const auto& f : dir.getFiles())
+                if (f->getName() == s) lote.removerFicheiro(dir, f.get());
         }
-
-        auto subs = dir->getSubdirectories();
-        for (const auto& sub : subs) {
-            if (tipo == "DIR" && sub->getName() == s) {
-                dir->removeSubdirectory(s);
-                removed = true;
-            } else {
-                dfs(sub);
-            }
+        for (const auto& sub : dir.getSubdirectories()) {
+            if (dirs && sub->getName() == s) lote.removerDiretoria(dir, sub.get());
+            else dfs(*sub);
         }
     };
 
-    dfs(root);
-    return removed;
+    dfs(*root);
+    return lote.aplicar(&resolver) > 0;
+}
+
+// Para as diretorias bastam as filhas da raiz (as subárvores saem com elas):
+// um lote não pode ter uma diretoria e um descendente dela.
+bool SistemaFicheiros::RemoverTodos(const std::string &tipo) {
+    perfil::Medida medida("SistemaFicheiros::RemoverTodos");
+    if (!root) return false;
+    Lote lote;
+    if (tipo == "DIR") {
+        for (const auto& sub : root->getSubdirectories()) lote.removerDiretoria(*root, sub.get());
+    } else {
+        std::vector<Directory*> pilha{root.get()};
+        while (!pilha.empty()) {
+            Directory* d = pilha.back();
+            pilha.pop_back();
+            perfil::nos(1 + d->getFiles().size());
+            for (const auto& f : d->getFiles()) lote.removerFicheiro(*d, f.get());
+            for (const auto& sub : d->getSubdirectories()) pilha.push_back(sub.get());
+        }
+    }
+    return lote.aplicar(&resolver) > 0;
 }
 
 // Mover ficheiro
 bool SistemaFicheiros::MoveFicheiro(const std::string &Fich, const std::string &DirNova) {
+    perfil::Medida medida("SistemaFicheiros::MoveFicheiro");
     if (!root) return false;
 
     std::queue<std::shared_ptr<Directory>> q;
@@ -317,6 +664,7 @@ bool SistemaFicheiros::MoveFicheiro(const std::string &Fich, const std::string &
 
     while (!q.empty() && !filePtr) {
         auto cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
         for (const auto &f : cur->getFiles()) {
             if (f->getName() == Fich) {
                 sourceDir = cur;
@@ -329,234 +677,162 @@ bool SistemaFicheiros::MoveFicheiro(const std::string &Fich, const std::string &
 
     if (!filePtr || !sourceDir) return false;
 
-    std::shared_ptr<Directory> destDir = nullptr;
-    bool isPath = (DirNova.find('\\') != std::string::npos) || (DirNova.find('/') != std::string::npos);
-    if (isPath) {
-        std::vector<std::string> parts;
-        std::string token;
-        for (char c : DirNova) {
-            if (c == '\\' || c == '/') {
-                if (!token.empty()) { parts.push_back(token); token.clear(); }
-            } else token.push_back(c);
-        }
-        if (!token.empty()) parts.push_back(token);
-
-        std::shared_ptr<Directory> cur = root;
-        for (const auto &p : parts) {
-            auto next = cur->findSubdirectory(p);
-            if (!next) { cur = nullptr; break; }
-            cur = next;
-        }
-        destDir = cur;
-    } else {
-        std::queue<std::shared_ptr<Directory>> q2;
-        q2.push(root);
-        while (!q2.empty() && !destDir) {
-            auto cur = q2.front(); q2.pop();
-            if (cur->getName() == DirNova) {
-                destDir = cur;
-                break;
-            }
-            for (const auto &sub : cur->getSubdirectories()) q2.push(sub);
-        }
-    }
-
+    std::shared_ptr<Directory> destDir = resolvePath(DirNova);
     if (!destDir) return false;
 
     if (sourceDir.get() == destDir.get()) return false;
     if (destDir->findFile(filePtr->getName())) return false;
 
-    destDir->addFile(filePtr->getName(), filePtr->getSize());
-    auto added = destDir->findFile(filePtr->getName());
-    if (added) added->setDate(filePtr->getDate());
-
-    sourceDir->removeFile(filePtr->getName());
+    std::vector<Espelho::Operacao> plano;
+    if (espelhoAtivo()) {
+        plano.push_back({Espelho::Operacao::Mover, naPasta(caminhoNoDisco(sourceDir.get()), filePtr->getName()),
+                         naPasta(caminhoNoDisco(destDir.get()), filePtr->getName()), filePtr->getSize()});
+    }
 
+    if (soSimular(plano)) return true;
+    Lote lote;
+    lote.moverFicheiro(*sourceDir, filePtr.get(), *destDir);
+    if (lote.aplicar(&resolver) == 0) return false;
+    if (!plano.empty()) espelho.processar(std::move(plano));
     return true;
 }
 
 
 // Mover uma diretoria (e a sua subárvore) para outra diretoria.
 bool SistemaFicheiros::MoverDirectoria(const std::string &DirOld, const std::string &DirNew) {
+    perfil::Medida medida("SistemaFicheiros::MoverDirectoria");
     if (!root) return false;
 
-    std::shared_ptr<Directory> found = nullptr;
-    std::shared_ptr<Directory> parentOfFound = nullptr;
-    std::queue<std::pair<std::shared_ptr<Directory>, std::shared_ptr<Directory>>> q;
-    q.push({root, nullptr});
-    while (!q.empty() && !found) {
-        auto [cur, parent] = q.front(); q.pop();
-        if (cur->getName() == DirOld) {
-            found = cur; parentOfFound = parent; break;
-        }
-        for (const auto &sub : cur->getSubdirectories()) q.push({sub, cur});
-    }
+    std::shared_ptr<Directory> found = resolvePath(DirOld);
+    if (!found || !found->getParent()) return false;
+    Directory* parentOfFound = found->getParent();
 
-    if (!found || !parentOfFound) return false;
+    std::shared_ptr<Directory> dest = resolvePath(DirNew);
+    if (!dest) return false;
 
-    std::shared_ptr<Directory> dest = nullptr;
-    bool isPath = (DirNew.find('\\') != std::string::npos) || (DirNew.find('/') != std::string::npos);
-    if (isPath) {
-        std::vector<std::string> parts;
-        std::string token;
-        for (char c : DirNew) {
-            if (c == '\\' || c == '/') { if (!token.empty()) { parts.push_back(token); token.clear(); } }
-            else token.push_back(c);
-        }
-        if (!token.empty()) parts.push_back(token);
+    // Não pode ir para dentro de si própria (comparação dos intervalos de rótulos).
+    if (dest.get() == found.get() || dest->isSubdirectoryOf(found.get())) return false;
 
-        std::shared_ptr<Directory> cur = root;
-        for (const auto &p : parts) {
-            auto next = cur->findSubdirectory(p);
-            if (!next) { cur = nullptr; break; }
-            cur = next;
-        }
-        dest = cur;
-    } else {
-        std::queue<std::shared_ptr<Directory>> q2; q2.push(root);
-        while (!q2.empty() && !dest) {
-            auto cur = q2.front(); q2.pop();
-            if (cur->getName() == DirNew) { dest = cur; break; }
-            for (const auto &sub : cur->getSubdirectories()) q2.push(sub);
-        }
+    // Os caminhos no disco são calculados antes de a subárvore mudar de sítio.
+    // (mover para o mesmo pai não muda nada no disco)
+    std::vector<Espelho::Operacao> plano;
+    if (espelhoAtivo() && parentOfFound != dest.get()) {
+        plano.push_back({Espelho::Operacao::Mover, caminhoNoDisco(found.get()),
+                         naPasta(caminhoNoDisco(dest.get()), found->getName()), 0});
     }
 
-    if (!dest) return false;
+    if (soSimular(plano)) return true;
+    // O lote invalida também os caminhos antigos da subárvore.
+    Lote lote;
+    lote.moverDiretoria(*parentOfFound, found.get(), *dest);
+    if (lote.aplicar(&resolver) == 0) return false;
+    if (!plano.empty()) espelho.processar(std::move(plano));
+    return true;
+}
 
-    Directory* walker = dest.get();
-    while (walker) {
-        if (walker == found.get()) return false;
-        walker = walker->getParent();
-    }
+// Copiar uma diretoria (e a sua subárvore) para outra diretoria.
+bool SistemaFicheiros::CopiarDirectoria(const std::string &DirOrigem, const std::string &DirDestino) {
+    perfil::Medida medida("SistemaFicheiros::CopiarDirectoria");
+    if (!root) return false;
 
-    auto movedPtr = parentOfFound->takeSubdirectory(found->getName());
-    if (!movedPtr) return false;
+    std::shared_ptr<Directory> src = resolvePath(DirOrigem);
+    if (!src) return false;
+    std::shared_ptr<Directory> dst = resolvePath(DirDestino);
+    if (!dst) return false;
+    // Dois irmãos com o mesmo nome não seriam endereçáveis (nem caberiam no disco).
+    if (dst->findSubdirectory(src->getName())) return false;
+
+    // No disco: as diretorias em pré-ordem (pais antes dos filhos) e um ficheiro por cópia.
+    std::vector<Espelho::Operacao> plano;
+    if (espelhoAtivo()) {
+        std::function<void(const Directory&, const std::string&)> planear =
+            [&](const Directory& d, const std::string& alvo) {
+                std::string daqui = caminhoNoDisco(&d);
+                plano.push_back({Espelho::Operacao::CriarDiretoria, "", alvo, 0});
+                for (const auto &f : d.getFiles()) {
+                    plano.push_back({Espelho::Operacao::CopiarFicheiro, naPasta(daqui, f->getName()),
+                                     naPasta(alvo, f->getName()), f->getSize()});
+                }
+                for (const auto &sub : d.getSubdirectories()) planear(*sub, naPasta(alvo, sub->getName()));
+            };
+        planear(*src, naPasta(caminhoNoDisco(dst.get()), src->getName()));
+    }
 
-    dest->addSubdirectoryPtr(movedPtr);
+    if (soSimular(plano)) return true;
+    // A cópia é feita antes de ser ligada, por isso o destino pode estar dentro da origem.
+    Lote lote;
+    lote.adicionarDiretoria(*dst, src->clone());
+    if (lote.aplicar(&resolver) == 0) return false;
+    if (!plano.empty()) espelho.processar(std::move(plano));
     return true;
 }
 
 // ----------------------------------------
 // XML
 void SistemaFicheiros::Escrever_XML(const std::string &s) {
+    perfil::Medida medida("SistemaFicheiros::Escrever_XML");
     if (!root) return;
+    if (const FlatTree* ft = frozenView()) { EscreverXml(*ft, s); return; }
+    EscritorXml().escrever(*root, s);
+}
 
-    auto escapeXml = [](const std::string &in) {
-        std::string out; out.reserve(in.size());
-        for (char c : in) {
-            switch (c) {
-                case '&': out += "&amp;"; break;
-                case '<': out += "&lt;"; break;
-                case '>': out += "&gt;"; break;
-                case '"': out += "&quot;"; break;
-                case '\'': out += "&apos;"; break;
-                default: out += c; break;
-            }
-        }
-        return out;
-    };
-
-    std::ofstream ofs(s);
-    if (!ofs.is_open()) return;
-
-    ofs << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-
-    std::function<void(const std::shared_ptr<Directory>&, int)> writeDir;
-    writeDir = [&](const std::shared_ptr<Directory> &dir, int indent) {
-        std::string ind(indent, ' ');
-        ofs << ind << "<Directory name=\"" << escapeXml(dir->getName()) << "\">\n";
-
-        for (const auto &f : dir->getFiles()) {
-            ofs << ind << "  <File name=\"" << escapeXml(f->getName())
-                << "\" size=\"" << f->getSize()
-                << "\" date=\"" << escapeXml(f->getDate())
-                << "\" />\n";
-        }
-
-        for (const auto &sub : dir->getSubdirectories()) {
-            writeDir(sub, indent + 2);
-        }
-
-        ofs << ind << "</Directory>\n";
-    };
-
-    writeDir(root, 0);
-    ofs.close();
+bool SistemaFicheiros::EscreverXml(const FlatTree &ft, const std::string &s, Progresso *prog) {
+    perfil::Medida medida("SistemaFicheiros::EscreverXml");
+    return EscritorXml().escrever(ft, s, prog);
 }
 
 bool SistemaFicheiros::Ler_XML(const std::string &s) {
+    perfil::Medida medida("SistemaFicheiros::Ler_XML");
+    std::shared_ptr<Directory> novo;
+    if (!LerArvoreXml(s, novo)) return false;
+    clearSystem();
+    root = novo;
+    resolver.setRoot(root);
+    return true;
+}
+
+bool SistemaFicheiros::LerArvoreXml(const std::string &s, std::shared_ptr<Directory> &raiz) {
+    perfil::Medida medida("SistemaFicheiros::LerArvoreXml");
+    raiz = nullptr;
     try {
         std::ifstream ifs(s);
         if (!ifs.is_open()) return false;
-
-        clearSystem();
-
-        auto unescapeXml = [](const std::string &in) {
-            std::string out; out.reserve(in.size());
-            size_t pos = 0;
-            while (pos < in.size()) {
-                if (in[pos] == '&') {
-                    if (in.substr(pos, 5) == "&amp;") { out += '&'; pos += 5; }
-                    else if (in.substr(pos, 4) == "&lt;") { out += '<'; pos += 4; }
-                    else if (in.substr(pos, 4) == "&gt;") { out += '>'; pos += 4; }
-                    else if (in.substr(pos, 6) == "&quot;") { out += '"'; pos += 6; }
-                    else if (in.substr(pos, 6) == "&apos;") { out += '\''; pos += 6; }
-                    else { out += in[pos++]; }
-                } else { out += in[pos++]; }
-            }
-            return out;
-        };
-
-        // Extrai o valor de um atributo na linha XML 
-        auto extractAttribute = [](const std::string &line, const std::string &attr) -> std::string {
-            std::string pattern = attr + "=\"";
-            size_t start = line.find(pattern);
-            if (start == std::string::npos) return "";
-            start += pattern.size();
-            size_t end = line.find("\"", start);
-            if (end == std::string::npos) return "";
-            return line.substr(start, end - start);
-        };
-
-        std::stack<std::shared_ptr<Directory>> stk;
+        LeitorXml leitor;
         std::string line;
         while (std::getline(ifs, line)) {
-            line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-            line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-            if (line.find("<Directory") != std::string::npos) {
-                std::string name = unescapeXml(extractAttribute(line, "name"));
-                auto dir = std::make_shared<Directory>(name);
-                if (stk.empty()) root = dir;
-                else stk.top()->addSubdirectoryPtr(dir);
-                stk.push(dir);
-            } else if (line.find("</Directory>") != std::string::npos) {
-                if (!stk.empty()) stk.pop();
-            } else if (line.find("<File") != std::string::npos) {
-                std::string name = unescapeXml(extractAttribute(line, "name"));
-                std::string sizeStr = extractAttribute(line, "size");
-                std::string dateStr = unescapeXml(extractAttribute(line, "date"));
-                size_t size = std::stoull(sizeStr);
-                if (!stk.empty()) {
-                    stk.top()->addFile(name, size);
-                    auto fptr = stk.top()->findFile(name);
-                    if (fptr) fptr->setDate(dateStr);
-                }
-            }
+            perfil::nos();
+            leitor.linha(line);
         }
-
-        ifs.close();
+        raiz = leitor.raiz();
         return true;
-    } catch (...) { return false; }
+    } catch (...) { raiz = nullptr; return false; }
+}
+
+bool SistemaFicheiros::Comparar(const std::string &a, const std::string &b, Diferencas::Resultado &res, std::string &erro) {
+    perfil::Medida medida("SistemaFicheiros::Comparar");
+    auto obter = [this](const std::string &s, std::shared_ptr<Directory> &raiz) {
+        if (s == ".") { raiz = root; return true; }
+        return LerArvoreXml(s, raiz);
+    };
+    std::shared_ptr<Directory> ra, rb;
+    if (!obter(a, ra)) { erro = a; return false; }
+    if (!obter(b, rb)) { erro = b; return false; }
+    // Uma versão vazia compara-se como uma raiz sem filhos.
+    Directory vazia("");
+    res = Diferencas::comparar(ra ? *ra : vazia, rb ? *rb : vazia, separator);
+    return true;
 }
 
 // Obtém a data guardada para um ficheiro pelo seu nome.
 std::optional<std::string> SistemaFicheiros::DataFicheiro(const std::string &Fich) const {
+    perfil::Medida medida("SistemaFicheiros::DataFicheiro");
     if (!root) return std::nullopt;
     std::queue<std::shared_ptr<Directory>> q;
     q.push(root);
 
     while (!q.empty()) {
         auto cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
         for (const auto &f : cur->getFiles()) {
             if (f->getName() == Fich) return f->getDate();
         }
@@ -568,66 +844,85 @@ std::optional<std::string> SistemaFicheiros::DataFicheiro(const std::string &Fic
 
 // Pesquisa por diretoria (Tipo=1) ou ficheiro (Tipo=0) e devolve caminho.
 std::optional<std::string> SistemaFicheiros::Search(const std::string &s, int Tipo) const {
+    perfil::Medida medida("SistemaFicheiros::Search");
     if (!root) return std::nullopt;
 
     // Tipo: 1 = diretoria, 0 = ficheiro
-    if (Tipo == 1) {
-        std::queue<std::shared_ptr<Directory>> q;
-        q.push(root);
-        while (!q.empty()) {
-            auto cur = q.front(); q.pop();
-            if (cur->getName() == s) {
-                return getAbsolutePath(cur.get());
-            }
-            for (const auto &sub : cur->getSubdirectories()) q.push(sub);
-        }
-        return std::nullopt;
-    } else {
-
-        std::queue<std::pair<std::shared_ptr<Directory>, fs::path>> q;
-        q.push({root, fs::path(root->getName())});
-        while (!q.empty()) {
-            auto [cur, curPath] = q.front(); q.pop();
+    if (const FlatTree* ft = frozenView()) {
+        uint32_t j = ft->findFirst(s, Tipo == 1 ? FlatTree::DirNode : FlatTree::FileNode);
+        if (j == FlatTree::npos) return std::nullopt;
+        ft->renderPath(j, pathBuf, separator);
+        return pathBuf;
+    }
+    std::queue<const Directory*> q;
+    q.push(root.get());
+    while (!q.empty()) {
+        const Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
+        if (Tipo == 1) {
+            if (cur->getName() == s) return RenderPath({cur, nullptr});
+        } else {
             for (const auto &file : cur->getFiles()) {
-                if (file->getName() == s) {
-                    fs::path p = curPath / file->getName();
-                    return p.string();
-                }
-            }
-            for (const auto &sub : cur->getSubdirectories()) {
-                q.push({sub, curPath / sub->getName()});
+                if (file->getName() == s) return RenderPath({cur, file.get()});
             }
         }
-        return std::nullopt;
+        for (const auto &sub : cur->getSubdirectories()) q.push(sub.get());
     }
+    return std::nullopt;
 }
 
 // ----------------------------------------
 // Tree
 void SistemaFicheiros::Tree(const std::string *fich) {
+    Tree(fich, std::cout);
+}
+
+void SistemaFicheiros::Tree(const std::string *fich, std::ostream &out) {
+    perfil::Medida medida("SistemaFicheiros::Tree");
     if (!root) return;
+    const FlatTree* ft = frozenView();
     if (!fich) {
-        root->generateTree(std::cout, "");
+        if (ft) ft->generateTree(out);
+        else root->generateTree(out, "");
         return;
     }
     std::ofstream ofs(*fich);
     if (!ofs.is_open()) return;
-    root->generateTree(ofs, "");
+    if (ft) ft->generateTree(ofs);
+    else root->generateTree(ofs, "");
     ofs.close();
 }
 
 // ----------------------------------------
 // Pesquisar todas as diretorias com nome <dir>
 void SistemaFicheiros::PesquisarAllDirectorias(std::list<std::string> &lres, const std::string &dir) {
+    perfil::Medida medida("SistemaFicheiros::PesquisarAllDirectorias");
     if (!root) return;
-    root->findAllDirectories(dir, lres, "");
+    if (const FlatTree* ft = frozenView()) {
+        std::vector<uint32_t> idx;
+        ft->findAll(dir, FlatTree::DirNode, idx);
+        for (uint32_t j : idx) { ft->renderPath(j, pathBuf, separator); lres.push_back(pathBuf); }
+        return;
+    }
+    std::vector<NodeRef> refs;
+    root->findAllDirectories(dir, refs);
+    for (const auto& r : refs) lres.push_back(RenderPath(r));
 }
 
 // ----------------------------------------
 // Pesquisar todos os ficheiros com nome <file>
 void SistemaFicheiros::PesquisarAllFicheiros(std::list<std::string> &lres, const std::string &file) {
+    perfil::Medida medida("SistemaFicheiros::PesquisarAllFicheiros");
     if (!root) return;
-    root->findAllFiles(file, lres, "");
+    if (const FlatTree* ft = frozenView()) {
+        std::vector<uint32_t> idx;
+        ft->findAll(file, FlatTree::FileNode, idx);
+        for (uint32_t j : idx) { ft->renderPath(j, pathBuf, separator); lres.push_back(pathBuf); }
+        return;
+    }
+    std::vector<NodeRef> refs;
+    root->findAllFiles(file, refs);
+    for (const auto& r : refs) lres.push_back(RenderPath(r));
 }
 
 // ----------------------------------------
@@ -639,114 +934,86 @@ static std::string toLower(const std::string &s) {
 }
 
 bool SistemaFicheiros::CopyBatch(const std::string &padrao, const std::string &DirOrigem, const std::string &DirDestino) {
+    perfil::Medida medida("SistemaFicheiros::CopyBatch");
     if (!root) return false;
-    // localizar a diretoria de origem
-    std::shared_ptr<Directory> src = nullptr;
-    bool isPath = (DirOrigem.find('\\') != std::string::npos) || (DirOrigem.find('/') != std::string::npos);
-    if (isPath) {
-        std::shared_ptr<Directory> cur = root;
-        std::string token;
-        for (size_t i=0;i<DirOrigem.size();++i) {
-            char c = DirOrigem[i];
-            if (c=='\\' || c=='/') { if (!token.empty()) { auto next = cur->findSubdirectory(token); if (!next) { cur = nullptr; break; } cur = next; token.clear(); } }
-            else token.push_back(c);
-        }
-        if (!token.empty() && cur) { auto next = cur->findSubdirectory(token); if (next) cur = next; else cur = nullptr; }
-        src = cur;
-    } else {
-        std::queue<std::shared_ptr<Directory>> q; q.push(root);
-        while (!q.empty() && !src) {
-            auto cur = q.front(); q.pop();
-            if (cur->getName() == DirOrigem) { src = cur; break; }
-            for (const auto &s : cur->getSubdirectories()) q.push(s);
-        }
-    }
+    // localizar as diretorias de origem e de destino (caminho ou nome simples)
+    std::shared_ptr<Directory> src = resolvePath(DirOrigem);
     if (!src) return false;
-
-    // localizar a diretoria de destino
-    std::shared_ptr<Directory> dst = nullptr;
-    isPath = (DirDestino.find('\\') != std::string::npos) || (DirDestino.find('/') != std::string::npos);
-    if (isPath) {
-        std::shared_ptr<Directory> cur = root;
-        std::string token;
-        for (size_t i=0;i<DirDestino.size();++i) {
-            char c = DirDestino[i];
-            if (c=='\\' || c=='/') { if (!token.empty()) { auto next = cur->findSubdirectory(token); if (!next) { cur = nullptr; break; } cur = next; token.clear(); } }
-            else token.push_back(c);
-        }
-        if (!token.empty() && cur) { auto next = cur->findSubdirectory(token); if (next) cur = next; else cur = nullptr; }
-        dst = cur;
-    } else {
-        std::queue<std::shared_ptr<Directory>> q; q.push(root);
-        while (!q.empty() && !dst) {
-            auto cur = q.front(); q.pop();
-            if (cur->getName() == DirDestino) { dst = cur; break; }
-            for (const auto &s : cur->getSubdirectories()) q.push(s);
-        }
-    }
+    std::shared_ptr<Directory> dst = resolvePath(DirDestino);
     if (!dst) return false;
 
-    // recolher todos os ficheiros da sub-árvore de origem
-    std::list<std::shared_ptr<File>> files;
-    std::function<void(std::shared_ptr<Directory>)> collect = [&](std::shared_ptr<Directory> d){
-        if (!d) return;
-        for (const auto &f : d->getFiles()) files.push_back(f);
-        for (const auto &s : d->getSubdirectories()) collect(s);
-    };
-    collect(src);
-
+    // Percorre a origem (ficheiros antes das subdiretorias) sem copiar listas; as
+    // cópias só entram no destino no fim, por isso não voltam a ser percorridas.
     std::string patternLow = toLower(padrao);
-    int copied = 0;
-    for (const auto &f : files) {
-        std::string name = f->getName();
-        if (toLower(name).find(patternLow) == std::string::npos) continue;
-
-        // garantir nome único no destino (adiciona sufixo _NNN quando necessário)
-        std::string base = name;
-        std::string ext;
-        size_t pos = name.find_last_of('.');
-        if (pos != std::string::npos) { base = name.substr(0,pos); ext = name.substr(pos); }
-
-        std::string destName = name;
-        int seq = 1;
-        while (dst->containsFile(destName)) {
-            char buf[64]; sprintf(buf, "_%03d", seq);
-            destName = base + buf + ext;
-            seq++;
+    Lote lote;
+
+    // Nomes já usados em toda a subárvore do destino (uma só passagem).
+    NomesUnicos nomes;
+    std::function<void(const Directory&)> reserve = [&](const Directory& d) {
+        perfil::nos(1 + d.getFiles().size());
+        for (const auto &f : d.getFiles()) nomes.reservar(f->getName());
+        for (const auto &sub : d.getSubdirectories()) reserve(*sub);
+    };
+    reserve(*dst);
+
+    std::vector<Espelho::Operacao> plano;
+    bool espelhar = espelhoAtivo();
+    std::string discoDst = espelhar ? caminhoNoDisco(dst.get()) : std::string();
+
+    std::function<void(const Directory&)> collect = [&](const Directory& d) {
+        perfil::nos(1 + d.getFiles().size());
+        std::string discoAqui;
+        for (const auto &f : d.getFiles()) {
+            const std::string &name = f->getName();
+            if (toLower(name).find(patternLow) == std::string::npos) continue;
+            // garantir nome único no destino (adiciona sufixo _NNN quando necessário)
+            std::string destName = nomes.atribuir(name);
+            if (espelhar) {
+                if (discoAqui.empty()) discoAqui = caminhoNoDisco(&d);
+                plano.push_back({Espelho::Operacao::CopiarFicheiro, naPasta(discoAqui, name),
+                                 naPasta(discoDst, destName), f->getSize()});
+            }
+            lote.adicionarCopia(*dst, *f, destName);
         }
+        for (const auto &sub : d.getSubdirectories()) collect(*sub);
+    };
+    collect(*src);
 
-        dst->addFile(destName, f->getSize());
-        auto added = dst->findFile(destName);
-        if (added) added->setDate(f->getDate());
-        copied++;
-    }
-
-    return copied > 0;
+    if (lote.vazio()) return false;
+    if (soSimular(plano)) return true;
+    if (lote.aplicar(&resolver) == 0) return false;
+    if (!plano.empty()) espelho.processar(std::move(plano));
+    return true;
 }
 
 // ----------------------------------------
 // Renomear ficheiros
 void SistemaFicheiros::RenomearFicheiros(const std::string &fich_old, const std::string &fich_new) {
+    perfil::Medida medida("SistemaFicheiros::RenomearFicheiros");
     if (!root) return;
-    std::queue<std::shared_ptr<Directory>> q; q.push(root);
+    Lote lote;
+    std::queue<Directory*> q; q.push(root.get());
     while (!q.empty()) {
-        auto cur = q.front(); q.pop();
-        auto files = cur->getFiles();
-        for (const auto &f : files) {
-            if (f->getName() == fich_old) f->setName(fich_new);
+        Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
+        for (const auto &f : cur->getFiles()) {
+            if (f->getName() == fich_old) lote.renomearFicheiro(*cur, f.get(), fich_new);
         }
-        for (const auto &s : cur->getSubdirectories()) q.push(s);
+        for (const auto &s : cur->getSubdirectories()) q.push(s.get());
     }
+    lote.aplicar(&resolver);
 }
 
 // ----------------------------------------
 // Duplicados
 bool SistemaFicheiros::FicheiroDuplicados() const {
+    perfil::Medida medida("SistemaFicheiros::FicheiroDuplicados");
     if (!root) return false;
     std::map<std::string,int> count;
     std::queue<std::shared_ptr<Directory>> q; q.push(root);
     while (!q.empty()) {
         auto cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
         for (const auto &f : cur->getFiles()) count[f->getName()]++;
         for (const auto &s : cur->getSubdirectories()) q.push(s);
     }
@@ -755,28 +1022,112 @@ bool SistemaFicheiros::FicheiroDuplicados() const {
 }
 
 std::vector<std::string> SistemaFicheiros::GetFicheirosDuplicados() const {
+    perfil::Medida medida("SistemaFicheiros::GetFicheirosDuplicados");
     std::vector<std::string> out;
     if (!root) return out;
-    std::map<std::string, std::vector<std::string>> mapPaths;
-    std::queue<std::shared_ptr<Directory>> q; q.push(root);
+    if (const FlatTree* ft = frozenView()) return Duplicados(*ft, separator);
+    // Agrupa referências pelo nome (vista sobre o nome guardado no ficheiro, sem cópias);
+    // os caminhos só são construídos para os grupos com mais de um ficheiro.
+    std::map<std::string_view, std::vector<NodeRef>> groups;
+    std::queue<const Directory*> q; q.push(root.get());
     while (!q.empty()) {
-        auto cur = q.front(); q.pop();
-        std::string dirPath = getAbsolutePath(cur.get());
+        const Directory* cur = q.front(); q.pop();
+        perfil::nos(1 + cur->getFiles().size());
         for (const auto &f : cur->getFiles()) {
-            mapPaths[f->getName()].push_back(dirPath + "\\" + f->getName());
+            groups[f->getName()].push_back({cur, f.get()});
         }
-        for (const auto &s : cur->getSubdirectories()) q.push(s);
+        for (const auto &s : cur->getSubdirectories()) q.push(s.get());
     }
-    for (const auto &p : mapPaths) {
+    std::string line;
+    for (const auto &p : groups) {
         if (p.second.size() > 1) {
-            std::ostringstream oss;
-            oss << p.first << ": ";
+            line.assign(p.first.data(), p.first.size());
+            line += ": ";
             for (size_t i=0;i<p.second.size();++i) {
-                if (i) oss << ", ";
-                oss << p.second[i];
+                if (i) line += ", ";
+                Directory::renderPath(p.second[i], pathBuf, separator);
+                line += pathBuf;
             }
-            out.push_back(oss.str());
+            out.push_back(line);
         }
     }
     return out;
 }
+
+// Leitura só sobre a versão fixada: não toca na árvore de ponteiros nem em membros.
+std::vector<std::string> SistemaFicheiros::Duplicados(const FlatTree &ft, char sep, Progresso *prog) {
+    perfil::Medida medida("SistemaFicheiros::Duplicados");
+    std::vector<std::string> out;
+    std::string buf;
+    // Conta ocorrências por handle de nome e ordena só os ficheiros repetidos
+    // (nome, depois ordem de BFS: profundidade e índice DFS).
+    std::vector<uint32_t> count;
+    for (uint32_t j = 0; j < ft.size(); ++j) {
+        if (prog && (j & 4095) == 0) {
+            if (prog->cancelado()) return {};
+            prog->entradas.store(j, std::memory_order_relaxed);
+        }
+        if (ft.kind[j] != FlatTree::FileNode) continue;
+        if (ft.nameId[j] >= count.size()) count.resize(ft.nameId[j] + 1, 0);
+        ++count[ft.nameId[j]];
+    }
+    perfil::nos(ft.size());
+    std::vector<uint32_t> dups;
+    for (uint32_t j = 0; j < ft.size(); ++j) {
+        if (ft.kind[j] == FlatTree::FileNode && count[ft.nameId[j]] > 1) dups.push_back(j);
+    }
+    std::sort(dups.begin(), dups.end(), [&ft](uint32_t a, uint32_t b) {
+        if (ft.nameId[a] != ft.nameId[b]) return ft.name(ft.nameId[a]) < ft.name(ft.nameId[b]);
+        if (ft.depth[a] != ft.depth[b]) return ft.depth[a] < ft.depth[b];
+        return a < b;
+    });
+    std::string line;
+    for (size_t i = 0; i < dups.size(); ++i) {
+        bool first = (i == 0 || ft.nameId[dups[i]] != ft.nameId[dups[i - 1]]);
+        if (first) {
+            if (!line.empty()) out.push_back(line);
+            line = ft.name(ft.nameId[dups[i]]) + ": ";
+        } else {
+            line += ", ";
+        }
+        ft.renderPath(dups[i], buf, sep);
+        line += buf;
+    }
+    if (!line.empty()) out.push_back(line);
+    return out;
+}
+
+// Mesma seleção e mesmos nomes que CopyBatch: os ficheiros da origem em ordem DFS
+// (ficheiros antes das subdiretorias) e sufixos _NNN contra toda a subárvore do destino.
+std::vector<SistemaFicheiros::CopiaPlaneada> SistemaFicheiros::PlanearCopyBatch(
+        const FlatTree &ft, uint32_t origem, uint32_t destino, const std::string &padrao, Progresso *prog) {
+    perfil::Medida medida("SistemaFicheiros::PlanearCopyBatch");
+    std::vector<CopiaPlaneada> plano;
+    std::string patternLow = toLower(padrao);
+    NomesUnicos nomes;
+    for (uint32_t j = destino; j < ft.subtreeEnd[destino]; ++j) {
+        if (ft.kind[j] == FlatTree::FileNode) nomes.reservar(ft.name(ft.nameId[j]));
+    }
+    perfil::nos((ft.subtreeEnd[destino] - destino) + (ft.subtreeEnd[origem] - origem));
+    for (uint32_t j = origem; j < ft.subtreeEnd[origem]; ++j) {
+        if (prog && ((j - origem) & 4095) == 0) {
+            if (prog->cancelado()) return {};
+            prog->entradas.store(j - origem, std::memory_order_relaxed);
+        }
+        if (ft.kind[j] != FlatTree::FileNode) continue;
+        const std::string &name = ft.name(ft.nameId[j]);
+        if (toLower(name).find(patternLow) == std::string::npos) continue;
+
+        std::string destName = nomes.atribuir(name);
+        if (prog) prog->bytes.fetch_add(ft.sizes[j], std::memory_order_relaxed);
+        plano.push_back({destName, static_cast<size_t>(ft.sizes[j]), ft.dateText(j)});
+    }
+    return plano;
+}
+
+void SistemaFicheiros::AplicarCopia(Directory &destino, const std::vector<CopiaPlaneada> &plano) {
+    perfil::Medida medida("SistemaFicheiros::AplicarCopia");
+    Lote lote;
+    for (const auto &c : plano) lote.adicionarFicheiro(destino, c.nome, c.tamanho, c.data);
+    lote.aplicar();
+}
@@ -11,8 +11,18 @@
 #include <queue>
 #include <stack>
 #include <functional>
+#include <string_view>
 #include "Directory.hpp"
 #include "File.hpp"
+#include "PathResolver.hpp"
+#include "FlatTree.hpp"
+#include "SnapshotStore.hpp"
+#include "Tarefas.hpp"
+#include "Espelho.hpp"
+#include "Ocupacao.hpp"
+#include "Diferencas.hpp"
+#include "RegrasIgnorar.hpp"
+#include "CacheVarrimento.hpp"
 
 /**
  * @class SistemaFicheiros
@@ -21,8 +31,46 @@
 class SistemaFicheiros {
 private:
     std::shared_ptr<Directory> root;
+    // Cache de caminhos e índice de nomes partilhados por todas as operações.
+    mutable PathResolver resolver;
+    // Separador usado ao materializar caminhos e buffer reutilizado para o fazer.
+    char separator;
+    mutable std::string pathBuf;
+    // Versões congeladas publicadas (leitores concorrentes) e as versões da árvore na última publicação.
+    SnapshotStore snapshots;
+    const Directory* frozenRoot;
+    unsigned long long frozenDirVersion;
+    unsigned long long frozenFileVersion;
+    // Pasta do disco de onde veio a raiz (para espelhar cópias e movimentos).
+    Espelho espelho;
+    const Directory* raizDisco;
+    std::string caminhoDisco;
+    // Regras aplicadas pelo Load e contagens do último varrimento.
+    RegrasIgnorar regrasIgnorar;
 
 public:
+    /** @brief Contagens de um varrimento do disco. */
+    struct Varrimento {
+        uint64_t diretorias = 0;          ///< Diretorias lidas.
+        uint64_t listagens = 0;           ///< Diretorias listadas (a pasta e as subdiretorias percorridas).
+        uint64_t diretoriasReutilizadas = 0; ///< Listagens que vieram da cache, sem abrir a diretoria.
+        uint64_t ficheiros = 0;           ///< Ficheiros lidos.
+        uint64_t diretoriasIgnoradas = 0; ///< Diretorias ignoradas (não percorridas: o conteúdo não é contado).
+        uint64_t ficheirosIgnorados = 0;  ///< Ficheiros ignorados.
+        uint64_t bytesIgnorados = 0;      ///< Bytes dos ficheiros ignorados.
+        uint64_t ligacoesRepetidas = 0;   ///< Ficheiros que são outra ligação física a um inode já lido.
+        uint64_t bytesRepetidos = 0;      ///< Bytes dessas ligações (contados nos aparentes, não nos únicos).
+        size_t regras = 0;                ///< Regras aplicadas (incluindo as do .gitignore da pasta).
+    };
+
+    /** @brief Bytes de uma subárvore contando cada inode uma ou mais vezes. */
+    struct BytesInodes {
+        uint64_t aparentes = 0;  ///< Soma dos tamanhos de todas as entradas (como Memoria).
+        uint64_t unicos = 0;     ///< Cada (dispositivo, inode) conta uma vez.
+        uint64_t ligacoesRepetidas = 0; ///< Entradas cujo inode já tinha sido contado.
+        uint64_t semInode = 0;   ///< Entradas sem identidade no disco (criadas em memória ou lidas de XML).
+    };
+
     /** @brief Construtor padrão. */
     SistemaFicheiros();
     /** @briefLiberta a raiz ao limpar o sistema. */
@@ -32,8 +80,50 @@ public:
     // Gestão do sistema
     /** @brief Limpa o sistema (desfaz referência à raiz). */
     void clearSystem();
-    /** @brief Carrega a árvore a partir de uma pasta real do disco. */
-    bool Load(const std::string& pathStr);
+    /**
+     * @brief Carrega a árvore a partir de uma pasta real do disco.
+     * @param cache Listagens de um varrimento anterior (reutilizadas nas diretorias que não mudaram);
+     *        fica com as deste varrimento.
+     */
+    bool Load(const std::string& pathStr, Varrimento* contas = nullptr, CacheVarrimento* cache = nullptr);
+    /**
+     * @brief Constrói a árvore de uma pasta do disco sem alterar o sistema (usado por Load).
+     * @param prog Progresso opcional (entradas lidas, bytes dos ficheiros) e pedido de cancelamento.
+     * @param regras Regras a aplicar (nullptr = RegrasIgnorar::predefinidas()); as do
+     *        .gitignore na raiz da pasta, se existir, são acrescentadas depois delas.
+     * @param contas Contagens opcionais do que foi lido e ignorado.
+     * @param cache Cache de listagens opcional (ver Load).
+     * @return A raiz nova, ou nullptr se a pasta não existir ou a operação for cancelada.
+     */
+    static std::shared_ptr<Directory> CarregarArvore(const std::string& pathStr, Progresso* prog = nullptr,
+                                                     const RegrasIgnorar* regras = nullptr, Varrimento* contas = nullptr,
+                                                     CacheVarrimento* cache = nullptr);
+    /** @brief Regras usadas pelo Load (começam nas predefinidas). */
+    RegrasIgnorar& GetRegrasIgnorar() { return regrasIgnorar; }
+
+    // ----------------------------------------
+    // Árvore congelada (consultas só de leitura sobre arrays contíguos)
+    /**
+     * @brief Compacta a árvore atual numa FlatTree.
+     * @details Enquanto a árvore não for alterada, as consultas só de leitura
+     *          (contagens, tamanhos, maior, pesquisa, tree, duplicados) usam-na.
+     * @return Número de nós congelados.
+     */
+    size_t Congelar();
+    /** @brief Descarta a cópia congelada. */
+    void Descongelar();
+    /** @brief Cópia congelada, se existir e ainda corresponder à árvore (senão nullptr). */
+    const FlatTree* frozenView() const;
+    /**
+     * @brief Fixa a última versão publicada por Congelar, para ler noutra thread.
+     * @details A versão fixada nunca muda nem é libertada enquanto o Pin existir,
+     *          mesmo que a árvore seja alterada e volte a ser congelada entretanto.
+     */
+    SnapshotStore::Pin Snapshot() const;
+    /** @brief Número da última versão publicada (0 se nunca foi congelada). */
+    uint64_t VersaoPublicada() const;
+    /** @brief Liberta o que já for possível e devolve as versões que ainda esperam por leitores antigos. */
+    size_t VersoesRetidas();
 
     // ----------------------------------------
     // Contagens e memória
@@ -43,6 +133,29 @@ public:
     int ContarDirectorios() const;
     /** @brief Soma do tamanho de todos os ficheiros. */
     int Memoria() const;
+    /** @brief Tamanho recursivo de uma diretoria (usa a cópia congelada se existir). */
+    uint64_t TamanhoTotal(const Directory* dir) const;
+    /**
+     * @brief Bytes aparentes e únicos de uma subárvore, sem reler o disco.
+     * @details As ligações físicas lidas pelo Load partilham os dados e o inode;
+     *          as entradas sem inode contam sempre. As cópias em memória (cpdir)
+     *          partilham os dados do original e contam, por isso, como o mesmo inode.
+     */
+    BytesInodes ContarBytesUnicos(const Directory* dir) const;
+    /**
+     * @brief Histograma dos tamanhos dos ficheiros por faixas.
+     * @param limites Limites crescentes; devolve limites.size() + 1 contagens.
+     */
+    std::vector<uint64_t> HistogramaTamanhos(const std::vector<uint64_t>& limites) const;
+    /** @brief Número de ficheiros com data (AAAAMMDD) entre de e ate, inclusive. */
+    size_t ContarPorData(int32_t de, int32_t ate) const;
+    /** @brief Memória ocupada pela árvore (por categoria) e pelos índices (caches, versões congeladas). */
+    Ocupacao::Relatorio InfoMemoria() const;
+    /**
+     * @brief Ajusta vetores e nomes ao conteúdo e liberta caches e versões já sem leitores.
+     * @details Útil depois de remoções em massa (RemoverAll): as listas não encolhem sozinhas.
+     */
+    Ocupacao::Compactacao Compactar();
 
     // ----------------------------------------
     // Diretórios
@@ -66,15 +179,52 @@ public:
     void SetRoot(std::shared_ptr<Directory> r);
     /** @brief Obtém a raiz atual. */
     std::shared_ptr<Directory> GetRoot() const;
+    /**
+     * @brief Resolve um caminho ("a\\b" ou "a/b") ou um nome simples para a diretoria.
+     * @details Nomes simples devolvem a primeira diretoria com esse nome (em largura).
+     */
+    std::shared_ptr<Directory> resolvePath(std::string_view path) const;
+    /** @brief Define o separador usado nos caminhos devolvidos (por omissão o do sistema). */
+    void SetSeparador(char sep);
+    /** @brief Obtém o separador usado nos caminhos devolvidos. */
+    char GetSeparador() const;
+    /** @brief Materializa o caminho de um nó (relativo a base, se indicada). */
+    std::string RenderPath(const NodeRef& ref, const Directory* base = nullptr) const;
 
     // ----------------------------------------
     // Operações sobre ficheiros / diretórios
+    /** @brief Cria a subdiretoria nome em pai (e acrescenta-a ao índice de nomes). */
+    void CriarDirectoria(Directory &pai, const std::string &nome);
     /** @brief Remove ficheiros/diretorias com nome alvo em toda a árvore. */
     bool RemoverAll(const std::string &s, const std::string &tipo);
+    /** @brief Remove todas as diretorias ("DIR") ou todos os ficheiros ("FILE") da árvore. */
+    bool RemoverTodos(const std::string &tipo);
     /** @brief Move um ficheiro para outra diretoria. */
     bool MoveFicheiro(const std::string &Fich, const std::string &DirNova);
     /** @brief Move uma diretoria (com subárvore) para outra diretoria. */
     bool MoverDirectoria(const std::string &DirOld, const std::string &DirNew);
+    /**
+     * @brief Copia uma diretoria (com subárvore) para dentro de outra.
+     * @details A cópia custa O(diretorias): as listas de ficheiros ficam partilhadas
+     * até um dos lados as alterar (ver Directory::clone).
+     * @return false se a origem ou o destino não existirem, ou se o destino já tiver
+     * uma subdiretoria com o nome da origem.
+     */
+    bool CopiarDirectoria(const std::string &DirOrigem, const std::string &DirDestino);
+
+    // ----------------------------------------
+    // Espelho no disco
+    /**
+     * @brief Indica que raiz foi lida da pasta caminho (Load já o faz).
+     * @details Com o espelho em "aplicar", CopyBatch, MoveFicheiro, MoverDirectoria e
+     * CopiarDirectoria repetem no disco o que fizeram em memória; em "simular" só
+     * mostram o plano, sem alterar o disco nem a árvore.
+     */
+    void SetOrigemDisco(const Directory* raiz, const std::string &caminho);
+    /** @brief Pasta do disco da raiz atual (vazio se a árvore não veio do disco). */
+    std::string GetOrigemDisco() const;
+    /** @brief Modo e último relatório do espelho. */
+    Espelho& GetEspelho() { return espelho; }
     /** @brief Pesquisa por diretoria (1) ou ficheiro (0) e devolve o caminho. */
     std::optional<std::string> Search(const std::string &s, int Tipo) const;
 
@@ -84,11 +234,25 @@ public:
     void Escrever_XML(const std::string &s);
     /** @brief Importa a árvore a partir de XML. */
     bool Ler_XML(const std::string &s);
+    /**
+     * @brief Lê uma árvore de XML sem alterar o sistema (usado por Ler_XML e Comparar).
+     * @param raiz Recebe a raiz lida (nullptr se o ficheiro não tiver nenhuma diretoria).
+     * @return false se o ficheiro não puder ser aberto ou estiver mal formado.
+     */
+    static bool LerArvoreXml(const std::string &s, std::shared_ptr<Directory> &raiz);
+    /**
+     * @brief Compara duas versões gravadas em XML; "." designa a árvore atual.
+     * @details Os resumos da árvore atual ficam guardados entre comparações.
+     * @param erro Recebe o ficheiro que não foi possível ler (quando devolve false).
+     */
+    bool Comparar(const std::string &a, const std::string &b, Diferencas::Resultado &res, std::string &erro);
 
     // ----------------------------------------
     // Tree (imprime a arvore em consola ou grava para ficheiro)
     /** @brief Imprime a árvore ou grava num ficheiro se indicado. */
     void Tree(const std::string *fich = nullptr);
+    /** @brief Igual a Tree, mas sem ficheiro a árvore é escrita em out. */
+    void Tree(const std::string *fich, std::ostream &out);
 
     // ----------------------------------------
     // Pesquisar todas as diretorias com nome <dir> e colocar caminhos em <lres>
@@ -114,11 +278,43 @@ public:
     /** @brief Lista formatada dos ficheiros duplicados e respetivos caminhos. */
     std::vector<std::string> GetFicheirosDuplicados() const;
 
+    // ----------------------------------------
+    // Leituras sobre uma versão fixada (seguras fora da thread principal)
+    /** @brief Ficheiros duplicados de uma versão, no mesmo formato de GetFicheirosDuplicados. */
+    static std::vector<std::string> Duplicados(const FlatTree &ft, char sep, Progresso *prog = nullptr);
+    /**
+     * @brief Exporta uma versão em XML, com o mesmo conteúdo que Escrever_XML.
+     * @return false se não foi possível escrever ou se foi cancelada (o ficheiro parcial é apagado).
+     */
+    static bool EscreverXml(const FlatTree &ft, const std::string &s, Progresso *prog = nullptr);
+
+    /** @brief Ficheiro a criar no destino de um CopyBatch planeado. */
+    struct CopiaPlaneada {
+        std::string nome;
+        size_t tamanho;
+        std::string data;
+    };
+    /**
+     * @brief Planeia um CopyBatch sobre uma versão fixada (mesmos nomes únicos que CopyBatch).
+     * @param origem Índice da diretoria de origem em ft.
+     * @param destino Índice da diretoria de destino em ft.
+     */
+    static std::vector<CopiaPlaneada> PlanearCopyBatch(const FlatTree &ft, uint32_t origem, uint32_t destino,
+                                                       const std::string &padrao, Progresso *prog = nullptr);
+    /** @brief Cria no destino os ficheiros planeados. */
+    static void AplicarCopia(Directory &destino, const std::vector<CopiaPlaneada> &plano);
+
 private:
     // ----------------------------------------
     // Funções auxiliares
     /** @brief Constrói o caminho absoluto de uma diretoria. */
-    std::string getAbsolutePath(Directory* dir) const;
+    std::string getAbsolutePath(const Directory* dir) const;
+    /** @brief Indica se as alterações devem gerar um plano para o disco. */
+    bool espelhoAtivo() const;
+    /** @brief Em modo simular regista o plano e devolve true (a operação não deve alterar nada). */
+    bool soSimular(std::vector<Espelho::Operacao> &plano);
+    /** @brief Caminho no disco de uma diretoria da árvore (requer espelhoAtivo()). */
+    std::string caminhoNoDisco(const Directory* dir) const;
 
     /** @brief Preenche uma lista com todas as diretorias da subárvore. */
     void getAllDirectories(std::shared_ptr<Directory> dir, std::list<std::shared_ptr<Directory>>& dirs) const;
@@ -0,0 +1,121 @@
+#include "SnapshotStore.hpp"
+#include <thread>
+
+// ----------------------------------------
+// Pin
+SnapshotStore::Pin::Pin(Pin&& other) noexcept
+    : store(other.store), slot(other.slot), tree(other.tree), ver(other.ver) {
+    other.store = nullptr;
+    other.tree = nullptr;
+}
+
+SnapshotStore::Pin& SnapshotStore::Pin::operator=(Pin&& other) noexcept {
+    if (this != &other) {
+        release();
+        store = other.store; slot = other.slot; tree = other.tree; ver = other.ver;
+        other.store = nullptr;
+        other.tree = nullptr;
+    }
+    return *this;
+}
+
+SnapshotStore::Pin::~Pin() {
+    release();
+}
+
+void SnapshotStore::Pin::release() {
+    if (!store) return;
+    store->slots[slot].epoch.store(0);
+    store->slots[slot].used.store(false, std::memory_order_release);
+    store = nullptr;
+    tree = nullptr;
+}
+
+// ----------------------------------------
+// SnapshotStore
+SnapshotStore::SnapshotStore() {}
+
+SnapshotStore::~SnapshotStore() {
+    delete head.load();
+    for (auto& r : retired) delete r.second;
+}
+
+SnapshotStore::Pin SnapshotStore::pin() const {
+    Pin p;
+    // Reserva uma posição livre (só espera se houver mais de kMaxReaders leitores ao mesmo tempo).
+    size_t i = 0;
+    for (;; i = (i + 1) % kMaxReaders) {
+        bool expected = false;
+        if (!slots[i].used.load(std::memory_order_relaxed) &&
+            slots[i].used.compare_exchange_strong(expected, true, std::memory_order_acquire)) break;
+        if (i == kMaxReaders - 1) std::this_thread::yield();
+    }
+    // Anuncia a época antes de ler o ponteiro: um escritor que veja este anúncio
+    // não liberta nada que tenha sido retirado a partir desta época.
+    slots[i].epoch.store(globalEpoch.load());
+    p.store = this;
+    p.slot = i;
+    p.tree = head.load();
+    p.ver = p.tree ? p.tree->version : 0;
+    return p;
+}
+
+const FlatTree* SnapshotStore::current() const {
+    return head.load(std::memory_order_acquire);
+}
+
+uint64_t SnapshotStore::currentVersion() const {
+    return ver.load();
+}
+
+uint64_t SnapshotStore::publish(std::unique_ptr<FlatTree> tree) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    uint64_t v = ver.load() + 1;
+    if (tree) tree->version = v;
+    const FlatTree* old = head.exchange(tree.release());
+    ver.store(v);
+    // A versão antiga fica retirada na época atual; a época avança para os próximos leitores.
+    uint64_t e = globalEpoch.fetch_add(1);
+    if (old) retired.emplace_back(e, old);
+    reclaimLocked();
+    return v;
+}
+
+size_t SnapshotStore::reclaim() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return reclaimLocked();
+}
+
+size_t SnapshotStore::reclaimLocked() {
+    // A menor época anunciada por um leitor ativo limita o que pode ser libertado.
+    uint64_t minActive = UINT64_MAX;
+    for (const auto& s : slots) {
+        uint64_t e = s.epoch.load();
+        if (e != 0 && e < minActive) minActive = e;
+    }
+    size_t freed = 0;
+    for (size_t k = 0; k < retired.size();) {
+        if (retired[k].first < minActive) {
+            delete retired[k].second;
+            retired[k] = retired.back();
+            retired.pop_back();
+            ++freed;
+        } else {
+            ++k;
+        }
+    }
+    return freed;
+}
+
+size_t SnapshotStore::retiredCount() const {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return retired.size();
+}
+
+size_t SnapshotStore::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    size_t b = 0;
+    if (const FlatTree* t = head.load(std::memory_order_acquire)) b += t->memoryBytes();
+    for (const auto& r : retired) b += r.second->memoryBytes();
+    return b;
+}
@@ -0,0 +1,107 @@
+#ifndef SNAPSHOTSTORE_HPP
+#define SNAPSHOTSTORE_HPP
+
+/**
+ * @file SnapshotStore.hpp
+ * @brief Declara a classe SnapshotStore (versões imutáveis da árvore com reclamação por épocas).
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "FlatTree.hpp"
+
+/**
+ * @class SnapshotStore
+ * @brief Publica versões imutáveis (FlatTree) da árvore para leitores concorrentes.
+ *
+ * O escritor publica uma nova versão com uma troca atómica do ponteiro atual.
+ * Cada leitor fixa a época global antes de ler o ponteiro e vê sempre uma
+ * versão consistente, sem locks. As versões substituídas ficam "retiradas" e
+ * só são libertadas quando nenhum leitor ativo tem uma época anterior à troca.
+ */
+class SnapshotStore {
+public:
+    /**
+     * @class Pin
+     * @brief Leitura fixada numa versão; a versão não é libertada enquanto o Pin existir.
+     */
+    class Pin {
+    public:
+        Pin() = default;
+        Pin(Pin&& other) noexcept;
+        Pin& operator=(Pin&& other) noexcept;
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        ~Pin();
+
+        /** @brief Versão fixada (nullptr se ainda não foi publicada nenhuma). */
+        const FlatTree* get() const { return tree; }
+        const FlatTree& operator*() const { return *tree; }
+        const FlatTree* operator->() const { return tree; }
+        explicit operator bool() const { return tree != nullptr; }
+        /** @brief Número da versão fixada (0 se vazia). */
+        uint64_t version() const { return ver; }
+
+    private:
+        friend class SnapshotStore;
+        void release();
+
+        const SnapshotStore* store = nullptr;
+        size_t slot = 0;
+        const FlatTree* tree = nullptr;
+        uint64_t ver = 0;
+    };
+
+    SnapshotStore();
+    /** @brief Liberta todas as versões (não pode haver leitores ativos). */
+    ~SnapshotStore();
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    /**
+     * @brief Publica uma nova versão (ou nenhuma, se tree for nullptr).
+     * @return Número da nova versão.
+     */
+    uint64_t publish(std::unique_ptr<FlatTree> tree);
+    /** @brief Fixa a versão atual para leitura (sem locks). */
+    Pin pin() const;
+    /**
+     * @brief Versão atual sem a fixar.
+     * @details Só é seguro na thread que publica (nenhuma outra a pode libertar).
+     */
+    const FlatTree* current() const;
+    /** @brief Número da versão atual. */
+    uint64_t currentVersion() const;
+    /** @brief Liberta as versões retiradas que já nenhum leitor pode estar a usar. */
+    size_t reclaim();
+    /** @brief Versões retiradas ainda à espera de leitores antigos. */
+    size_t retiredCount() const;
+    /** @brief Memória da versão atual e das retiradas (bytes, ver FlatTree::memoryBytes). */
+    size_t memoryBytes() const;
+
+private:
+    static constexpr size_t kMaxReaders = 64;
+
+    // Uma posição por leitor ativo, em linhas de cache separadas.
+    struct alignas(64) Slot {
+        std::atomic<bool> used{false};
+        std::atomic<uint64_t> epoch{0}; // 0 = sem leitura em curso
+    };
+
+    size_t reclaimLocked();
+
+    mutable Slot slots[kMaxReaders];
+    std::atomic<const FlatTree*> head{nullptr};
+    std::atomic<uint64_t> globalEpoch{1};
+    std::atomic<uint64_t> ver{0};
+
+    // Os escritores são serializados entre si; os leitores nunca tocam neste mutex.
+    mutable std::mutex writerMutex;
+    std::vector<std::pair<uint64_t, const FlatTree*>> retired;
+};
+
+#endif // SNAPSHOTSTORE_HPP
@@ -0,0 +1,145 @@
+#include "Tarefas.hpp"
+#include <exception>
+
+// ----------------------------------------
+// Tarefa
+Tarefa::Tarefa(int id, std::string descricao, Trabalho trabalho)
+    : id(id), descricao(std::move(descricao)), trabalho(std::move(trabalho)),
+      inicio(std::chrono::steady_clock::now()), fim(inicio) {}
+
+double Tarefa::segundos() const {
+    Estado e = estado();
+    auto ate = (e == Estado::EmEspera || e == Estado::EmCurso) ? std::chrono::steady_clock::now() : fim;
+    return std::chrono::duration<double>(ate - inicio).count();
+}
+
+const char* Tarefa::nomeEstado(Estado e) {
+    switch (e) {
+        case Estado::EmEspera: return "em espera";
+        case Estado::EmCurso: return "em curso";
+        case Estado::Concluida: return "concluida";
+        case Estado::Cancelada: return "cancelada";
+        case Estado::Falhou: return "falhou";
+    }
+    return "?";
+}
+
+// ----------------------------------------
+// Executor
+Executor::Executor(size_t n) {
+    if (n == 0) n = 1;
+    for (size_t i = 0; i < n; ++i) threads.emplace_back(&Executor::ciclo, this);
+}
+
+Executor::~Executor() {
+    cancelarTodas();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        aParar = true;
+    }
+    haTrabalho.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+std::shared_ptr<Tarefa> Executor::submeter(std::string descricao, Tarefa::Trabalho trabalho) {
+    std::shared_ptr<Tarefa> t;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        t = std::make_shared<Tarefa>(proximoId++, std::move(descricao), std::move(trabalho));
+        fila.push_back(t);
+        todas.push_back(t);
+    }
+    haTrabalho.notify_one();
+    return t;
+}
+
+bool Executor::cancelar(int id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& t : todas) {
+        if (t->id != id) continue;
+        Tarefa::Estado e = t->estado();
+        if (e != Tarefa::Estado::EmEspera && e != Tarefa::Estado::EmCurso) return false;
+        t->progresso.cancelar = true;
+        return true;
+    }
+    return false;
+}
+
+void Executor::cancelarTodas() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& t : todas) t->progresso.cancelar = true;
+}
+
+std::vector<std::shared_ptr<Tarefa>> Executor::listar() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return todas;
+}
+
+std::vector<std::shared_ptr<Tarefa>> Executor::recolher() {
+    std::vector<std::shared_ptr<Tarefa>> prontas;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<std::shared_ptr<Tarefa>> restantes;
+        for (auto& t : todas) {
+            Tarefa::Estado e = t->estado();
+            if (e == Tarefa::Estado::EmEspera || e == Tarefa::Estado::EmCurso) restantes.push_back(t);
+            else prontas.push_back(t);
+        }
+        todas.swap(restantes);
+    }
+    // Fora do lock: o resultado pode ser demorado e não deve atrasar as threads.
+    for (auto& t : prontas) {
+        if (t->estado() == Tarefa::Estado::Concluida && t->aplicar) t->aplicar();
+        t->aplicar = nullptr;
+    }
+    return prontas;
+}
+
+void Executor::esperar() {
+    std::unique_lock<std::mutex> lock(mtx);
+    terminou.wait(lock, [this] { return fila.empty() && emCurso == 0; });
+}
+
+size_t Executor::ativas() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return fila.size() + emCurso;
+}
+
+void Executor::ciclo() {
+    for (;;) {
+        std::shared_ptr<Tarefa> t;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            haTrabalho.wait(lock, [this] { return aParar || !fila.empty(); });
+            if (fila.empty()) return; // aParar e nada por fazer
+            t = fila.front();
+            fila.pop_front();
+            ++emCurso;
+        }
+
+        Tarefa::Estado final = Tarefa::Estado::Cancelada;
+        if (!t->progresso.cancelado()) {
+            t->est.store(Tarefa::Estado::EmCurso, std::memory_order_release);
+            try {
+                t->trabalho(*t);
+                final = t->progresso.cancelado() ? Tarefa::Estado::Cancelada : Tarefa::Estado::Concluida;
+            } catch (const std::exception& e) {
+                t->mensagem = e.what();
+                final = Tarefa::Estado::Falhou;
+            } catch (...) {
+                t->mensagem = "erro desconhecido";
+                final = Tarefa::Estado::Falhou;
+            }
+        }
+        t->trabalho = nullptr;
+        t->fim = std::chrono::steady_clock::now();
+        // A libertação publica mensagem/aplicar para quem vir o estado final.
+        t->est.store(final, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --emCurso;
+        }
+        terminou.notify_all();
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef TAREFAS_HPP
+#define TAREFAS_HPP
+
+/**
+ * @file Tarefas.hpp
+ * @brief Declara Progresso, Tarefa e Executor (operações longas em segundo plano).
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct Progresso
+ * @brief Contadores de progresso e pedido de cancelamento partilhados com uma operação longa.
+ *
+ * A operação incrementa os contadores e consulta cancelado() de vez em quando;
+ * se for cancelada, pára no ponto seguinte e devolve um resultado vazio.
+ */
+struct Progresso {
+    std::atomic<uint64_t> entradas{0}; ///< Nós / entradas processados.
+    std::atomic<uint64_t> bytes{0};    ///< Bytes lidos ou escritos.
+    std::atomic<bool> cancelar{false}; ///< Pedido de cancelamento.
+
+    bool cancelado() const { return cancelar.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @class Tarefa
+ * @brief Uma operação submetida ao Executor.
+ */
+class Tarefa {
+public:
+    /** @brief Estado da tarefa. */
+    enum class Estado { EmEspera, EmCurso, Concluida, Cancelada, Falhou };
+
+    /** @brief Trabalho feito numa thread do executor. */
+    using Trabalho = std::function<void(Tarefa&)>;
+
+    Tarefa(int id, std::string descricao, Trabalho trabalho);
+
+    const int id;
+    const std::string descricao;
+    Progresso progresso;
+
+    Estado estado() const { return est.load(std::memory_order_acquire); }
+    /** @brief Segundos desde a submissão (ou até terminar). */
+    double segundos() const;
+    /** @brief Texto do estado ("em curso", "concluida", ...). */
+    static const char* nomeEstado(Estado e);
+
+    /**
+     * @brief Resultado a aplicar na thread principal (definido pelo trabalho).
+     * @details Só é executado se a tarefa terminar sem cancelamento nem erro.
+     */
+    std::function<void()> aplicar;
+    /** @brief Mensagem final (resumo do resultado ou erro). */
+    std::string mensagem;
+
+private:
+    friend class Executor;
+
+    Trabalho trabalho;
+    std::atomic<Estado> est{Estado::EmEspera};
+    std::chrono::steady_clock::time_point inicio, fim;
+};
+
+/**
+ * @class Executor
+ * @brief Conjunto fixo de threads que corre tarefas por ordem de submissão.
+ *
+ * Os trabalhos nunca tocam na árvore da thread principal: leem uma versão
+ * fixada ou constroem estruturas novas. O resultado é aplicado pela thread
+ * principal em recolher(), entre dois comandos.
+ */
+class Executor {
+public:
+    explicit Executor(size_t threads = 2);
+    /** @brief Cancela o que falta e espera pelas threads. */
+    ~Executor();
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /** @brief Acrescenta uma tarefa à fila. */
+    std::shared_ptr<Tarefa> submeter(std::string descricao, Tarefa::Trabalho trabalho);
+    /** @brief Pede o cancelamento (cooperativo) de uma tarefa; false se não existir ou já tiver terminado. */
+    bool cancelar(int id);
+    /** @brief Pede o cancelamento de todas as tarefas por terminar. */
+    void cancelarTodas();
+    /** @brief Tarefas ainda não recolhidas (em espera, em curso ou terminadas). */
+    std::vector<std::shared_ptr<Tarefa>> listar() const;
+    /**
+     * @brief Retira as tarefas terminadas e executa, nesta thread, o resultado das concluídas.
+     * @return As tarefas retiradas, pela ordem em que foram submetidas.
+     */
+    std::vector<std::shared_ptr<Tarefa>> recolher();
+    /** @brief Bloqueia até não haver tarefas em espera nem em curso. */
+    void esperar();
+    /** @brief Número de tarefas em espera ou em curso. */
+    size_t ativas() const;
+
+private:
+    void ciclo();
+
+    mutable std::mutex mtx;
+    std::condition_variable haTrabalho;
+    std::condition_variable terminou;
+    std::deque<std::shared_ptr<Tarefa>> fila;
+    std::vector<std::shared_ptr<Tarefa>> todas;
+    std::vector<std::thread> threads;
+    size_t emCurso = 0;
+    int proximoId = 1;
+    bool aParar = false;
+};
+
+#endif // TAREFAS_HPP